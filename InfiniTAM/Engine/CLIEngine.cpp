@@ -5,6 +5,7 @@
 #include <string.h>
 
 #include "../Utils/FileUtils.h"
+#include "../ITMLib/Utils/ITMProfiler.h"
 
 using namespace InfiniTAM::Engine;
 CLIEngine* CLIEngine::instance;
@@ -74,6 +75,8 @@ void CLIEngine::Run()
 	while (true) {
 		if (!ProcessFrame()) break;
 	}
+
+	if (ITMProfiler::IsEnabled()) ITMProfiler::PrintStatistics(stdout);
 }
 
 void CLIEngine::Shutdown()
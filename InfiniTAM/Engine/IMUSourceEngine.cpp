@@ -3,6 +3,7 @@
 #include "IMUSourceEngine.h"
 
 #include "../Utils/FileUtils.h"
+#include "../ITMLib/Utils/ITMProfiler.h"
 
 #include <stdio.h>
 
@@ -18,8 +19,19 @@ IMUSourceEngine::IMUSourceEngine(const char *imuMask)
 	cached_imu = NULL;
 }
 
+IMUSourceEngine::IMUSourceEngine(void)
+{
+	imuMask[0] = 0;
+
+	currentFrameNo = 0;
+	cachedFrameNo = -1;
+
+	cached_imu = NULL;
+}
+
 void IMUSourceEngine::loadIMUIntoCache(void)
 {
+	ITMProfiler::ScopedTraceEvent trace("read_imu", "io");
 	char str[2048]; FILE *f; bool success = false;
 
 	cached_imu = new ITMIMUMeasurement();
@@ -67,3 +79,15 @@ void IMUSourceEngine::getMeasurement(ITMIMUMeasurement *imu)
 
 	++currentFrameNo;
 }
+
+void FrameIMUSource::setMeasurement(const ITMIMUMeasurement *imu)
+{
+	available = (imu != NULL);
+	if (available) current.SetFrom(imu);
+}
+
+void FrameIMUSource::getMeasurement(ITMIMUMeasurement *imu)
+{
+	imu->SetFrom(&current);
+	available = false;
+}
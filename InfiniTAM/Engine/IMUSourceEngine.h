@@ -20,11 +20,39 @@ namespace InfiniTAM
 			int cachedFrameNo;
 			int currentFrameNo;
 
+		protected:
+			IMUSourceEngine(void);
+
 		public:
 			IMUSourceEngine(const char *imuMask);
-			~IMUSourceEngine() { }
+			virtual ~IMUSourceEngine() { }
+
+			virtual bool hasMoreMeasurements(void);
+			virtual void getMeasurement(ITMIMUMeasurement *imu);
+		};
+
+		/** \brief
+		    Delivers the IMU measurement of the frame an image source
+		    has just returned, for image sources that read the
+		    measurements along with the images.
+
+		    The image source sets the measurement with
+		    @ref setMeasurement() in its getImages(), and the
+		    measurement can be taken once with getMeasurement().
+		*/
+		class FrameIMUSource : public IMUSourceEngine
+		{
+		private:
+			ITMIMUMeasurement current;
+			bool available;
+
+		public:
+			FrameIMUSource(void) : available(false) { }
+
+			/// Sets the measurement of the current frame, NULL if the frame has none
+			void setMeasurement(const ITMIMUMeasurement *imu);
 
-			bool hasMoreMeasurements(void);
+			bool hasMoreMeasurements(void) { return available; }
 			void getMeasurement(ITMIMUMeasurement *imu);
 		};
 	}
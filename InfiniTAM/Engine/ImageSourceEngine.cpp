@@ -3,6 +3,7 @@
 #include "ImageSourceEngine.h"
 
 #include "../Utils/FileUtils.h"
+#include "../ITMLib/Utils/ITMProfiler.h"
 
 #include <stdio.h>
 
@@ -13,6 +14,11 @@ ImageSourceEngine::ImageSourceEngine(const char *calibFilename)
 	readRGBDCalib(calibFilename, calib);
 }
 
+ImageSourceEngine::ImageSourceEngine(const ITMRGBDCalib & calib)
+	: calib(calib)
+{
+}
+
 ImageFileReader::ImageFileReader(const char *calibFilename, const char *rgbImageMask, const char *depthImageMask)
 	: ImageSourceEngine(calibFilename)
 {
@@ -37,6 +43,8 @@ void ImageFileReader::loadIntoCache(void)
 	if (currentFrameNo == cachedFrameNo) return;
 	cachedFrameNo = currentFrameNo;
 
+	ITMProfiler::ScopedTraceEvent trace("read_images", "io");
+
 	//TODO> make nicer
 	cached_rgb = new ITMUChar4Image(true, false); 
 	cached_depth = new ITMShortImage(true, false);
@@ -81,6 +89,7 @@ void ImageFileReader::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
 	}
 
 	if (!bUsedCache) {
+		ITMProfiler::ScopedTraceEvent trace("read_images", "io");
 		char str[2048];
 
 		sprintf(str, rgbImageMask, currentFrameNo);
@@ -154,6 +163,8 @@ void RawFileReader::loadIntoCache(void)
 	if (currentFrameNo == cachedFrameNo) return;
 	cachedFrameNo = currentFrameNo;
 
+	ITMProfiler::ScopedTraceEvent trace("read_images", "io");
+
 	//TODO> make nicer
 	cached_rgb = new ITMUChar4Image(imgSize, MEMORYDEVICE_CPU);
 	cached_depth = new ITMShortImage(imgSize, MEMORYDEVICE_CPU);
@@ -14,6 +14,7 @@ namespace InfiniTAM
 			ITMRGBDCalib calib;
 
 			ImageSourceEngine(const char *calibFilename);
+			explicit ImageSourceEngine(const ITMRGBDCalib & calib);
 			virtual ~ImageSourceEngine() {}
 
 			virtual bool hasMoreImages(void) = 0;
@@ -0,0 +1,156 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "PrefetchingImageSource.h"
+
+#include "../ITMLib/Utils/ITMProfiler.h"
+#include "../ITMLib/Utils/ITMThreadAffinity.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace InfiniTAM::Engine;
+
+class PrefetchingImageSource::PrivateData {
+	public:
+	struct Slot {
+		ITMUChar4Image *rgb;
+		ITMShortImage *rawDepth;
+		ITMIMUMeasurement *imu;
+	};
+
+	ImageSourceEngine *source;
+	IMUSourceEngine *imuSource;
+
+	// ring buffer: slots [head, head + noFilled) hold frames that have not been consumed yet
+	std::vector<Slot> slots;
+	int head, noFilled;
+	bool endOfSource, stopRequested;
+
+	std::mutex mutex;
+	std::condition_variable slotFilled, slotFreed;
+	std::thread thread;
+};
+
+PrefetchingImageSource::PrefetchingImageSource(ImageSourceEngine *source, IMUSourceEngine *imuSource, int queueDepth)
+	: ImageSourceEngine(source->calib)
+{
+	if (queueDepth < 1) queueDepth = 1;
+
+	imgSize_rgb = source->getRGBImageSize();
+	imgSize_d = source->getDepthImageSize();
+
+	data = new PrivateData();
+	data->source = source;
+	data->imuSource = imuSource;
+	data->head = 0;
+	data->noFilled = 0;
+	data->endOfSource = false;
+	data->stopRequested = false;
+
+	data->slots.resize(queueDepth);
+	for (int i = 0; i < queueDepth; i++)
+	{
+		data->slots[i].rgb = new ITMUChar4Image(imgSize_rgb, true, false);
+		data->slots[i].rawDepth = new ITMShortImage(imgSize_d, true, false);
+		data->slots[i].imu = (imuSource != NULL) ? new ITMIMUMeasurement() : NULL;
+	}
+
+	prefetchedIMUSource = (imuSource != NULL) ? new FrameIMUSource() : NULL;
+
+	data->thread = std::thread(&PrefetchingImageSource::prefetchLoop, this);
+}
+
+PrefetchingImageSource::~PrefetchingImageSource()
+{
+	{
+		std::lock_guard<std::mutex> lock(data->mutex);
+		data->stopRequested = true;
+	}
+	data->slotFreed.notify_all();
+	data->thread.join();
+
+	for (size_t i = 0; i < data->slots.size(); i++)
+	{
+		delete data->slots[i].rgb;
+		delete data->slots[i].rawDepth;
+		if (data->slots[i].imu != NULL) delete data->slots[i].imu;
+	}
+
+	if (prefetchedIMUSource != NULL) delete prefetchedIMUSource;
+	delete data;
+}
+
+void PrefetchingImageSource::prefetchLoop(void)
+{
+	int queueDepth = (int)data->slots.size();
+	int tail = 0;
+
+	ITMProfiler::SetThreadName("prefetch");
+	ITMThreadAffinity::ReleaseCallingThread();
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(data->mutex);
+			while ((data->noFilled == queueDepth) && !data->stopRequested) data->slotFreed.wait(lock);
+			if (data->stopRequested) return;
+		}
+
+		// the slot at tail is not visible to the consumer until noFilled is increased
+		PrivateData::Slot & slot = data->slots[tail];
+		bool success = data->source->hasMoreImages();
+		if (success) data->source->getImages(slot.rgb, slot.rawDepth);
+
+		if (success && (data->imuSource != NULL))
+		{
+			success = data->imuSource->hasMoreMeasurements();
+			if (success) data->imuSource->getMeasurement(slot.imu);
+		}
+
+		std::lock_guard<std::mutex> lock(data->mutex);
+		if (success)
+		{
+			data->noFilled++;
+			tail = (tail + 1) % queueDepth;
+		}
+		else data->endOfSource = true;
+		data->slotFilled.notify_all();
+
+		if (!success) return;
+	}
+}
+
+bool PrefetchingImageSource::hasMoreImages(void)
+{
+	ITMProfiler::ScopedTraceEvent trace("wait_for_frame", "io");
+	std::unique_lock<std::mutex> lock(data->mutex);
+	while ((data->noFilled == 0) && !data->endOfSource) data->slotFilled.wait(lock);
+
+	return data->noFilled > 0;
+}
+
+void PrefetchingImageSource::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
+{
+	if (!hasMoreImages()) return;
+
+	PrivateData::Slot & slot = data->slots[data->head];
+
+	rgb->ChangeDims(slot.rgb->noDims);
+	rgb->SetFrom(slot.rgb, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
+	rawDepth->ChangeDims(slot.rawDepth->noDims);
+	rawDepth->SetFrom(slot.rawDepth, ORUtils::MemoryBlock<short>::CPU_TO_CPU);
+
+	if (prefetchedIMUSource != NULL) prefetchedIMUSource->setMeasurement(slot.imu);
+
+	std::lock_guard<std::mutex> lock(data->mutex);
+	data->head = (data->head + 1) % (int)data->slots.size();
+	data->noFilled--;
+	data->slotFreed.notify_all();
+}
+
+IMUSourceEngine *PrefetchingImageSource::getIMUSource(void)
+{
+	return prefetchedIMUSource;
+}
@@ -0,0 +1,51 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "ImageSourceEngine.h"
+#include "IMUSourceEngine.h"
+
+namespace InfiniTAM
+{
+	namespace Engine
+	{
+		/** \brief
+		    Reads frames from another image source (and optionally an
+		    IMU source) on a background thread, so that file access and
+		    image decoding overlap with the processing of earlier frames.
+
+		    Frames are loaded into a ring of @p queueDepth preallocated
+		    buffers. Once the ring is full, the background thread waits
+		    until @ref getImages() has consumed a frame. The wrapped
+		    sources must not be used by anyone else while the prefetcher
+		    exists, and they are not deleted by it.
+
+		    If an IMU source is given, the prefetched measurements are
+		    delivered through the source returned by @ref getIMUSource().
+		*/
+		class PrefetchingImageSource : public ImageSourceEngine
+		{
+		private:
+			class PrivateData;
+			PrivateData *data;
+
+			FrameIMUSource *prefetchedIMUSource;
+
+			Vector2i imgSize_rgb, imgSize_d;
+
+			void prefetchLoop(void);
+
+		public:
+			PrefetchingImageSource(ImageSourceEngine *source, IMUSourceEngine *imuSource = NULL, int queueDepth = 4);
+			~PrefetchingImageSource();
+
+			bool hasMoreImages(void);
+			void getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
+			Vector2i getDepthImageSize(void) { return imgSize_d; }
+			Vector2i getRGBImageSize(void) { return imgSize_rgb; }
+
+			/// Source of the IMU measurements belonging to the frames returned by getImages(), or NULL without IMU
+			IMUSourceEngine *getIMUSource(void);
+		};
+	}
+}
@@ -0,0 +1,545 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "SequenceFile.h"
+
+#include "../Utils/DepthCodec.h"
+#include "../ITMLib/Utils/ITMProfiler.h"
+#include "../ITMLib/Utils/ITMWorkerThread.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace InfiniTAM::Engine;
+
+namespace {
+
+static const char SEQUENCE_MAGIC[8] = { 'I', 'T', 'M', 'S', 'E', 'Q', '\r', '\n' };
+static const uint32_t SEQUENCE_VERSION = 1;
+static const uint32_t SEQUENCE_FLAG_IMU = 1;
+
+// payloads are padded so that every frame starts on an aligned address in the mapping
+static const uint64_t PAYLOAD_ALIGNMENT = 16;
+
+enum PayloadCodec
+{
+	/// 8 bit RGB triplets, the alpha channel is not stored
+	CODEC_RGB24 = 0,
+	/// uncompressed 16 bit depth values
+	CODEC_DEPTH16 = 1,
+	/// depth compressed with CompressDepthImage()
+	CODEC_DEPTH_PREDICTIVE = 2
+};
+
+struct FileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t noFrames;
+	int32_t rgbWidth, rgbHeight;
+	int32_t depthWidth, depthHeight;
+	uint32_t flags;
+	uint32_t calibSize;
+	uint64_t calibOffset;
+	uint64_t indexOffset;
+	uint64_t reserved;
+};
+
+struct IndexEntry
+{
+	uint64_t rgbOffset, depthOffset;
+	uint32_t rgbSize, depthSize;
+	uint8_t rgbCodec, depthCodec, hasIMU, reserved;
+	float imu[9];
+	double timestamp;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// SequenceFileWriter
+// ---------------------------------------------------------------------------
+
+class SequenceFileWriter::PrivateData {
+	public:
+	FILE *f;
+	bool failed, closed;
+	bool compressDepth;
+
+	FileHeader header;
+	std::string calibText;
+	std::vector<IndexEntry> index;
+	std::vector<unsigned char> buffer;
+	uint64_t offset;
+
+	bool write(const void *ptr, size_t size)
+	{
+		if (failed) return false;
+		if ((size > 0) && (fwrite(ptr, size, 1, f) != 1)) failed = true;
+		offset += size;
+		return !failed;
+	}
+
+	bool pad(void)
+	{
+		static const unsigned char zeros[PAYLOAD_ALIGNMENT] = { 0 };
+		size_t noBytes = (size_t)((PAYLOAD_ALIGNMENT - offset % PAYLOAD_ALIGNMENT) % PAYLOAD_ALIGNMENT);
+		return write(zeros, noBytes);
+	}
+};
+
+SequenceFileWriter::SequenceFileWriter(const char *fileName, const ITMRGBDCalib & calib, Vector2i imgSize_rgb, Vector2i imgSize_d, bool withIMU, bool compressDepth)
+{
+	data = new PrivateData();
+	data->failed = false;
+	data->closed = false;
+	data->compressDepth = compressDepth;
+	data->offset = 0;
+
+	memset(&data->header, 0, sizeof(FileHeader));
+	memcpy(data->header.magic, SEQUENCE_MAGIC, sizeof(SEQUENCE_MAGIC));
+	data->header.version = SEQUENCE_VERSION;
+	data->header.rgbWidth = imgSize_rgb.x; data->header.rgbHeight = imgSize_rgb.y;
+	data->header.depthWidth = imgSize_d.x; data->header.depthHeight = imgSize_d.y;
+	data->header.flags = withIMU ? SEQUENCE_FLAG_IMU : 0;
+
+	std::ostringstream calibStream;
+	writeRGBDCalib(calibStream, calib, imgSize_rgb, imgSize_d);
+	data->calibText = calibStream.str();
+
+	data->f = fopen(fileName, "wb");
+	if (data->f == NULL)
+	{
+		printf("error creating file '%s'\n", fileName);
+		data->failed = true;
+		return;
+	}
+
+	// placeholder, the final header is written by close()
+	data->write(&data->header, sizeof(FileHeader));
+	data->pad();
+}
+
+SequenceFileWriter::~SequenceFileWriter()
+{
+	close();
+	delete data;
+}
+
+bool SequenceFileWriter::isOpen(void) const
+{
+	return (data->f != NULL) && !data->failed;
+}
+
+int SequenceFileWriter::getNumberOfFrames(void) const
+{
+	return (int)data->index.size();
+}
+
+bool SequenceFileWriter::addFrame(const ITMUChar4Image *rgb, const ITMShortImage *rawDepth, const ITMIMUMeasurement *imu, double timestamp)
+{
+	if (!isOpen() || data->closed) return false;
+
+	const FileHeader & header = data->header;
+	if ((rgb->noDims.x != header.rgbWidth) || (rgb->noDims.y != header.rgbHeight) ||
+		(rawDepth->noDims.x != header.depthWidth) || (rawDepth->noDims.y != header.depthHeight))
+	{
+		printf("error: frame size does not match the sequence\n");
+		return false;
+	}
+
+	IndexEntry entry;
+	memset(&entry, 0, sizeof(IndexEntry));
+	entry.timestamp = timestamp;
+
+	// rgb
+	int noPixels_rgb = rgb->noDims.x * rgb->noDims.y;
+	const Vector4u *rgbData = rgb->GetData(MEMORYDEVICE_CPU);
+	data->buffer.resize(noPixels_rgb * 3);
+	for (int i = 0; i < noPixels_rgb; i++)
+	{
+		data->buffer[i * 3 + 0] = rgbData[i].x;
+		data->buffer[i * 3 + 1] = rgbData[i].y;
+		data->buffer[i * 3 + 2] = rgbData[i].z;
+	}
+
+	entry.rgbOffset = data->offset;
+	entry.rgbSize = (uint32_t)data->buffer.size();
+	entry.rgbCodec = CODEC_RGB24;
+	data->write(&data->buffer[0], data->buffer.size());
+	data->pad();
+
+	// depth
+	entry.depthOffset = data->offset;
+	if (data->compressDepth)
+	{
+		CompressDepthImage(rawDepth, data->buffer);
+		entry.depthSize = (uint32_t)data->buffer.size();
+		entry.depthCodec = CODEC_DEPTH_PREDICTIVE;
+		data->write(&data->buffer[0], data->buffer.size());
+	}
+	else
+	{
+		entry.depthSize = (uint32_t)(rawDepth->dataSize * sizeof(short));
+		entry.depthCodec = CODEC_DEPTH16;
+		data->write(rawDepth->GetData(MEMORYDEVICE_CPU), entry.depthSize);
+	}
+	data->pad();
+
+	// imu
+	if ((header.flags & SEQUENCE_FLAG_IMU) && (imu != NULL))
+	{
+		entry.hasIMU = 1;
+		for (int i = 0; i < 9; i++) entry.imu[i] = imu->R.m[i];
+	}
+
+	if (data->failed) return false;
+
+	data->index.push_back(entry);
+	return true;
+}
+
+bool SequenceFileWriter::close(void)
+{
+	if (data->f == NULL || data->closed) return !data->failed;
+	data->closed = true;
+
+	FileHeader & header = data->header;
+
+	header.calibOffset = data->offset;
+	header.calibSize = (uint32_t)data->calibText.size();
+	data->write(data->calibText.c_str(), data->calibText.size());
+	data->pad();
+
+	header.indexOffset = data->offset;
+	header.noFrames = (uint32_t)data->index.size();
+	if (!data->index.empty()) data->write(&data->index[0], data->index.size() * sizeof(IndexEntry));
+
+	if (!data->failed)
+	{
+		if ((fseek(data->f, 0, SEEK_SET) != 0) || (fwrite(&header, sizeof(FileHeader), 1, data->f) != 1)) data->failed = true;
+	}
+
+	if (fclose(data->f) != 0) data->failed = true;
+	data->f = NULL;
+
+	if (data->failed) printf("error writing sequence file\n");
+	return !data->failed;
+}
+
+// ---------------------------------------------------------------------------
+// SequenceRecorder
+// ---------------------------------------------------------------------------
+
+class SequenceRecorder::PrivateData : public ITMWorkerThread::Job {
+	public:
+	SequenceFileWriter *writer;
+	ITMWorkerThread *thread;
+
+	// copy of the frame being written in the background
+	ITMUChar4Image *rgb;
+	ITMShortImage *rawDepth;
+	ITMIMUMeasurement *imu;
+	bool hasIMU;
+	double timestamp;
+
+	int noFrames;
+
+	void Execute(void)
+	{
+		ITMProfiler::SetThreadName("recorder");
+		ITMProfiler::ScopedTraceEvent trace("write_frame", "io");
+		writer->addFrame(rgb, rawDepth, hasIMU ? imu : NULL, timestamp);
+	}
+};
+
+SequenceRecorder::SequenceRecorder(const char *fileName, const ITMRGBDCalib & calib, Vector2i imgSize_rgb, Vector2i imgSize_d, bool withIMU)
+{
+	data = new PrivateData();
+	data->writer = new SequenceFileWriter(fileName, calib, imgSize_rgb, imgSize_d, withIMU, true);
+	data->thread = new ITMWorkerThread();
+	data->rgb = new ITMUChar4Image(imgSize_rgb, true, false);
+	data->rawDepth = new ITMShortImage(imgSize_d, true, false);
+	data->imu = new ITMIMUMeasurement();
+	data->hasIMU = false;
+	data->timestamp = 0.0;
+	data->noFrames = 0;
+}
+
+SequenceRecorder::~SequenceRecorder()
+{
+	delete data->thread;
+	data->writer->close();
+
+	delete data->writer;
+	delete data->rgb;
+	delete data->rawDepth;
+	delete data->imu;
+	delete data;
+}
+
+bool SequenceRecorder::isOpen(void) const
+{
+	return data->writer->isOpen();
+}
+
+int SequenceRecorder::getNumberOfFrames(void) const
+{
+	return data->noFrames;
+}
+
+void SequenceRecorder::addFrame(const ITMUChar4Image *rgb, const ITMShortImage *rawDepth, const ITMIMUMeasurement *imu, double timestamp)
+{
+	// the staging buffers are in use until the previous frame has been written
+	data->thread->Wait();
+
+	data->rgb->SetFrom(rgb, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
+	data->rawDepth->SetFrom(rawDepth, ORUtils::MemoryBlock<short>::CPU_TO_CPU);
+	data->hasIMU = (imu != NULL);
+	if (imu != NULL) data->imu->SetFrom(imu);
+	data->timestamp = timestamp;
+
+	data->thread->Run(data);
+	data->noFrames++;
+}
+
+// ---------------------------------------------------------------------------
+// SequenceFileReader
+// ---------------------------------------------------------------------------
+
+class SequenceFileReader::PrivateData {
+	public:
+	const unsigned char *mapping;
+	uint64_t fileSize;
+
+#ifdef _WIN32
+	HANDLE file, fileMapping;
+#else
+	int fd;
+#endif
+
+	const FileHeader *header;
+	const IndexEntry *index;
+
+	bool map(const char *fileName);
+	void unmap(void);
+	bool validate(void);
+};
+
+bool SequenceFileReader::PrivateData::map(const char *fileName)
+{
+	mapping = NULL;
+	fileSize = 0;
+
+#ifdef _WIN32
+	fileMapping = NULL;
+	file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) return false;
+	fileSize = (uint64_t)size.QuadPart;
+
+	fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (fileMapping == NULL) return false;
+
+	mapping = (const unsigned char*)MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+	return mapping != NULL;
+#else
+	fd = open(fileName, O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) return false;
+	fileSize = (uint64_t)st.st_size;
+
+	void *ptr = mmap(NULL, (size_t)fileSize, PROT_READ, MAP_SHARED, fd, 0);
+	if (ptr == MAP_FAILED) return false;
+
+	// frames are mostly read in order, let the kernel read ahead aggressively
+	madvise(ptr, (size_t)fileSize, MADV_SEQUENTIAL);
+
+	mapping = (const unsigned char*)ptr;
+	return true;
+#endif
+}
+
+void SequenceFileReader::PrivateData::unmap(void)
+{
+#ifdef _WIN32
+	if (mapping != NULL) UnmapViewOfFile(mapping);
+	if (fileMapping != NULL) CloseHandle(fileMapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+	file = INVALID_HANDLE_VALUE; fileMapping = NULL;
+#else
+	if (mapping != NULL) munmap((void*)mapping, (size_t)fileSize);
+	if (fd >= 0) ::close(fd);
+	fd = -1;
+#endif
+	mapping = NULL;
+}
+
+bool SequenceFileReader::PrivateData::validate(void)
+{
+	if (fileSize < sizeof(FileHeader)) return false;
+
+	header = (const FileHeader*)mapping;
+	if (memcmp(header->magic, SEQUENCE_MAGIC, sizeof(SEQUENCE_MAGIC)) != 0) return false;
+	if (header->version != SEQUENCE_VERSION) return false;
+	if (header->rgbWidth <= 0 || header->rgbHeight <= 0 || header->depthWidth <= 0 || header->depthHeight <= 0) return false;
+
+	if (header->calibOffset + header->calibSize > fileSize) return false;
+	if (header->indexOffset + (uint64_t)header->noFrames * sizeof(IndexEntry) > fileSize) return false;
+	index = (const IndexEntry*)(mapping + header->indexOffset);
+
+	uint64_t rgbSize = (uint64_t)header->rgbWidth * header->rgbHeight * 3;
+	uint64_t depthSize = (uint64_t)header->depthWidth * header->depthHeight * sizeof(short);
+
+	for (uint32_t i = 0; i < header->noFrames; i++)
+	{
+		const IndexEntry & entry = index[i];
+		if (entry.rgbCodec != CODEC_RGB24 || entry.rgbSize != rgbSize) return false;
+		if (entry.depthCodec == CODEC_DEPTH16) { if (entry.depthSize != depthSize) return false; }
+		else if (entry.depthCodec != CODEC_DEPTH_PREDICTIVE) return false;
+		if (entry.rgbOffset + entry.rgbSize > fileSize) return false;
+		if (entry.depthOffset + entry.depthSize > fileSize) return false;
+	}
+
+	return true;
+}
+
+SequenceFileReader::SequenceFileReader(const char *fileName)
+	: ImageSourceEngine(ITMRGBDCalib())
+{
+	data = new PrivateData();
+	data->header = NULL;
+	data->index = NULL;
+#ifdef _WIN32
+	data->file = INVALID_HANDLE_VALUE;
+#else
+	data->fd = -1;
+#endif
+
+	imuSource = NULL;
+	currentFrameNo = 0;
+	currentTimestamp = 0.0;
+	imgSize_rgb = Vector2i(0, 0);
+	imgSize_d = Vector2i(0, 0);
+
+	if (!data->map(fileName))
+	{
+		printf("error mapping file '%s'\n", fileName);
+		data->unmap();
+		return;
+	}
+
+	if (!data->validate())
+	{
+		printf("error: '%s' is not a valid sequence file\n", fileName);
+		data->unmap();
+		return;
+	}
+
+	std::istringstream calibStream(std::string((const char*)data->mapping + data->header->calibOffset, data->header->calibSize));
+	if (!readRGBDCalib(calibStream, calib)) printf("error reading calibration from '%s'\n", fileName);
+
+	imgSize_rgb = Vector2i(data->header->rgbWidth, data->header->rgbHeight);
+	imgSize_d = Vector2i(data->header->depthWidth, data->header->depthHeight);
+
+	if (data->header->flags & SEQUENCE_FLAG_IMU) imuSource = new FrameIMUSource();
+}
+
+SequenceFileReader::~SequenceFileReader()
+{
+	data->unmap();
+	delete data;
+	if (imuSource != NULL) delete imuSource;
+}
+
+bool SequenceFileReader::isSequenceFile(const char *fileName)
+{
+	FILE *f = fopen(fileName, "rb");
+	if (f == NULL) return false;
+
+	char magic[sizeof(SEQUENCE_MAGIC)];
+	bool ret = (fread(magic, sizeof(magic), 1, f) == 1) && (memcmp(magic, SEQUENCE_MAGIC, sizeof(magic)) == 0);
+	fclose(f);
+
+	return ret;
+}
+
+bool SequenceFileReader::isOpen(void) const
+{
+	return data->mapping != NULL;
+}
+
+int SequenceFileReader::getNumberOfFrames(void) const
+{
+	return isOpen() ? (int)data->header->noFrames : 0;
+}
+
+void SequenceFileReader::setCurrentFrame(int frameNo)
+{
+	currentFrameNo = frameNo;
+}
+
+bool SequenceFileReader::hasMoreImages(void)
+{
+	return (currentFrameNo >= 0) && (currentFrameNo < getNumberOfFrames());
+}
+
+void SequenceFileReader::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
+{
+	if (!hasMoreImages()) return;
+
+	ITMProfiler::ScopedTraceEvent trace("read_sequence_frame", "io");
+	const IndexEntry & entry = data->index[currentFrameNo];
+
+	rgb->ChangeDims(imgSize_rgb);
+	Vector4u *rgbData = rgb->GetData(MEMORYDEVICE_CPU);
+	const unsigned char *src = data->mapping + entry.rgbOffset;
+	int noPixels_rgb = imgSize_rgb.x * imgSize_rgb.y;
+	for (int i = 0; i < noPixels_rgb; i++)
+	{
+		rgbData[i].x = src[i * 3 + 0];
+		rgbData[i].y = src[i * 3 + 1];
+		rgbData[i].z = src[i * 3 + 2];
+		rgbData[i].w = 255;
+	}
+
+	rawDepth->ChangeDims(imgSize_d);
+	if (entry.depthCodec == CODEC_DEPTH_PREDICTIVE)
+	{
+		if (!DecompressDepthImage(data->mapping + entry.depthOffset, entry.depthSize, rawDepth))
+			printf("error decoding depth of frame %d\n", currentFrameNo);
+	}
+	else memcpy(rawDepth->GetData(MEMORYDEVICE_CPU), data->mapping + entry.depthOffset, entry.depthSize);
+
+	if (imuSource != NULL)
+	{
+		ITMIMUMeasurement imu;
+		for (int i = 0; i < 9; i++) imu.R.m[i] = entry.imu[i];
+		imuSource->setMeasurement((entry.hasIMU != 0) ? &imu : NULL);
+	}
+
+	currentTimestamp = entry.timestamp;
+	++currentFrameNo;
+}
+
+IMUSourceEngine *SequenceFileReader::getIMUSource(void)
+{
+	return imuSource;
+}
@@ -0,0 +1,136 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "ImageSourceEngine.h"
+#include "IMUSourceEngine.h"
+
+namespace InfiniTAM
+{
+	namespace Engine
+	{
+		/** \brief
+		    Writes an RGB-D sequence into a single indexed file.
+
+		    The file starts with a fixed header, followed by the
+		    per-frame RGB and depth payloads. The calibration (in the
+		    text format of readRGBDCalib()) and a frame index holding
+		    payload offsets, timestamps and optional IMU rotations are
+		    appended by @ref close(), which also rewrites the header.
+		    A file that was not closed properly is therefore rejected
+		    by @ref SequenceFileReader.
+
+		    With @p compressDepth, depth frames are stored with the
+		    lossless codec of CompressDepthImage().
+		*/
+		class SequenceFileWriter
+		{
+		private:
+			class PrivateData;
+			PrivateData *data;
+
+		public:
+			SequenceFileWriter(const char *fileName, const ITMRGBDCalib & calib, Vector2i imgSize_rgb, Vector2i imgSize_d, bool withIMU, bool compressDepth = true);
+			~SequenceFileWriter();
+
+			/// Returns false if the file could not be created or a write has failed
+			bool isOpen(void) const;
+
+			/// Appends a frame. @p imu is ignored unless the writer was created with IMU support.
+			bool addFrame(const ITMUChar4Image *rgb, const ITMShortImage *rawDepth, const ITMIMUMeasurement *imu, double timestamp);
+
+			/// Writes calibration, index and header. Called by the destructor if necessary.
+			bool close(void);
+
+			int getNumberOfFrames(void) const;
+
+			// Suppress the default copy constructor and assignment operator
+			SequenceFileWriter(const SequenceFileWriter&);
+			SequenceFileWriter& operator=(const SequenceFileWriter&);
+		};
+
+		/** \brief
+		    Records a sequence file on a background thread.
+
+		    @ref addFrame() only copies the images, while compression
+		    and file access of a frame overlap with the processing of
+		    the next one. If the background thread falls behind,
+		    @ref addFrame() waits for it rather than dropping frames.
+		*/
+		class SequenceRecorder
+		{
+		private:
+			class PrivateData;
+			PrivateData *data;
+
+		public:
+			SequenceRecorder(const char *fileName, const ITMRGBDCalib & calib, Vector2i imgSize_rgb, Vector2i imgSize_d, bool withIMU);
+			/// Writes the pending frame and closes the file
+			~SequenceRecorder();
+
+			bool isOpen(void) const;
+
+			/// Queues a frame for writing. @p imu may be NULL.
+			void addFrame(const ITMUChar4Image *rgb, const ITMShortImage *rawDepth, const ITMIMUMeasurement *imu, double timestamp);
+
+			/// Number of frames written so far, including the pending one
+			int getNumberOfFrames(void) const;
+
+			// Suppress the default copy constructor and assignment operator
+			SequenceRecorder(const SequenceRecorder&);
+			SequenceRecorder& operator=(const SequenceRecorder&);
+		};
+
+		/** \brief
+		    Replays a sequence written by @ref SequenceFileWriter.
+
+		    The file is memory mapped, so reading a frame does not
+		    involve any per-frame file system calls. Frames can be
+		    accessed in order through the usual ImageSourceEngine
+		    interface or randomly through @ref setCurrentFrame(). If
+		    the file contains IMU records, they are delivered through
+		    the source returned by @ref getIMUSource().
+		*/
+		class SequenceFileReader : public ImageSourceEngine
+		{
+		private:
+			class PrivateData;
+			PrivateData *data;
+
+			FrameIMUSource *imuSource;
+
+			Vector2i imgSize_rgb, imgSize_d;
+			int currentFrameNo;
+			double currentTimestamp;
+
+		public:
+			SequenceFileReader(const char *fileName);
+			~SequenceFileReader();
+
+			/// Checks whether @p fileName starts with the signature of a sequence file
+			static bool isSequenceFile(const char *fileName);
+
+			/// Returns false if the file could not be mapped or is not a valid sequence
+			bool isOpen(void) const;
+
+			bool hasMoreImages(void);
+			void getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
+			Vector2i getDepthImageSize(void) { return imgSize_d; }
+			Vector2i getRGBImageSize(void) { return imgSize_rgb; }
+
+			int getNumberOfFrames(void) const;
+			int getCurrentFrame(void) const { return currentFrameNo; }
+			void setCurrentFrame(int frameNo);
+
+			/// Timestamp in seconds of the frame returned by the last call to getImages()
+			double getTimestamp(void) const { return currentTimestamp; }
+
+			/// Source of the IMU measurements belonging to the frames returned by getImages(), or NULL without IMU
+			IMUSourceEngine *getIMUSource(void);
+
+			// Suppress the default copy constructor and assignment operator
+			SequenceFileReader(const SequenceFileReader&);
+			SequenceFileReader& operator=(const SequenceFileReader&);
+		};
+	}
+}
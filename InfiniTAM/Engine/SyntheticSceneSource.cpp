@@ -0,0 +1,597 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "SyntheticSceneSource.h"
+
+#include "../ITMLib/Utils/ITMProfiler.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace InfiniTAM::Engine;
+
+typedef SyntheticSceneSource::Primitive Primitive;
+
+// keyframes added per full turn of an orbit; the spline through them is very close to a circle
+static const int ORBIT_KEYFRAMES_PER_TURN = 16;
+
+static Primitive makePrimitive(Primitive::Type type, Vector3f a, Vector3f b, float radius, Vector3f colour)
+{
+	Primitive primitive;
+	primitive.type = type;
+	primitive.a = a; primitive.b = b;
+	primitive.radius = radius;
+	primitive.colour = colour;
+	return primitive;
+}
+
+SyntheticSceneSource::Settings::Settings(void)
+{
+	imgSize = Vector2i(640, 480);
+	intrinsics = Vector4f(0.0f, 0.0f, 0.0f, 0.0f);
+	noFrames = 300;
+	frameRate = 30.0;
+
+	seed = 1;
+	// axial noise of a Kinect, after Nguyen et al., "Modeling Kinect Sensor Noise", 3DIMPVT 2012
+	depthNoise = Vector2f(0.0012f, 0.0019f);
+	depthRange = Vector2f(0.4f, 4.0f);
+	dropoutRate = 0.01f;
+	grazingLimit = 0.1f;
+	rgbNoise = 2.0f;
+	textureScale = 0.2f;
+
+	// a corner of a room, with the camera circling a few objects on the floor
+	Vector3f grey(0.6f, 0.6f, 0.6f);
+	primitives.push_back(makePrimitive(Primitive::PRIMITIVE_PLANE, Vector3f(0.0f, 1.0f, 0.0f), Vector3f(0.0f), 0.0f, Vector3f(0.5f, 0.45f, 0.4f)));
+	primitives.push_back(makePrimitive(Primitive::PRIMITIVE_PLANE, Vector3f(0.0f, 0.0f, 1.0f), Vector3f(0.0f), -2.0f, grey));
+	primitives.push_back(makePrimitive(Primitive::PRIMITIVE_PLANE, Vector3f(1.0f, 0.0f, 0.0f), Vector3f(0.0f), -2.0f, grey));
+	primitives.push_back(makePrimitive(Primitive::PRIMITIVE_BOX, Vector3f(-0.5f, 0.0f, -0.5f), Vector3f(0.0f, 0.4f, 0.0f), 0.0f, Vector3f(0.8f, 0.3f, 0.2f)));
+	primitives.push_back(makePrimitive(Primitive::PRIMITIVE_BOX, Vector3f(-0.35f, 0.4f, -0.4f), Vector3f(-0.15f, 0.6f, -0.2f), 0.0f, Vector3f(0.2f, 0.7f, 0.3f)));
+	primitives.push_back(makePrimitive(Primitive::PRIMITIVE_SPHERE, Vector3f(0.5f, 0.3f, -0.2f), Vector3f(0.0f), 0.3f, Vector3f(0.2f, 0.4f, 0.9f)));
+	primitives.push_back(makePrimitive(Primitive::PRIMITIVE_CYLINDER, Vector3f(0.1f, 0.0f, 0.6f), Vector3f(0.1f, 0.8f, 0.6f), 0.15f, Vector3f(0.9f, 0.8f, 0.2f)));
+
+	addOrbit(*this, Vector3f(0.0f, 0.3f, 0.0f), 1.8f, 1.0f, 0.25f);
+}
+
+SyntheticSceneSource::SyntheticSceneSource(const char *sceneFile, Vector2i imgSize)
+	: ImageSourceEngine(ITMRGBDCalib())
+{
+	if (!loadSceneFile(sceneFile, settings)) settings.noFrames = 0;
+
+	if ((imgSize.x > 0) && (imgSize.y > 0))
+	{
+		// keep the field of view of the scene
+		if (settings.intrinsics.x > 0.0f)
+		{
+			float ratio = (float)imgSize.x / (float)settings.imgSize.x;
+			settings.intrinsics *= ratio;
+		}
+		settings.imgSize = imgSize;
+	}
+
+	setup();
+}
+
+SyntheticSceneSource::SyntheticSceneSource(const Settings & settings)
+	: ImageSourceEngine(ITMRGBDCalib()), settings(settings)
+{
+	setup();
+}
+
+void SyntheticSceneSource::setup(void)
+{
+	if (settings.intrinsics.x <= 0.0f)
+	{
+		float f = 525.0f * settings.imgSize.x / 640.0f;
+		settings.intrinsics = Vector4f(f, f, 0.5f * (settings.imgSize.x - 1), 0.5f * (settings.imgSize.y - 1));
+	}
+
+	for (size_t i = 0; i < settings.primitives.size(); i++)
+	{
+		Primitive & primitive = settings.primitives[i];
+		if (primitive.type == Primitive::PRIMITIVE_PLANE)
+		{
+			float norm = length(primitive.a);
+			primitive.a /= norm; primitive.radius /= norm;
+		}
+	}
+
+	// depth and colour are rendered from the same viewpoint, so the default extrinsics (identity) apply
+	const Vector4f & p = settings.intrinsics;
+	calib.intrinsics_d.SetFrom(p.x, p.y, p.z, p.w, (float)settings.imgSize.x, (float)settings.imgSize.y);
+	calib.intrinsics_rgb = calib.intrinsics_d;
+	calib.disparityCalib.SetFrom(1.0f / 1000.0f, 0.0f, ITMDisparityCalib::TRAFO_AFFINE);
+
+	currentFrameNo = 0;
+	firstPose = getScenePose(0);
+}
+
+void SyntheticSceneSource::addOrbit(Settings & settings, Vector3f centre, float radius, float height, float turns)
+{
+	int noKeyframes = (int)ceil(fabs(turns) * ORBIT_KEYFRAMES_PER_TURN) + 1;
+	if (noKeyframes < 2) noKeyframes = 2;
+
+	for (int i = 0; i < noKeyframes; i++)
+	{
+		float t = (float)i / (float)(noKeyframes - 1);
+		float angle = 2.0f * PI * turns * t;
+
+		Keyframe keyframe;
+		keyframe.frameNo = (int)floor(t * (settings.noFrames - 1) + 0.5f);
+		keyframe.eye = centre + Vector3f(radius * cos(angle), height, radius * sin(angle));
+		keyframe.target = centre;
+		settings.trajectory.push_back(keyframe);
+	}
+}
+
+// ---------------------------------------------------------------------------
+// trajectory
+
+static inline Vector3f catmullRom(const Vector3f & p0, const Vector3f & p1, const Vector3f & p2, const Vector3f & p3, float t)
+{
+	float t2 = t * t, t3 = t2 * t;
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+static void interpolateCamera(const std::vector<SyntheticSceneSource::Keyframe> & trajectory, int frameNo, Vector3f & eye, Vector3f & target)
+{
+	int noKeyframes = (int)trajectory.size();
+	if (noKeyframes == 0) { eye = Vector3f(0.0f, 0.0f, 0.0f); target = Vector3f(0.0f, 0.0f, 1.0f); return; }
+
+	if (frameNo <= trajectory[0].frameNo) { eye = trajectory[0].eye; target = trajectory[0].target; return; }
+	if (frameNo >= trajectory[noKeyframes - 1].frameNo) { eye = trajectory[noKeyframes - 1].eye; target = trajectory[noKeyframes - 1].target; return; }
+
+	int i = 0;
+	while (trajectory[i + 1].frameNo <= frameNo) i++;
+
+	const SyntheticSceneSource::Keyframe & k0 = trajectory[(i > 0) ? i - 1 : i];
+	const SyntheticSceneSource::Keyframe & k1 = trajectory[i];
+	const SyntheticSceneSource::Keyframe & k2 = trajectory[i + 1];
+	const SyntheticSceneSource::Keyframe & k3 = trajectory[(i + 2 < noKeyframes) ? i + 2 : i + 1];
+
+	float t = (float)(frameNo - k1.frameNo) / (float)(k2.frameNo - k1.frameNo);
+	eye = catmullRom(k0.eye, k1.eye, k2.eye, k3.eye, t);
+	target = catmullRom(k0.target, k1.target, k2.target, k3.target, t);
+}
+
+/// rows of the rotation from scene to camera coordinates, with x right, y down and z along the viewing direction
+static void lookAt(const Vector3f & eye, const Vector3f & target, Vector3f & axisX, Vector3f & axisY, Vector3f & axisZ)
+{
+	axisZ = normalize(target - eye);
+
+	Vector3f up(0.0f, 1.0f, 0.0f);
+	// looking straight up or down, any horizontal direction will do as up vector
+	if (fabs(dot(axisZ, up)) > 0.999f) up = Vector3f(0.0f, 0.0f, 1.0f);
+
+	axisX = normalize(cross(axisZ, up));
+	axisY = cross(axisZ, axisX);
+}
+
+static Matrix4f rigidInverse(const Matrix4f & M)
+{
+	Matrix4f invM;
+	invM.setIdentity();
+	for (int r = 0; r < 3; r++) for (int c = 0; c < 3; c++) invM.m[c * 4 + r] = M.m[r * 4 + c];
+	for (int r = 0; r < 3; r++) invM.m[12 + r] = -(invM.m[r] * M.m[12] + invM.m[4 + r] * M.m[13] + invM.m[8 + r] * M.m[14]);
+	return invM;
+}
+
+Matrix4f SyntheticSceneSource::getScenePose(int frameNo) const
+{
+	Vector3f eye, target, axis[3];
+	interpolateCamera(settings.trajectory, frameNo, eye, target);
+	lookAt(eye, target, axis[0], axis[1], axis[2]);
+
+	Matrix4f M;
+	M.setIdentity();
+	for (int r = 0; r < 3; r++)
+	{
+		M.m[r] = axis[r].x; M.m[4 + r] = axis[r].y; M.m[8 + r] = axis[r].z;
+		M.m[12 + r] = -dot(axis[r], eye);
+	}
+	return M;
+}
+
+Matrix4f SyntheticSceneSource::getGroundTruthPose(int frameNo) const
+{
+	return getScenePose(frameNo) * rigidInverse(firstPose);
+}
+
+bool SyntheticSceneSource::saveGroundTruth(const char *fileName) const
+{
+	FILE *f = fopen(fileName, "w");
+	if (f == NULL) return false;
+
+	fprintf(f, "# ground truth trajectory of a synthetic scene\n# timestamp tx ty tz qx qy qz qw\n");
+	for (int frameNo = 0; frameNo < settings.noFrames; frameNo++)
+	{
+		// the benchmark format holds camera to world transformations
+		Matrix4f invM = rigidInverse(getGroundTruthPose(frameNo));
+		float r00 = invM.m00, r01 = invM.m10, r02 = invM.m20;
+		float r10 = invM.m01, r11 = invM.m11, r12 = invM.m21;
+		float r20 = invM.m02, r21 = invM.m12, r22 = invM.m22;
+
+		float qw, qx, qy, qz, trace = r00 + r11 + r22;
+		if (trace > 0.0f)
+		{
+			float s = 0.5f / sqrt(trace + 1.0f);
+			qw = 0.25f / s; qx = (r21 - r12) * s; qy = (r02 - r20) * s; qz = (r10 - r01) * s;
+		}
+		else if ((r00 > r11) && (r00 > r22))
+		{
+			float s = 2.0f * sqrt(1.0f + r00 - r11 - r22);
+			qw = (r21 - r12) / s; qx = 0.25f * s; qy = (r01 + r10) / s; qz = (r02 + r20) / s;
+		}
+		else if (r11 > r22)
+		{
+			float s = 2.0f * sqrt(1.0f + r11 - r00 - r22);
+			qw = (r02 - r20) / s; qx = (r01 + r10) / s; qy = 0.25f * s; qz = (r12 + r21) / s;
+		}
+		else
+		{
+			float s = 2.0f * sqrt(1.0f + r22 - r00 - r11);
+			qw = (r10 - r01) / s; qx = (r02 + r20) / s; qy = (r12 + r21) / s; qz = 0.25f * s;
+		}
+
+		fprintf(f, "%.6f %f %f %f %f %f %f %f\n", getTimestamp(frameNo), invM.m30, invM.m31, invM.m32, qx, qy, qz, qw);
+	}
+
+	return fclose(f) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// rendering
+
+/// hash of the inputs, so that the noise of a pixel does not depend on the order pixels are rendered in
+static inline unsigned int hashNoise(unsigned int seed, unsigned int frameNo, unsigned int pixel, unsigned int channel)
+{
+	unsigned long long h = ((unsigned long long)seed << 32) ^ ((unsigned long long)frameNo << 40) ^ ((unsigned long long)channel << 28) ^ pixel;
+	// finaliser of splitmix64
+	h += 0x9e3779b97f4a7c15ULL;
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+	return (unsigned int)((h ^ (h >> 31)) >> 32);
+}
+
+/// uniform in (0, 1]
+static inline float uniformNoise(unsigned int seed, unsigned int frameNo, unsigned int pixel, unsigned int channel)
+{
+	return ((hashNoise(seed, frameNo, pixel, channel) >> 8) + 1) * (1.0f / 16777216.0f);
+}
+
+/// standard normal distribution, by the Box-Muller transform
+static inline float gaussianNoise(unsigned int seed, unsigned int frameNo, unsigned int pixel, unsigned int channel)
+{
+	float u1 = uniformNoise(seed, frameNo, pixel, 2 * channel);
+	float u2 = uniformNoise(seed, frameNo, pixel, 2 * channel + 1);
+	return sqrt(-2.0f * log(u1)) * cos(2.0f * PI * u2);
+}
+
+/// distance along the ray to the first intersection after tMin, or a negative value if there is none
+static inline float intersect(const Primitive & primitive, const Vector3f & origin, const Vector3f & dir, float tMin, Vector3f & normal)
+{
+	switch (primitive.type)
+	{
+	case Primitive::PRIMITIVE_PLANE:
+	{
+		float denom = dot(primitive.a, dir);
+		if (fabs(denom) < 1e-8f) return -1.0f;
+		normal = primitive.a;
+		return (primitive.radius - dot(primitive.a, origin)) / denom;
+	}
+	case Primitive::PRIMITIVE_SPHERE:
+	{
+		Vector3f oc = origin - primitive.a;
+		float a = dot(dir, dir), b = dot(oc, dir), c = dot(oc, oc) - primitive.radius * primitive.radius;
+		float disc = b * b - a * c;
+		if (disc < 0.0f) return -1.0f;
+
+		float root = sqrt(disc);
+		float t = (-b - root) / a;
+		if (t <= tMin) t = (-b + root) / a;
+		normal = (origin + t * dir - primitive.a) / primitive.radius;
+		return t;
+	}
+	case Primitive::PRIMITIVE_BOX:
+	{
+		float tNear = -1e30f, tFar = 1e30f;
+		int axisNear = 0, axisFar = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			if (fabs(dir[i]) < 1e-12f)
+			{
+				if ((origin[i] < primitive.a[i]) || (origin[i] > primitive.b[i])) return -1.0f;
+				continue;
+			}
+			float t1 = (primitive.a[i] - origin[i]) / dir[i], t2 = (primitive.b[i] - origin[i]) / dir[i];
+			if (t1 > t2) { float tmp = t1; t1 = t2; t2 = tmp; }
+			if (t1 > tNear) { tNear = t1; axisNear = i; }
+			if (t2 < tFar) { tFar = t2; axisFar = i; }
+		}
+		if (tNear > tFar) return -1.0f;
+
+		int axis = (tNear > tMin) ? axisNear : axisFar;
+		normal = Vector3f(0.0f, 0.0f, 0.0f);
+		normal[axis] = (dir[axis] > 0.0f) ? -1.0f : 1.0f;
+		return (tNear > tMin) ? tNear : tFar;
+	}
+	case Primitive::PRIMITIVE_CYLINDER:
+	{
+		Vector3f axis = primitive.b - primitive.a;
+		float height = length(axis);
+		axis /= height;
+
+		Vector3f oc = origin - primitive.a;
+		float ocAxis = dot(oc, axis), dirAxis = dot(dir, axis);
+		Vector3f ocPerp = oc - ocAxis * axis, dirPerp = dir - dirAxis * axis;
+		float r2 = primitive.radius * primitive.radius;
+
+		float best = -1.0f;
+
+		// mantle
+		float a = dot(dirPerp, dirPerp), b = dot(ocPerp, dirPerp), c = dot(ocPerp, ocPerp) - r2;
+		float disc = b * b - a * c;
+		if ((a > 1e-12f) && (disc >= 0.0f))
+		{
+			float root = sqrt(disc);
+			for (int i = 0; i < 2; i++)
+			{
+				float t = (-b + ((i == 0) ? -root : root)) / a;
+				float s = ocAxis + t * dirAxis;
+				if ((t > tMin) && (s >= 0.0f) && (s <= height) && ((best < 0.0f) || (t < best)))
+				{
+					best = t;
+					normal = (ocPerp + t * dirPerp) / primitive.radius;
+				}
+			}
+		}
+
+		// caps
+		if (fabs(dirAxis) > 1e-12f)
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				float s = (i == 0) ? 0.0f : height;
+				float t = (s - ocAxis) / dirAxis;
+				Vector3f p = ocPerp + t * dirPerp;
+				if ((t > tMin) && (dot(p, p) <= r2) && ((best < 0.0f) || (t < best)))
+				{
+					best = t;
+					normal = (i == 0) ? -axis : axis;
+				}
+			}
+		}
+
+		return best;
+	}
+	}
+
+	return -1.0f;
+}
+
+void SyntheticSceneSource::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
+{
+	ITMProfiler::ScopedTraceEvent trace("render_synthetic", "io");
+
+	int frameNo = currentFrameNo++;
+
+	Vector3f eye, target, axisX, axisY, axisZ;
+	interpolateCamera(settings.trajectory, frameNo, eye, target);
+	lookAt(eye, target, axisX, axisY, axisZ);
+
+	const Vector4f & intrinsics = settings.intrinsics;
+	const Primitive *primitives = settings.primitives.empty() ? NULL : &settings.primitives[0];
+	int noPrimitives = (int)settings.primitives.size();
+	int width = settings.imgSize.x, height = settings.imgSize.y;
+
+	Vector4u *rgbData = rgb->GetData(MEMORYDEVICE_CPU);
+	short *depthData = rawDepth->GetData(MEMORYDEVICE_CPU);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int y = 0; y < height; y++) for (int x = 0; x < width; x++)
+	{
+		int locId = x + y * width;
+
+		// with a viewing direction of unit length in z, the distance along the ray is the depth
+		Vector3f dir = axisX * ((x - intrinsics.z) / intrinsics.x) + axisY * ((y - intrinsics.w) / intrinsics.y) + axisZ;
+
+		float depth = -1.0f;
+		int hitId = -1;
+		Vector3f normal(0.0f, 0.0f, 0.0f);
+		for (int i = 0; i < noPrimitives; i++)
+		{
+			Vector3f n;
+			float t = intersect(primitives[i], eye, dir, 1e-4f, n);
+			if ((t > 1e-4f) && ((depth < 0.0f) || (t < depth))) { depth = t; hitId = i; normal = n; }
+		}
+
+		if (hitId < 0)
+		{
+			rgbData[locId] = Vector4u((uchar)0, (uchar)0, (uchar)0, (uchar)255);
+			depthData[locId] = 0;
+			continue;
+		}
+
+		float cosIncidence = -dot(normal, dir) / length(dir);
+		if (cosIncidence < 0.0f) { cosIncidence = -cosIncidence; normal = -normal; }
+
+		// colour: headlight shading of a checkerboard, evaluated just below the surface to avoid flicker on axis aligned faces
+		Vector3f point = eye + depth * dir;
+		float texture = 1.0f;
+		if (settings.textureScale > 0.0f)
+		{
+			Vector3f p = (point - normal * (0.01f * settings.textureScale)) / settings.textureScale;
+			int parity = (int)floor(p.x) + (int)floor(p.y) + (int)floor(p.z);
+			texture = ((parity & 1) == 0) ? 1.0f : 0.6f;
+		}
+
+		Vector3f colour = primitives[hitId].colour * ((0.25f + 0.75f * cosIncidence) * texture * 255.0f);
+		Vector4u pixel((uchar)0, (uchar)0, (uchar)0, (uchar)255);
+		for (int c = 0; c < 3; c++)
+		{
+			float value = colour[c];
+			if (settings.rgbNoise > 0.0f) value += settings.rgbNoise * gaussianNoise(settings.seed, frameNo, locId, 1 + c);
+			pixel[c] = (uchar)((value < 0.0f) ? 0.0f : ((value > 255.0f) ? 255.0f : value + 0.5f));
+		}
+		rgbData[locId] = pixel;
+
+		// depth
+		bool valid = (depth >= settings.depthRange.x) && (depth <= settings.depthRange.y) && (cosIncidence >= settings.grazingLimit);
+		if (valid && (settings.dropoutRate > 0.0f)) valid = uniformNoise(settings.seed, frameNo, locId, 0) > settings.dropoutRate;
+
+		if (valid)
+		{
+			float sigma = settings.depthNoise.x + settings.depthNoise.y * (depth - 0.4f) * (depth - 0.4f);
+			if (sigma > 0.0f) depth += sigma * gaussianNoise(settings.seed, frameNo, locId, 4);
+			float mm = depth * 1000.0f + 0.5f;
+			depthData[locId] = (mm < 1.0f) ? 0 : ((mm > 32767.0f) ? 32767 : (short)mm);
+		}
+		else depthData[locId] = 0;
+	}
+}
+
+// ---------------------------------------------------------------------------
+// scene files
+
+static const char *sceneFileSignature = "ITMSCENE";
+
+bool SyntheticSceneSource::isSceneFile(const char *fileName)
+{
+	std::ifstream f(fileName);
+	std::string signature;
+	f >> signature;
+	return !f.fail() && (signature == sceneFileSignature);
+}
+
+bool SyntheticSceneSource::loadSceneFile(const char *fileName, Settings & settings)
+{
+	std::ifstream f(fileName);
+	if (!f.is_open()) { printf("error reading file '%s'\n", fileName); return false; }
+
+	bool sceneReplaced = false, trajectoryReplaced = false;
+	bool signatureFound = false;
+
+	// an orbit depends on the number of frames, which may be given later in the file
+	struct Orbit { Vector3f centre; float radius, height, turns; };
+	std::vector<Orbit> orbits;
+
+	std::string line;
+	int lineNo = 0;
+	while (std::getline(f, line))
+	{
+		lineNo++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos) line.erase(comment);
+
+		std::istringstream src(line);
+		std::string keyword;
+		if (!(src >> keyword)) continue;
+
+		if (!signatureFound)
+		{
+			if (keyword != sceneFileSignature) { printf("error: '%s' is not a scene file\n", fileName); return false; }
+			signatureFound = true;
+			continue;
+		}
+
+		bool isPrimitive = (keyword == "plane") || (keyword == "sphere") || (keyword == "box") || (keyword == "cylinder");
+		if (isPrimitive && !sceneReplaced) { settings.primitives.clear(); sceneReplaced = true; }
+
+		bool isMotion = (keyword == "keyframe") || (keyword == "orbit");
+		if (isMotion && !trajectoryReplaced) { settings.trajectory.clear(); trajectoryReplaced = true; }
+
+		Primitive primitive;
+		primitive.a = primitive.b = Vector3f(0.0f, 0.0f, 0.0f);
+		primitive.radius = 0.0f;
+		Vector3f & a = primitive.a, & b = primitive.b, & colour = primitive.colour;
+
+		if (keyword == "size") src >> settings.imgSize.x >> settings.imgSize.y;
+		else if (keyword == "intrinsics") src >> settings.intrinsics.x >> settings.intrinsics.y >> settings.intrinsics.z >> settings.intrinsics.w;
+		else if (keyword == "frames") src >> settings.noFrames;
+		else if (keyword == "rate") src >> settings.frameRate;
+		else if (keyword == "seed") src >> settings.seed;
+		else if (keyword == "depth_noise") src >> settings.depthNoise.x >> settings.depthNoise.y;
+		else if (keyword == "depth_range") src >> settings.depthRange.x >> settings.depthRange.y;
+		else if (keyword == "dropout") src >> settings.dropoutRate >> settings.grazingLimit;
+		else if (keyword == "rgb_noise") src >> settings.rgbNoise;
+		else if (keyword == "texture") src >> settings.textureScale;
+		else if (keyword == "plane")
+		{
+			primitive.type = Primitive::PRIMITIVE_PLANE;
+			src >> a.x >> a.y >> a.z >> primitive.radius >> colour.r >> colour.g >> colour.b;
+			if (length(a) == 0.0f) src.setstate(std::ios::failbit);
+		}
+		else if (keyword == "sphere")
+		{
+			primitive.type = Primitive::PRIMITIVE_SPHERE;
+			src >> a.x >> a.y >> a.z >> primitive.radius >> colour.r >> colour.g >> colour.b;
+		}
+		else if (keyword == "box")
+		{
+			primitive.type = Primitive::PRIMITIVE_BOX;
+			src >> a.x >> a.y >> a.z >> b.x >> b.y >> b.z >> colour.r >> colour.g >> colour.b;
+			for (int i = 0; i < 3; i++) if (a[i] > b[i]) { float tmp = a[i]; a[i] = b[i]; b[i] = tmp; }
+		}
+		else if (keyword == "cylinder")
+		{
+			primitive.type = Primitive::PRIMITIVE_CYLINDER;
+			src >> a.x >> a.y >> a.z >> b.x >> b.y >> b.z >> primitive.radius >> colour.r >> colour.g >> colour.b;
+			if (length(b - a) == 0.0f) src.setstate(std::ios::failbit);
+		}
+		else if (keyword == "keyframe")
+		{
+			Keyframe keyframe;
+			src >> keyframe.frameNo >> keyframe.eye.x >> keyframe.eye.y >> keyframe.eye.z >> keyframe.target.x >> keyframe.target.y >> keyframe.target.z;
+			if (!src.fail() && !settings.trajectory.empty() && (keyframe.frameNo <= settings.trajectory.back().frameNo))
+			{
+				printf("error in '%s', line %d: keyframes must be in increasing order of frames\n", fileName, lineNo);
+				return false;
+			}
+			settings.trajectory.push_back(keyframe);
+		}
+		else if (keyword == "orbit")
+		{
+			Orbit orbit;
+			src >> orbit.centre.x >> orbit.centre.y >> orbit.centre.z >> orbit.radius >> orbit.height >> orbit.turns;
+			orbits.push_back(orbit);
+		}
+		else
+		{
+			printf("error in '%s', line %d: unknown keyword '%s'\n", fileName, lineNo, keyword.c_str());
+			return false;
+		}
+
+		if (src.fail())
+		{
+			printf("error in '%s', line %d: invalid parameters for '%s'\n", fileName, lineNo, keyword.c_str());
+			return false;
+		}
+
+		if (isPrimitive) settings.primitives.push_back(primitive);
+	}
+
+	if (!signatureFound) { printf("error: '%s' is not a scene file\n", fileName); return false; }
+
+	if ((settings.imgSize.x <= 0) || (settings.imgSize.y <= 0) || (settings.noFrames < 0) || (settings.frameRate <= 0.0))
+	{
+		printf("error in '%s': invalid image size, number of frames or frame rate\n", fileName);
+		return false;
+	}
+
+	if ((orbits.size() > 1) || (!orbits.empty() && !settings.trajectory.empty()))
+	{
+		printf("error in '%s': an orbit spans the whole sequence and cannot be combined with other camera motion\n", fileName);
+		return false;
+	}
+
+	if (!orbits.empty()) addOrbit(settings, orbits[0].centre, orbits[0].radius, orbits[0].height, orbits[0].turns);
+
+	return true;
+}
@@ -0,0 +1,171 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <vector>
+
+#include "ImageSourceEngine.h"
+
+namespace InfiniTAM
+{
+	namespace Engine
+	{
+		/** \brief
+		    Renders RGB-D frames of an analytic scene along a scripted
+		    camera trajectory.
+
+		    The scene is made of planes, spheres, axis aligned boxes
+		    and cylinders. Depth and colour are raycast at any
+		    resolution, with optional sensor-like noise: depth noise
+		    growing quadratically with distance, quantisation to
+		    millimetres, random dropouts and dropouts at grazing
+		    angles. All noise is a function of the seed, the frame
+		    number and the pixel, so every run of a scene produces
+		    exactly the same frames, independently of the number of
+		    threads used for rendering.
+
+		    Since the true camera poses are known, the source can be
+		    used to measure both speed and accuracy of the pipeline
+		    without any sensor or dataset, see
+		    @ref getGroundTruthPose().
+
+		    Scenes are either set up through @ref Settings or read from
+		    a text file, see @ref loadSceneFile() for its format.
+		*/
+		class SyntheticSceneSource : public ImageSourceEngine
+		{
+		public:
+			struct Primitive
+			{
+				typedef enum {
+					/// Infinite plane of points p with dot(a, p) = radius, a is normalised on loading
+					PRIMITIVE_PLANE,
+					/// Sphere around a
+					PRIMITIVE_SPHERE,
+					/// Axis aligned box spanned by the corners a and b
+					PRIMITIVE_BOX,
+					/// Closed cylinder with the centres of its caps at a and b
+					PRIMITIVE_CYLINDER
+				} Type;
+
+				Type type;
+				Vector3f a, b;
+				float radius;
+				/// Albedo in [0, 1]
+				Vector3f colour;
+			};
+
+			/// Camera position and the point it looks at; the camera is kept upright, with +y pointing up in the scene
+			struct Keyframe
+			{
+				int frameNo;
+				Vector3f eye, target;
+			};
+
+			struct Settings
+			{
+				Vector2i imgSize;
+				/// fx, fy, cx, cy; if fx is not positive, a field of view similar to a Kinect is derived from imgSize
+				Vector4f intrinsics;
+				int noFrames;
+				double frameRate;
+
+				/// Seed of all noise
+				unsigned int seed;
+				/// Standard deviation of the depth noise in metres is depthNoise.x + depthNoise.y * (z - 0.4)^2
+				Vector2f depthNoise;
+				/// Depths outside of this range in metres are invalid
+				Vector2f depthRange;
+				/// Fraction of depth pixels dropped at random
+				float dropoutRate;
+				/// Depth is dropped if the cosine of the angle between ray and surface normal is below this value
+				float grazingLimit;
+				/// Standard deviation of the colour noise in intensity levels
+				float rgbNoise;
+				/// Edge length of the checkerboard texture in metres, 0 for plain colours
+				float textureScale;
+
+				std::vector<Primitive> primitives;
+				/// Poses are interpolated smoothly between keyframes and held constant before the first and after the last one
+				std::vector<Keyframe> trajectory;
+
+				/// Sets up a room with some objects and a camera circling them, at 640x480 with moderate noise
+				Settings(void);
+			};
+
+		private:
+			Settings settings;
+			int currentFrameNo;
+			Matrix4f firstPose;
+
+			Matrix4f getScenePose(int frameNo) const;
+			void setup(void);
+
+		public:
+			/// Renders the scene described in @p sceneFile; if @p imgSize is not zero, it replaces the size given in the file
+			SyntheticSceneSource(const char *sceneFile, Vector2i imgSize = Vector2i(0, 0));
+			explicit SyntheticSceneSource(const Settings & settings);
+			~SyntheticSceneSource() { }
+
+			/** Reads a scene from a text file. Each line holds one
+			    keyword and its parameters; '#' starts a comment:
+
+			    ITMSCENE                                      (required first line)
+			    size <width> <height>
+			    intrinsics <fx> <fy> <cx> <cy>
+			    frames <number of frames>
+			    rate <frames per second>
+			    seed <seed>
+			    depth_noise <sigma at 0.4m> <quadratic coefficient>
+			    depth_range <min> <max>
+			    dropout <rate> <grazing limit>
+			    rgb_noise <sigma>
+			    texture <checker size>
+			    plane <nx> <ny> <nz> <offset> <r> <g> <b>
+			    sphere <x> <y> <z> <radius> <r> <g> <b>
+			    box <x0> <y0> <z0> <x1> <y1> <z1> <r> <g> <b>
+			    cylinder <x0> <y0> <z0> <x1> <y1> <z1> <radius> <r> <g> <b>
+			    keyframe <frame> <eye x> <eye y> <eye z> <target x> <target y> <target z>
+			    orbit <x> <y> <z> <radius> <height> <turns>
+
+			    Settings that are not given keep the defaults of
+			    @ref Settings, but the default scene is replaced as
+			    soon as the file contains any primitive or camera
+			    motion. "orbit" adds keyframes circling the given point
+			    at the given radius and height above it over all frames
+			    of the sequence.
+			*/
+			static bool loadSceneFile(const char *fileName, Settings & settings);
+			/// Checks whether @p fileName starts with the signature of a scene file
+			static bool isSceneFile(const char *fileName);
+
+			/// Appends keyframes to @p settings, circling @p centre @p turns times during the whole sequence
+			static void addOrbit(Settings & settings, Vector3f centre, float radius, float height, float turns);
+
+			bool hasMoreImages(void) { return currentFrameNo < settings.noFrames; }
+			void getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
+			Vector2i getDepthImageSize(void) { return settings.imgSize; }
+			Vector2i getRGBImageSize(void) { return settings.imgSize; }
+
+			const Settings & getSettings(void) const { return settings; }
+
+			int getNumberOfFrames(void) const { return settings.noFrames; }
+			/// Number of the frame returned by the next call to getImages()
+			int getCurrentFrame(void) const { return currentFrameNo; }
+			void setCurrentFrame(int frameNo) { currentFrameNo = frameNo; }
+
+			double getTimestamp(int frameNo) const { return frameNo / settings.frameRate; }
+
+			/** True pose of frame @p frameNo, as the world to camera
+			    transformation of ITMPose::GetM(). Poses are given
+			    relative to the first frame, which is the coordinate
+			    system the tracker estimates poses in, so the pose of
+			    frame 0 is the identity.
+			*/
+			Matrix4f getGroundTruthPose(int frameNo) const;
+
+			/// Writes the ground truth trajectory of all frames in the format of the TUM RGB-D benchmark
+			bool saveGroundTruth(const char *fileName) const;
+		};
+	}
+}
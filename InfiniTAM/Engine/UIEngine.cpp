@@ -172,6 +172,33 @@ void UIEngine::glutKeyUpFunction(unsigned char key, int x, int y)
 			uiEngine->isRecording = true;
 		}
 		break;
+	case 'v':
+		if (uiEngine->sequenceRecorder != NULL)
+		{
+			printf("stopped recording sequence, %d frames ...\n", uiEngine->sequenceRecorder->getNumberOfFrames());
+			delete uiEngine->sequenceRecorder;
+			uiEngine->sequenceRecorder = NULL;
+		}
+		else
+		{
+			char str[250];
+			sprintf(str, "%s/sequence_%03d.seq", uiEngine->outFolder, uiEngine->currentSequenceNo++);
+
+			uiEngine->sequenceRecorder = new SequenceRecorder(str, uiEngine->imageSource->calib, uiEngine->imageSource->getRGBImageSize(),
+				uiEngine->imageSource->getDepthImageSize(), uiEngine->imuSource != NULL);
+			if (uiEngine->sequenceRecorder->isOpen())
+			{
+				printf("started recording sequence %s ...\n", str);
+				sdkResetTimer(&uiEngine->timer_recording);
+				sdkStartTimer(&uiEngine->timer_recording);
+			}
+			else
+			{
+				delete uiEngine->sequenceRecorder;
+				uiEngine->sequenceRecorder = NULL;
+			}
+		}
+		break;
 	case 'e':
 	case 27: // esc key
 		printf("exiting ...\n");
@@ -372,6 +399,9 @@ void UIEngine::Initialise(int & argc, char** argv, ImageSourceEngine *imageSourc
 	this->isRecording = false;
 	this->currentFrameNo = 0;
 
+	this->sequenceRecorder = NULL;
+	this->currentSequenceNo = 0;
+
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE);
 	glutInitWindowSize(winSize.x, winSize.y);
@@ -420,6 +450,7 @@ void UIEngine::Initialise(int & argc, char** argv, ImageSourceEngine *imageSourc
 
 	sdkCreateTimer(&timer_instant);
 	sdkCreateTimer(&timer_average);
+	sdkCreateTimer(&timer_recording);
 
 	sdkResetTimer(&timer_average);
 
@@ -466,6 +497,12 @@ void UIEngine::ProcessFrame()
 		}
 	}
 
+	if (sequenceRecorder != NULL)
+	{
+		double timestamp = sdkGetTimerValue(&timer_recording) / 1000.0;
+		sequenceRecorder->addFrame(inputRGBImage, inputRawDepthImage, (imuSource != NULL) ? inputIMUMeasurement : NULL, timestamp);
+	}
+
 	sdkResetTimer(&timer_instant);
 	sdkStartTimer(&timer_instant); sdkStartTimer(&timer_average);
 
@@ -489,6 +526,9 @@ void UIEngine::Shutdown()
 {
 	sdkDeleteTimer(&timer_instant);
 	sdkDeleteTimer(&timer_average);
+	sdkDeleteTimer(&timer_recording);
+
+	if (sequenceRecorder != NULL) delete sequenceRecorder;
 
 	for (int w = 0; w < NUM_WIN; w++)
 		delete outImage[w];
@@ -9,6 +9,7 @@
 
 #include "ImageSourceEngine.h"
 #include "IMUSourceEngine.h"
+#include "SequenceFile.h"
 
 #include <vector>
 
@@ -63,6 +64,11 @@ namespace InfiniTAM
 			Vector2i mouseLastClick;
 
 			int currentFrameNo; bool isRecording;
+
+			// recording into a sequence file with compressed depth
+			SequenceRecorder *sequenceRecorder;
+			StopWatchInterface *timer_recording;
+			int currentSequenceNo;
 		public:
 			static UIEngine* Instance(void) {
 				if (instance == NULL) instance = new UIEngine();
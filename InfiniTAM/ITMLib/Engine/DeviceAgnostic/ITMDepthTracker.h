@@ -104,3 +104,32 @@ _CPU_AND_GPU_CODE_ inline bool computePerPointGH_Depth(THREADPTR(float) *localNa
 	return true;
 }
 
+
+/// Bin of the surface normal at (x, y) of the depth image for normal space sampling, with noBinsPerAxis^2 bins over its x and y components. Returns -1
+/// where there is no reliable normal, i.e. next to holes and depth discontinuities.
+_CPU_AND_GPU_CODE_ inline int computeNormalBin_Depth(const THREADPTR(int) & x, const THREADPTR(int) & y, const CONSTPTR(float) *depth,
+	const CONSTPTR(Vector2i) & imgSize, const CONSTPTR(Vector4f) & intrinsics, int noBinsPerAxis)
+{
+	if ((x >= imgSize.x - 1) || (y >= imgSize.y - 1)) return -1;
+
+	float d = depth[x + y * imgSize.x], d_x = depth[(x + 1) + y * imgSize.x], d_y = depth[x + (y + 1) * imgSize.x];
+	if ((d <= 1e-8f) || (d_x <= 1e-8f) || (d_y <= 1e-8f)) return -1;
+	if ((fabs(d_x - d) > 0.05f * d) || (fabs(d_y - d) > 0.05f * d)) return -1;
+
+	Vector3f point, point_x, point_y;
+	point.x = d * ((float(x) - intrinsics.z) / intrinsics.x); point.y = d * ((float(y) - intrinsics.w) / intrinsics.y); point.z = d;
+	point_x.x = d_x * ((float(x + 1) - intrinsics.z) / intrinsics.x); point_x.y = d_x * ((float(y) - intrinsics.w) / intrinsics.y); point_x.z = d_x;
+	point_y.x = d_y * ((float(x) - intrinsics.z) / intrinsics.x); point_y.y = d_y * ((float(y + 1) - intrinsics.w) / intrinsics.y); point_y.z = d_y;
+
+	Vector3f normal = cross(point_x - point, point_y - point);
+	float normalLength = length(normal);
+	if (normalLength <= 1e-12f) return -1;
+
+	// facing the camera, so that the z component follows from x and y
+	normal /= (dot(normal, point) > 0.0f) ? -normalLength : normalLength;
+
+	int binX = (int)((normal.x + 1.0f) * 0.5f * noBinsPerAxis), binY = (int)((normal.y + 1.0f) * 0.5f * noBinsPerAxis);
+	binX = MIN(MAX(binX, 0), noBinsPerAxis - 1); binY = MIN(MAX(binY, 0), noBinsPerAxis - 1);
+
+	return binX + binY * noBinsPerAxis;
+}
@@ -6,15 +6,14 @@
 #include "ITMPixelUtils.h"
 
 
+/// computes the Jacobian @p A, weighted by @p localWeight, and the unweighted residual @p b of a point
 template<bool shortIteration, bool rotationOnly>
-_CPU_AND_GPU_CODE_ inline bool computePerPointGH_wICP(THREADPTR(float) *localNabla, THREADPTR(float) *localHessian, THREADPTR(float) &localF, THREADPTR(float) &localWeight,
+_CPU_AND_GPU_CODE_ inline bool computePerPointGH_wICP_Ab(THREADPTR(float) *A, THREADPTR(float) &b, const THREADPTR(float) &localWeight,
 	const THREADPTR(int) & x, const THREADPTR(int) & y,
 	const CONSTPTR(float) &depth, const CONSTPTR(Vector2i) & viewImageSize, const CONSTPTR(Vector4f) & viewIntrinsics, const CONSTPTR(Vector2i) & sceneImageSize,
 	const CONSTPTR(Vector4f) & sceneIntrinsics, const CONSTPTR(Matrix4f) & approxInvPose, const CONSTPTR(Matrix4f) & scenePose, const CONSTPTR(Vector4f) *pointsMap,
 	const CONSTPTR(Vector4f) *normalsMap, float distThresh)
 {
-	const int noPara = shortIteration ? 3 : 6;
-
 	//////////////////////////////////////////////////////////////////////////
 	// new depth missing
 	//////////////////////////////////////////////////////////////////////////
@@ -22,7 +21,6 @@ _CPU_AND_GPU_CODE_ inline bool computePerPointGH_wICP(THREADPTR(float) *localNab
 
 	Vector4f tmp3Dpoint, tmp3Dpoint_reproj; Vector3f ptDiff;
 	Vector4f curr3Dpoint, corr3Dnormal; Vector2f tmp2Dpoint;
-	float A[noPara];
 
 	tmp3Dpoint.x = depth * ((float(x) - viewIntrinsics.z) / viewIntrinsics.x);
 	tmp3Dpoint.y = depth * ((float(y) - viewIntrinsics.w) / viewIntrinsics.y);
@@ -65,8 +63,7 @@ _CPU_AND_GPU_CODE_ inline bool computePerPointGH_wICP(THREADPTR(float) *localNab
 	corr3Dnormal = interpolateBilinear_withHoles(normalsMap, tmp2Dpoint, sceneImageSize);
 		//if (corr3Dnormal.w < 0.0f) return false;
 	
-	float b = corr3Dnormal.x * ptDiff.x + corr3Dnormal.y * ptDiff.y + corr3Dnormal.z * ptDiff.z;
-	localF += b * b * localWeight * localWeight;
+	b = corr3Dnormal.x * ptDiff.x + corr3Dnormal.y * ptDiff.y + corr3Dnormal.z * ptDiff.z;
 
 	corr3Dnormal *= localWeight;
 
@@ -92,6 +89,27 @@ _CPU_AND_GPU_CODE_ inline bool computePerPointGH_wICP(THREADPTR(float) *localNab
 		A[!shortIteration ? 3 : 0] = corr3Dnormal.x; A[!shortIteration ? 4 : 1] = corr3Dnormal.y; A[!shortIteration ? 5 : 2] = corr3Dnormal.z;
 	}
 
+	return true;
+}
+
+template<bool shortIteration, bool rotationOnly>
+_CPU_AND_GPU_CODE_ inline bool computePerPointGH_wICP(THREADPTR(float) *localNabla, THREADPTR(float) *localHessian, THREADPTR(float) &localF, THREADPTR(float) &localWeight,
+	const THREADPTR(int) & x, const THREADPTR(int) & y,
+	const CONSTPTR(float) &depth, const CONSTPTR(Vector2i) & viewImageSize, const CONSTPTR(Vector4f) & viewIntrinsics, const CONSTPTR(Vector2i) & sceneImageSize,
+	const CONSTPTR(Vector4f) & sceneIntrinsics, const CONSTPTR(Matrix4f) & approxInvPose, const CONSTPTR(Matrix4f) & scenePose, const CONSTPTR(Vector4f) *pointsMap,
+	const CONSTPTR(Vector4f) *normalsMap, float distThresh)
+{
+	const int noPara = shortIteration ? 3 : 6;
+	float A[noPara];
+	float b;
+
+	bool ret = computePerPointGH_wICP_Ab<shortIteration, rotationOnly>(A, b, localWeight, x, y, depth, viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics,
+		approxInvPose, scenePose, pointsMap, normalsMap, distThresh);
+
+	if (!ret) return false;
+
+	localF += b * b * localWeight * localWeight;
+
 #if (defined(__CUDACC__) && defined(__CUDA_ARCH__)) || (defined(__METALC__))
 #pragma unroll
 #endif
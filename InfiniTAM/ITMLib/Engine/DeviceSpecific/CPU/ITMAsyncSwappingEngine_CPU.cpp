@@ -0,0 +1,233 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMAsyncSwappingEngine_CPU.h"
+#include "../../DeviceAgnostic/ITMSwappingEngine.h"
+#include "../../../Objects/ITMRenderState_VH.h"
+
+using namespace ITMLib::Engine;
+
+/// Moves the blocks of one set of transfer buffers into and out of the global cache
+template<class TVoxel>
+class ITMAsyncSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::TransferJob : public ITMWorkerThread::Job
+{
+public:
+	ITMGlobalCache<TVoxel> *globalCache;
+	int bufferId, noSwappedOut, noSwappedIn;
+
+	void Execute(void)
+	{
+		TVoxel *syncedVoxelBlocks = globalCache->GetHostSyncedVoxelBlocks(bufferId);
+		bool *hasSyncedData = globalCache->GetHostHasSyncedData(bufferId);
+		int *neededEntryIDs = globalCache->GetHostNeededEntryIDs(bufferId);
+
+		// stores first, a block can be requested again in the same set it has been swapped out in
+		for (int i = 0; i < noSwappedOut; i++)
+			globalCache->SetStoredData(neededEntryIDs[i], syncedVoxelBlocks + i * SDF_BLOCK_SIZE3);
+
+		for (int i = SDF_TRANSFER_BLOCK_NUM - noSwappedIn; i < SDF_TRANSFER_BLOCK_NUM; i++)
+			hasSyncedData[i] = globalCache->GetStoredData(neededEntryIDs[i], syncedVoxelBlocks + i * SDF_BLOCK_SIZE3);
+	}
+};
+
+template<class TVoxel>
+ITMAsyncSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::ITMAsyncSwappingEngine_CPU(void)
+{
+	for (int bufferId = 0; bufferId < 2; bufferId++) noSwappedOut[bufferId] = noSwappedIn[bufferId] = 0;
+	fillingBufferId = 0;
+	isTransferRunning = false;
+
+	hasStoredData = NULL;
+
+	transferJob = new TransferJob();
+	transferThread = new ITMWorkerThread();
+}
+
+template<class TVoxel>
+ITMAsyncSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::~ITMAsyncSwappingEngine_CPU(void)
+{
+	// waits for the running transfer, the scene has to outlive this engine
+	delete transferThread;
+	delete transferJob;
+
+	if (hasStoredData != NULL) free(hasStoredData);
+}
+
+template<class TVoxel>
+void ITMAsyncSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::Initialise(ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	if (hasStoredData != NULL) return;
+
+	ITMGlobalCache<TVoxel> *globalCache = scene->globalCache;
+	globalCache->AllocateSecondTransferBuffers();
+
+	hasStoredData = (uchar*)malloc(globalCache->noTotalEntries);
+	for (int entryId = 0; entryId < globalCache->noTotalEntries; entryId++) hasStoredData[entryId] = globalCache->HasStoredData(entryId);
+}
+
+template<class TVoxel>
+void ITMAsyncSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::CollectSwappedIn(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState)
+{
+	if (!isTransferRunning || transferThread->IsBusy()) return;
+	isTransferRunning = false;
+
+	ITMGlobalCache<TVoxel> *globalCache = scene->globalCache;
+	int bufferId = 1 - fillingBufferId;
+
+	ITMHashSwapState *swapStates = globalCache->GetSwapStates(false);
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	uchar *entriesVisibleType = ((ITMRenderState_VH*)renderState)->GetEntriesVisibleType();
+	std::vector<int> &swapOutCandidates = globalCache->GetSwapOutCandidates();
+
+	TVoxel *syncedVoxelBlocks = globalCache->GetHostSyncedVoxelBlocks(bufferId);
+	bool *hasSyncedData = globalCache->GetHostHasSyncedData(bufferId);
+	int *neededEntryIDs = globalCache->GetHostNeededEntryIDs(bufferId);
+
+	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	int maxW = scene->sceneParams->maxW;
+
+	for (int i = SDF_TRANSFER_BLOCK_NUM - noSwappedIn[bufferId]; i < SDF_TRANSFER_BLOCK_NUM; i++)
+	{
+		int entryDestId = neededEntryIDs[i];
+
+		// blocks in state 3 are not swapped out, so they are still where they were when requested
+		if (hasSyncedData[i])
+		{
+			TVoxel *srcVB = syncedVoxelBlocks + i * SDF_BLOCK_SIZE3;
+			TVoxel *dstVB = localVBA + hashTable[entryDestId].ptr * SDF_BLOCK_SIZE3;
+
+			for (int vIdx = 0; vIdx < SDF_BLOCK_SIZE3; vIdx++)
+			{
+				CombineVoxelInformation<TVoxel::hasColorInformation, TVoxel>::compute(srcVB[vIdx], dstVB[vIdx], maxW);
+			}
+		}
+
+		swapStates[entryDestId].state = 2;
+		if (entriesVisibleType[entryDestId] == 0) swapOutCandidates.push_back(entryDestId);
+	}
+
+	noSwappedOut[bufferId] = noSwappedIn[bufferId] = 0;
+}
+
+template<class TVoxel>
+void ITMAsyncSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::RequestSwapIn(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState)
+{
+	ITMGlobalCache<TVoxel> *globalCache = scene->globalCache;
+	int bufferId = fillingBufferId;
+
+	ITMHashSwapState *swapStates = globalCache->GetSwapStates(false);
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	uchar *entriesVisibleType = ((ITMRenderState_VH*)renderState)->GetEntriesVisibleType();
+	std::vector<int> &swapInCandidates = globalCache->GetSwapInCandidates();
+	std::vector<int> &swapOutCandidates = globalCache->GetSwapOutCandidates();
+
+	int *neededEntryIDs = globalCache->GetHostNeededEntryIDs(bufferId);
+
+	// candidates that cannot be requested yet are kept for the next frame
+	size_t noKeptCandidates = 0;
+	for (size_t candidateId = 0; candidateId < swapInCandidates.size(); candidateId++)
+	{
+		int entryId = swapInCandidates[candidateId];
+		if (swapStates[entryId].state != 1) continue;
+
+		// nothing to wait for
+		if (!hasStoredData[entryId])
+		{
+			swapStates[entryId].state = 2;
+			if (entriesVisibleType[entryId] == 0) swapOutCandidates.push_back(entryId);
+			continue;
+		}
+
+		if (hashTable[entryId].ptr < 0 || noSwappedOut[bufferId] + noSwappedIn[bufferId] >= SDF_TRANSFER_BLOCK_NUM)
+		{
+			swapInCandidates[noKeptCandidates++] = entryId;
+			continue;
+		}
+
+		noSwappedIn[bufferId]++;
+		neededEntryIDs[SDF_TRANSFER_BLOCK_NUM - noSwappedIn[bufferId]] = entryId;
+		swapStates[entryId].state = 3;
+	}
+	swapInCandidates.resize(noKeptCandidates);
+}
+
+template<class TVoxel>
+void ITMAsyncSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateGlobalIntoLocal(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState)
+{
+	Initialise(scene);
+
+	CollectSwappedIn(scene, renderState);
+	RequestSwapIn(scene, renderState);
+}
+
+template<class TVoxel>
+void ITMAsyncSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState)
+{
+	Initialise(scene);
+
+	CollectSwappedIn(scene, renderState);
+
+	ITMGlobalCache<TVoxel> *globalCache = scene->globalCache;
+	int bufferId = fillingBufferId;
+
+	ITMHashSwapState *swapStates = globalCache->GetSwapStates(false);
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	uchar *entriesVisibleType = ((ITMRenderState_VH*)renderState)->GetEntriesVisibleType();
+	std::vector<int> &swapOutCandidates = globalCache->GetSwapOutCandidates();
+
+	TVoxel *syncedVoxelBlocks = globalCache->GetHostSyncedVoxelBlocks(bufferId);
+	int *neededEntryIDs = globalCache->GetHostNeededEntryIDs(bufferId);
+
+	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	int noAllocatedVoxelEntries = scene->localVBA.lastFreeBlockId;
+
+	// candidates that do not fit into the set stay in the list for the next frame
+	size_t candidateId = 0;
+	for (; candidateId < swapOutCandidates.size(); candidateId++)
+	{
+		if (noSwappedOut[bufferId] + noSwappedIn[bufferId] >= SDF_TRANSFER_BLOCK_NUM) break;
+
+		int entryDestId = swapOutCandidates[candidateId];
+		int localPtr = hashTable[entryDestId].ptr;
+
+		if (swapStates[entryDestId].state == 2 && localPtr >= 0 && entriesVisibleType[entryDestId] == 0)
+		{
+			TVoxel *localVBALocation = localVBA + localPtr * SDF_BLOCK_SIZE3;
+
+			neededEntryIDs[noSwappedOut[bufferId]] = entryDestId;
+			memcpy(syncedVoxelBlocks + noSwappedOut[bufferId] * SDF_BLOCK_SIZE3, localVBALocation, SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+			noSwappedOut[bufferId]++;
+
+			swapStates[entryDestId].state = 0;
+			hasStoredData[entryDestId] = 1;
+
+			int vbaIdx = noAllocatedVoxelEntries;
+			if (vbaIdx < SDF_BUCKET_NUM - 1)
+			{
+				noAllocatedVoxelEntries++;
+				voxelAllocationList[vbaIdx + 1] = localPtr;
+				hashTable[entryDestId].ptr = -1;
+
+				for (int i = 0; i < SDF_BLOCK_SIZE3; i++) localVBALocation[i] = TVoxel();
+			}
+		}
+	}
+	swapOutCandidates.erase(swapOutCandidates.begin(), swapOutCandidates.begin() + candidateId);
+
+	scene->localVBA.lastFreeBlockId = noAllocatedVoxelEntries;
+
+	// hand the set over once the other one has been collected, otherwise it is filled further in the next frame
+	if (!isTransferRunning && noSwappedOut[bufferId] + noSwappedIn[bufferId] > 0)
+	{
+		transferJob->globalCache = globalCache;
+		transferJob->bufferId = bufferId;
+		transferJob->noSwappedOut = noSwappedOut[bufferId];
+		transferJob->noSwappedIn = noSwappedIn[bufferId];
+
+		transferThread->Run(transferJob);
+		isTransferRunning = true;
+		fillingBufferId = 1 - bufferId;
+	}
+}
+
+template class ITMLib::Engine::ITMAsyncSwappingEngine_CPU<ITMVoxel, ITMVoxelIndex>;
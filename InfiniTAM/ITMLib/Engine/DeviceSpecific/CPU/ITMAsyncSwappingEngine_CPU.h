@@ -0,0 +1,81 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../../ITMSwappingEngine.h"
+#include "../../../Utils/ITMWorkerThread.h"
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		template<class TVoxel, class TIndex>
+		class ITMAsyncSwappingEngine_CPU : public ITMSwappingEngine < TVoxel, TIndex >
+		{
+		public:
+			void IntegrateGlobalIntoLocal(ITMScene<TVoxel, TIndex> *scene, ITMRenderState *renderState) {}
+			void SaveToGlobalMemory(ITMScene<TVoxel, TIndex> *scene, ITMRenderState *renderState) {}
+		};
+
+		/** \brief
+		    Swapping between the active scene and the ITMGlobalCache
+		    on the CPU, with all work on the cache done on a
+		    background thread.
+
+		    The calling thread only moves blocks between the scene and
+		    one of two sets of transfer buffers, and never waits for
+		    the cache. Blocks that leave the view are copied into the
+		    set that is being filled, and blocks that come back into
+		    view and have data in the cache are requested there, with
+		    their swap state set to 3. Once the background thread is
+		    idle, the set is handed to it: it first stores the blocks
+		    swapped out, then decodes the requested ones, while the
+		    calling thread fills the other set. The requested blocks
+		    are merged into the scene at the first call after the
+		    background thread has finished, and are not integrated
+		    into until then.
+
+		    IntegrateGlobalIntoLocal() should be called before the new
+		    frame is integrated, SaveToGlobalMemory() after it.
+		*/
+		template<class TVoxel>
+		class ITMAsyncSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash> : public ITMSwappingEngine < TVoxel, ITMVoxelBlockHash >
+		{
+		private:
+			class TransferJob;
+
+			/// number of blocks swapped out, placed from the start of a set, and swapped in, placed from its end
+			int noSwappedOut[2], noSwappedIn[2];
+			int fillingBufferId;
+			bool isTransferRunning;
+
+			/// entries that have been swapped out at least once, and thus have data in the global cache
+			uchar *hasStoredData;
+
+			TransferJob *transferJob;
+			ITMWorkerThread *transferThread;
+
+			void Initialise(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
+
+			/// merges the blocks of the last transfer into the scene, if it has finished
+			void CollectSwappedIn(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState);
+
+			/// requests the swap-in candidates that have data in the global cache
+			void RequestSwapIn(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState);
+
+		public:
+			void IntegrateGlobalIntoLocal(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState);
+			void SaveToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState);
+
+			/// Waits for the running transfer. Its swapped in blocks are still merged at the next call
+			void Wait(void) { transferThread->Wait(); }
+
+			ITMAsyncSwappingEngine_CPU(void);
+			~ITMAsyncSwappingEngine_CPU(void);
+
+			// Suppress the default copy constructor and assignment operator
+			ITMAsyncSwappingEngine_CPU(const ITMAsyncSwappingEngine_CPU&);
+			ITMAsyncSwappingEngine_CPU& operator=(const ITMAsyncSwappingEngine_CPU&);
+		};
+	}
+}
@@ -2,78 +2,171 @@
 
 #include "ITMDepthTracker_CPU.h"
 #include "../../DeviceAgnostic/ITMDepthTracker.h"
+#include "../../../Utils/ITMProfiler.h"
+
+#include <algorithm>
 
 using namespace ITMLib::Engine;
 
 ITMDepthTracker_CPU::ITMDepthTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, int noICPRunTillLevel,
-	float distThresh, float terminationThreshold, const ITMLowLevelEngine *lowLevelEngine) :ITMDepthTracker(imgSize, trackingRegime, noHierarchyLevels,
-	noICPRunTillLevel, distThresh, terminationThreshold, lowLevelEngine, MEMORYDEVICE_CPU) { }
+	float distThresh, float terminationThreshold, float timeBudget, int pointBudget, const ITMLowLevelEngine *lowLevelEngine) :ITMDepthTracker(imgSize,
+	trackingRegime, noHierarchyLevels, noICPRunTillLevel, distThresh, terminationThreshold, timeBudget, lowLevelEngine, MEMORYDEVICE_CPU)
+{
+	this->pointBudget = pointBudget;
+	this->usesSelectedPoints = false;
+}
 
 ITMDepthTracker_CPU::~ITMDepthTracker_CPU(void) { }
 
-int ITMDepthTracker_CPU::ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose)
+void ITMDepthTracker_CPU::SelectPoints(void)
 {
-	Vector4f *pointsMap = sceneHierarchyLevel->pointsMap->GetData(MEMORYDEVICE_CPU);
-	Vector4f *normalsMap = sceneHierarchyLevel->normalsMap->GetData(MEMORYDEVICE_CPU);
-	Vector4f sceneIntrinsics = sceneHierarchyLevel->intrinsics;
-	Vector2i sceneImageSize = sceneHierarchyLevel->pointsMap->noDims;
+	usesSelectedPoints = false;
+	if (pointBudget <= 0) return;
 
-	float *depth = viewHierarchyLevel->depth->GetData(MEMORYDEVICE_CPU);
+	const float *depth = viewHierarchyLevel->depth->GetData(MEMORYDEVICE_CPU);
 	Vector4f viewIntrinsics = viewHierarchyLevel->intrinsics;
 	Vector2i viewImageSize = viewHierarchyLevel->depth->noDims;
+	int noPixels = viewImageSize.x * viewImageSize.y;
 
-	if (iterationType == TRACKER_ITERATION_NONE) return 0;
+	pointBins.resize(noPixels);
+	int *pointBins_ptr = &pointBins[0];
+	int noValidPixels = 0;
 
-	bool shortIteration = (iterationType == TRACKER_ITERATION_ROTATION) || (iterationType == TRACKER_ITERATION_TRANSLATION);
+#ifdef WITH_OPENMP
+	#pragma omp parallel for reduction(+:noValidPixels)
+#endif
+	for (int y = 0; y < viewImageSize.y; y++) for (int x = 0; x < viewImageSize.x; x++)
+	{
+		int locId = x + y * viewImageSize.x;
+		if (depth[locId] > 1e-8f) noValidPixels++;
+		pointBins_ptr[locId] = computeNormalBin_Depth(x, y, depth, viewImageSize, viewIntrinsics, NO_NORMAL_BINS_PER_AXIS);
+	}
 
-	float sumHessian[6 * 6], sumNabla[6], sumF; int noValidPoints;
-	int noPara = shortIteration ? 3 : 6, noParaSQ = shortIteration ? 3 + 2 + 1 : 6 + 5 + 4 + 3 + 2 + 1;
+	if (noValidPixels <= pointBudget) return;
 
-	noValidPoints = 0; sumF = 0.0f;
-	memset(sumHessian, 0, sizeof(float) * noParaSQ);
-	memset(sumNabla, 0, sizeof(float) * noPara);
+	const int noBins = NO_NORMAL_BINS_PER_AXIS * NO_NORMAL_BINS_PER_AXIS;
+	int binCounts[noBins], sortedBinCounts[noBins], binQuotas[noBins], binErrors[noBins];
 
-	for (int y = 0; y < viewImageSize.y; y++) for (int x = 0; x < viewImageSize.x; x++)
+	for (int binId = 0; binId < noBins; binId++) binCounts[binId] = binErrors[binId] = 0;
+	for (int locId = 0; locId < noPixels; locId++) if (pointBins_ptr[locId] >= 0) binCounts[pointBins_ptr[locId]]++;
+
+	// bins smaller than an equal share of what is left of the budget are taken completely, the others get that share
+	for (int binId = 0; binId < noBins; binId++) sortedBinCounts[binId] = binCounts[binId];
+	std::sort(sortedBinCounts, sortedBinCounts + noBins);
+
+	int share = noPixels, remainingBudget = pointBudget;
+	for (int i = 0; i < noBins; i++)
 	{
-		float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
+		if (sortedBinCounts[i] * (noBins - i) > remainingBudget) { share = remainingBudget / (noBins - i); break; }
+		remainingBudget -= sortedBinCounts[i];
+	}
+	for (int binId = 0; binId < noBins; binId++) binQuotas[binId] = MIN(binCounts[binId], share);
 
-		for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
-		for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
+	// evenly spaced pixels of every bin, in the manner of Bresenham's line algorithm
+	selectedPoints.clear();
+	for (int locId = 0; locId < noPixels; locId++)
+	{
+		int binId = pointBins_ptr[locId];
+		if (binId < 0) continue;
 
-		bool isValidPoint;
-        
-		switch (iterationType)
+		binErrors[binId] += binQuotas[binId];
+		if (binErrors[binId] >= binCounts[binId])
 		{
-		case TRACKER_ITERATION_ROTATION:
-			isValidPoint = computePerPointGH_Depth<true, true>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		case TRACKER_ITERATION_TRANSLATION:
-			isValidPoint = computePerPointGH_Depth<true, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		case TRACKER_ITERATION_BOTH:
-			isValidPoint = computePerPointGH_Depth<false, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		default:
-			isValidPoint = false;
-			break;
+			binErrors[binId] -= binCounts[binId];
+			selectedPoints.push_back(locId);
 		}
+	}
+
+	// without any normals, e.g. on a very coarse level, all pixels are used
+	usesSelectedPoints = !selectedPoints.empty();
+	if (usesSelectedPoints && (levelId == 0)) ITMProfiler::Count(ITMProfiler::COUNTER_ICP_POINTS, (double)selectedPoints.size());
+}
 
-		if (isValidPoint)
+/** Sums the normal equations into @p partialSums, one part per row of the view image or, with @p selectedPoints, per
+@p noPointsPerPart selected points. Parts do not depend on each other.
+*/
+template<bool shortIteration, bool rotationOnly>
+static void computePartialSums_Depth(ITMICPPartialSums *partialSums, int noParts, const int *selectedPoints, int noSelectedPoints, int noPointsPerPart,
+	const float *depth, Vector2i viewImageSize, Vector4f viewIntrinsics, Vector2i sceneImageSize, Vector4f sceneIntrinsics, Matrix4f approxInvPose,
+	Matrix4f scenePose, const Vector4f *pointsMap, const Vector4f *normalsMap, float distThresh)
+{
+	const int noPara = shortIteration ? 3 : 6;
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int partId = 0; partId < noParts; partId++)
+	{
+		ITMICPAccumulator_CPU<noPara> accumulator;
+		float A[noPara], b;
+
+		if (selectedPoints == NULL)
+		{
+			int y = partId;
+			for (int x = 0; x < viewImageSize.x; x++)
+			{
+				if (computePerPointGH_Depth_Ab<shortIteration, rotationOnly>(A, b, x, y, depth[x + y * viewImageSize.x], viewImageSize, viewIntrinsics,
+					sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh))
+					accumulator.Add(A, b, b * b);
+			}
+		}
+		else
 		{
-			noValidPoints++; sumF += localF;
-			for (int i = 0; i < noPara; i++) sumNabla[i] += localNabla[i];
-			for (int i = 0; i < noParaSQ; i++) sumHessian[i] += localHessian[i];
+			int lastPointId = MIN((partId + 1) * noPointsPerPart, noSelectedPoints);
+			for (int pointId = partId * noPointsPerPart; pointId < lastPointId; pointId++)
+			{
+				int locId = selectedPoints[pointId];
+				int x = locId % viewImageSize.x, y = locId / viewImageSize.x;
+
+				if (computePerPointGH_Depth_Ab<shortIteration, rotationOnly>(A, b, x, y, depth[locId], viewImageSize, viewIntrinsics,
+					sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh))
+					accumulator.Add(A, b, b * b);
+			}
 		}
+
+		accumulator.Store(partialSums[partId]);
 	}
+}
+
+int ITMDepthTracker_CPU::ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose)
+{
+	Vector4f *pointsMap = sceneHierarchyLevel->pointsMap->GetData(MEMORYDEVICE_CPU);
+	Vector4f *normalsMap = sceneHierarchyLevel->normalsMap->GetData(MEMORYDEVICE_CPU);
+	Vector4f sceneIntrinsics = sceneHierarchyLevel->intrinsics;
+	Vector2i sceneImageSize = sceneHierarchyLevel->pointsMap->noDims;
 
-	for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++) hessian[r + c * 6] = sumHessian[counter];
-	for (int r = 0; r < noPara; ++r) for (int c = r + 1; c < noPara; c++) hessian[r + c * 6] = hessian[c + r * 6];
-	
-	memcpy(nabla, sumNabla, noPara * sizeof(float));
-	f = (noValidPoints > 100) ? sqrt(sumF) / noValidPoints : 1e5f;
+	float *depth = viewHierarchyLevel->depth->GetData(MEMORYDEVICE_CPU);
+	Vector4f viewIntrinsics = viewHierarchyLevel->intrinsics;
+	Vector2i viewImageSize = viewHierarchyLevel->depth->noDims;
+
+	if (iterationType == TRACKER_ITERATION_NONE) return 0;
+
+	bool shortIteration = (iterationType == TRACKER_ITERATION_ROTATION) || (iterationType == TRACKER_ITERATION_TRANSLATION);
+	int noPara = shortIteration ? 3 : 6;
+
+	const int *selectedPoints_ptr = usesSelectedPoints ? &selectedPoints[0] : NULL;
+	int noSelectedPoints = usesSelectedPoints ? (int)selectedPoints.size() : 0;
+	int noParts = usesSelectedPoints ? (noSelectedPoints + NO_POINTS_PER_PART - 1) / NO_POINTS_PER_PART : viewImageSize.y;
+
+	if ((int)partialSums.size() < noParts) partialSums.resize(noParts);
+
+	switch (iterationType)
+	{
+	case TRACKER_ITERATION_ROTATION:
+		computePartialSums_Depth<true, true>(&partialSums[0], noParts, selectedPoints_ptr, noSelectedPoints, NO_POINTS_PER_PART, depth, viewImageSize,
+			viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+		break;
+	case TRACKER_ITERATION_TRANSLATION:
+		computePartialSums_Depth<true, false>(&partialSums[0], noParts, selectedPoints_ptr, noSelectedPoints, NO_POINTS_PER_PART, depth, viewImageSize,
+			viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+		break;
+	case TRACKER_ITERATION_BOTH:
+		computePartialSums_Depth<false, false>(&partialSums[0], noParts, selectedPoints_ptr, noSelectedPoints, NO_POINTS_PER_PART, depth, viewImageSize,
+			viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+		break;
+	default:
+		break;
+	}
 
-	return noValidPoints;
+	return combineICPPartialSums(partialSums, noParts, noPara, f, nabla, hessian);
 }
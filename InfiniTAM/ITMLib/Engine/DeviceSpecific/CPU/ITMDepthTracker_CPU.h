@@ -3,20 +3,51 @@
 #pragma once
 
 #include "../../ITMDepthTracker.h"
+#include "ITMICPAccumulator_CPU.h"
 
 namespace ITMLib
 {
 	namespace Engine
 	{
+		/** \brief
+		    ICP depth tracker on the CPU.
+
+		    With a point budget, the points of each level are chosen
+		    by normal space sampling: the valid pixels are binned by
+		    the direction of their surface normal, and the budget is
+		    spread as evenly as possible over the bins, taking evenly
+		    spaced pixels within each bin. The few pixels on surfaces
+		    of rare orientation, which constrain the pose in
+		    directions the large planes do not, are thus all kept,
+		    while the cost of an iteration no longer depends on the
+		    image resolution. Levels with no more valid pixels than
+		    the budget use all of them.
+		*/
 		class ITMDepthTracker_CPU : public ITMDepthTracker
 		{
+		private:
+			static const int NO_NORMAL_BINS_PER_AXIS = 8;
+			static const int NO_POINTS_PER_PART = 256;
+
+			/// sums of every row of the view image, or of every part of the selected points, computed in parallel and added up in order
+			std::vector<ITMICPPartialSums> partialSums;
+
+			/// maximum number of points per level, 0 to use all pixels
+			int pointBudget;
+			bool usesSelectedPoints;
+			/// pixel indices of the points of the current level, in raster order
+			std::vector<int> selectedPoints;
+			/// normal bin of every pixel of the current level, -1 for none
+			std::vector<int> pointBins;
+
 		protected:
+			void SelectPoints(void);
 			int ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose);
 
 		public:
 			ITMDepthTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, int noICPRunTillLevel, float distThresh,
-				float terminationThreshold, const ITMLowLevelEngine *lowLevelEngine);
+				float terminationThreshold, float timeBudget, int pointBudget, const ITMLowLevelEngine *lowLevelEngine);
 			~ITMDepthTracker_CPU(void);
 		};
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,149 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <vector>
+
+#include "../../../Utils/ITMLibDefines.h"
+
+// the CPU engines are host code only, builds with ITM_WITHOUT_SSE defined use the scalar loop
+#if !defined(ITM_WITHOUT_SSE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ITM_ICP_ACCUMULATOR_SSE
+#include <emmintrin.h>
+#endif
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/// Sums of the normal equations of an ICP iteration over a part of the points
+		struct ITMICPPartialSums
+		{
+			/// lower triangle of the Hessian, row by row
+			float hessian[6 + 5 + 4 + 3 + 2 + 1];
+			float nabla[6];
+			float f;
+			int noValidPoints;
+		};
+
+		/** \brief
+		    Accumulates the normal equations of an ICP iteration with
+		    @p noPara parameters on the CPU.
+
+		    Every point adds the outer product of its augmented
+		    Jacobian (A | b) with itself, which holds A^T A and b A
+		    at once. With SSE each row of that product takes one
+		    register for three parameters and two for six, so a
+		    point costs a few multiply-adds instead of the scalar
+		    loop over the lower triangle. The error is summed
+		    separately, as the weighted tracker does not use b^2.
+		*/
+		template<int noPara>
+		class ITMICPAccumulator_CPU
+		{
+		private:
+#ifdef ITM_ICP_ACCUMULATOR_SSE
+			static const int NO_REGISTERS = (noPara + 1 + 3) / 4;
+
+			/// rows 0 to noPara of the outer product, the upper triangle is computed as well but never read
+			__m128 rows[noPara + 1][NO_REGISTERS];
+#else
+			float hessian[noPara * (noPara + 1) / 2], nabla[noPara];
+#endif
+			float f;
+			int noValidPoints;
+
+		public:
+			ITMICPAccumulator_CPU(void) { Reset(); }
+
+			void Reset(void)
+			{
+#ifdef ITM_ICP_ACCUMULATOR_SSE
+				for (int r = 0; r <= noPara; r++) for (int i = 0; i < NO_REGISTERS; i++) rows[r][i] = _mm_setzero_ps();
+#else
+				for (int i = 0; i < noPara * (noPara + 1) / 2; i++) hessian[i] = 0.0f;
+				for (int i = 0; i < noPara; i++) nabla[i] = 0.0f;
+#endif
+				f = 0.0f; noValidPoints = 0;
+			}
+
+			/// Adds a point with Jacobian @p A, residual @p b and error @p localF
+			inline void Add(const float *A, float b, float localF)
+			{
+#ifdef ITM_ICP_ACCUMULATOR_SSE
+				float v[4 * NO_REGISTERS];
+				for (int i = 0; i < noPara; i++) v[i] = A[i];
+				v[noPara] = b;
+				for (int i = noPara + 1; i < 4 * NO_REGISTERS; i++) v[i] = 0.0f;
+
+				__m128 columns[NO_REGISTERS];
+				for (int i = 0; i < NO_REGISTERS; i++) columns[i] = _mm_loadu_ps(v + 4 * i);
+
+				for (int r = 0; r <= noPara; r++)
+				{
+					__m128 vr = _mm_set1_ps(v[r]);
+					for (int i = 0; i < NO_REGISTERS; i++) rows[r][i] = _mm_add_ps(rows[r][i], _mm_mul_ps(vr, columns[i]));
+				}
+#else
+				for (int r = 0, counter = 0; r < noPara; r++)
+				{
+					nabla[r] += b * A[r];
+					for (int c = 0; c <= r; c++, counter++) hessian[counter] += A[r] * A[c];
+				}
+#endif
+				f += localF; noValidPoints++;
+			}
+
+			/// Writes the sums to @p sums, in the layout used for @p noPara parameters
+			void Store(ITMICPPartialSums &sums) const
+			{
+#ifdef ITM_ICP_ACCUMULATOR_SSE
+				float row[4 * NO_REGISTERS];
+				for (int r = 0, counter = 0; r <= noPara; r++)
+				{
+					for (int i = 0; i < NO_REGISTERS; i++) _mm_storeu_ps(row + 4 * i, rows[r][i]);
+
+					if (r < noPara) for (int c = 0; c <= r; c++, counter++) sums.hessian[counter] = row[c];
+					else for (int c = 0; c < noPara; c++) sums.nabla[c] = row[c];
+				}
+#else
+				for (int i = 0; i < noPara * (noPara + 1) / 2; i++) sums.hessian[i] = hessian[i];
+				for (int i = 0; i < noPara; i++) sums.nabla[i] = nabla[i];
+#endif
+				sums.f = f; sums.noValidPoints = noValidPoints;
+			}
+		};
+
+		/** Adds up @p parts in order, so that the result does not depend on how many threads computed
+		them, and writes the full Hessian and the gradient as ComputeGandH() returns them. Returns the
+		number of valid points.
+		*/
+		inline int combineICPPartialSums(const std::vector<ITMICPPartialSums> &parts, int noParts, int noPara, float &f, float *nabla, float *hessian)
+		{
+			int noParaSQ = noPara * (noPara + 1) / 2;
+			double sumHessian[6 + 5 + 4 + 3 + 2 + 1], sumNabla[6], sumF = 0.0;
+			int noValidPoints = 0;
+
+			for (int i = 0; i < noParaSQ; i++) sumHessian[i] = 0.0;
+			for (int i = 0; i < noPara; i++) sumNabla[i] = 0.0;
+
+			for (int partId = 0; partId < noParts; partId++)
+			{
+				const ITMICPPartialSums &part = parts[partId];
+				if (part.noValidPoints == 0) continue;
+
+				noValidPoints += part.noValidPoints; sumF += part.f;
+				for (int i = 0; i < noPara; i++) sumNabla[i] += part.nabla[i];
+				for (int i = 0; i < noParaSQ; i++) sumHessian[i] += part.hessian[i];
+			}
+
+			for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++) hessian[r + c * 6] = (float)sumHessian[counter];
+			for (int r = 0; r < noPara; ++r) for (int c = r + 1; c < noPara; c++) hessian[r + c * 6] = hessian[c + r * 6];
+
+			for (int i = 0; i < noPara; i++) nabla[i] = (float)sumNabla[i];
+			f = (noValidPoints > 100) ? sqrt((float)sumF) / noValidPoints : 1e5f;
+
+			return noValidPoints;
+		}
+	}
+}
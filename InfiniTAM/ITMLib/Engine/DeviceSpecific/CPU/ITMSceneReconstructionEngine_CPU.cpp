@@ -3,6 +3,9 @@
 #include "ITMSceneReconstructionEngine_CPU.h"
 #include "../../DeviceAgnostic/ITMSceneReconstructionEngine.h"
 #include "../../../Objects/ITMRenderState_VH.h"
+#include "../../../Utils/ITMProfiler.h"
+
+#include <algorithm>
 
 using namespace ITMLib::Engine;
 
@@ -12,6 +15,7 @@ ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ITMSceneReconstructi
 	int noTotalEntries = ITMVoxelBlockHash::noTotalEntries;
 	entriesAllocType = new ORUtils::MemoryBlock<unsigned char>(noTotalEntries, MEMORYDEVICE_CPU);
 	blockCoords = new ORUtils::MemoryBlock<Vector4s>(noTotalEntries, MEMORYDEVICE_CPU);
+	maxNoPredictedBlocks = 0;
 }
 
 template<class TVoxel>
@@ -27,7 +31,11 @@ void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ResetScene(ITMS
 	int numBlocks = scene->index.getNumAllocatedVoxelBlocks();
 	int blockSize = scene->index.getVoxelBlockSize();
 
+	// static schedule, roughly the same threads touch the same pages as when the memory was cleared, see ORUtils::clearHostData()
 	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(static)
+#endif
 	for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
 	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
 	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
@@ -37,7 +45,11 @@ void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ResetScene(ITMS
 	memset(&tmpEntry, 0, sizeof(ITMHashEntry));
 	tmpEntry.ptr = -2;
 	ITMHashEntry *hashEntry_ptr = scene->index.GetEntries();
-	for (int i = 0; i < scene->index.noTotalEntries; ++i) hashEntry_ptr[i] = tmpEntry;
+	int noTotalEntries = scene->index.noTotalEntries;
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int i = 0; i < noTotalEntries; ++i) hashEntry_ptr[i] = tmpEntry;
 	int *excessList_ptr = scene->index.GetExcessAllocationList();
 	for (int i = 0; i < SDF_EXCESS_LIST_SIZE; ++i) excessList_ptr[i] = i;
 
@@ -72,10 +84,12 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoS
 
 	int *visibleEntryIds = renderState_vh->GetVisibleEntryIDs();
 	int noVisibleEntries = renderState_vh->noVisibleEntries;
+	const ITMHashSwapState *swapStates = scene->useSwapping ? scene->globalCache->GetSwapStates(false) : 0;
 
 	bool stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
 	//bool approximateIntegration = !trackingState->requiresFullRendering;
 
+	ITMProfiler::ScopedTraceEvent trace("integrate_blocks", "omp");
 #ifdef WITH_OPENMP
 	#pragma omp parallel for
 #endif
@@ -86,6 +100,9 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoS
 
 		if (currentHashEntry.ptr < 0) continue;
 
+		// the old data of the block is still on its way back from the global cache
+		if (swapStates != 0 && swapStates[visibleEntryIds[entryId]].state == 3) continue;
+
 		globalPos.x = currentHashEntry.pos.x;
 		globalPos.y = currentHashEntry.pos.y;
 		globalPos.z = currentHashEntry.pos.z;
@@ -141,6 +158,8 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 	int *excessAllocationList = scene->index.GetExcessAllocationList();
 	ITMHashEntry *hashTable = scene->index.GetEntries();
 	ITMHashSwapState *swapStates = scene->useSwapping ? scene->globalCache->GetSwapStates(false) : 0;
+	std::vector<int> *swapInCandidates = scene->useSwapping ? &scene->globalCache->GetSwapInCandidates() : 0;
+	std::vector<int> *swapOutCandidates = scene->useSwapping ? &scene->globalCache->GetSwapOutCandidates() : 0;
 	int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
 	uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
 	uchar *entriesAllocType = this->entriesAllocType->GetData(MEMORYDEVICE_CPU);
@@ -162,19 +181,30 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 		entriesVisibleType[visibleEntryIDs[i]] = 3; // visible at previous frame and unstreamed
 
 	//build hashVisibility
+	{
+		ITMProfiler::ScopedTraceEvent trace("build_hash_visibility", "omp");
 #ifdef WITH_OPENMP
-	#pragma omp parallel for
+		#pragma omp parallel for
 #endif
-	for (int locId = 0; locId < depthImgSize.x*depthImgSize.y; locId++)
-	{
-		int y = locId / depthImgSize.x;
-		int x = locId - y * depthImgSize.x;
-		buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
-			invProjParams_d, mu, depthImgSize, oneOverVoxelSize, hashTable, scene->sceneParams->viewFrustum_min,
-			scene->sceneParams->viewFrustum_max);
+		for (int locId = 0; locId < depthImgSize.x*depthImgSize.y; locId++)
+		{
+			int y = locId / depthImgSize.x;
+			int x = locId - y * depthImgSize.x;
+			buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
+				invProjParams_d, mu, depthImgSize, oneOverVoxelSize, hashTable, scene->sceneParams->viewFrustum_min,
+				scene->sceneParams->viewFrustum_max);
+		}
 	}
 
 	if (onlyUpdateVisibleList) useSwapping = false;
+
+	// swapped out blocks close enough to the predicted camera to be visible from it, with the block diagonal as margin
+	bool usePrediction = useSwapping && maxNoPredictedBlocks > 0;
+	int noPredictedBlocks = 0, noLateBlocks = 0;
+	predictedBlocks.clear();
+	float blockSize = voxelSize * SDF_BLOCK_SIZE;
+	float maxPredictedDepth = scene->sceneParams->viewFrustum_max + blockSize * 1.7320508f;
+
 	if (!onlyUpdateVisibleList)
 	{
 		//allocate
@@ -243,17 +273,46 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 			if (useSwapping)
 			{
 				checkBlockVisibility<true>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
+
+				// blocks brought back for the predicted pose are kept until they leave its view as well
+				if (!isVisibleEnlarged && usePrediction)
+					checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, predictedM_d, projParams_d, voxelSize, depthImgSize);
+
 				if (!isVisibleEnlarged) hashVisibleType = 0;
 			} else {
 				checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
 				if (!isVisible) { hashVisibleType = 0; }
 			}
 			entriesVisibleType[targetIdx] = hashVisibleType;
+
+			// the visible list is also updated without swapping, but what leaves the view has to be swapped out all the same
+			if (hashVisibleType == 0 && swapStates != 0 && swapStates[targetIdx].state == 2) swapOutCandidates->push_back(targetIdx);
 		}
 
 		if (useSwapping)
 		{
-			if (hashVisibleType > 0 && swapStates[targetIdx].state != 2) swapStates[targetIdx].state = 1;
+			// found in the depth image while the data is still swapped out, or on its way back
+			if ((hashVisibleType == 1 || hashVisibleType == 2) && (hashEntry.ptr == -1 || swapStates[targetIdx].state == 3)) noLateBlocks++;
+
+			// candidates only, the budget goes to the ones closest to the predicted camera below
+			if (hashVisibleType == 0 && hashEntry.ptr == -1 && usePrediction)
+			{
+				Vector4f pt_block((hashEntry.pos.x + 0.5f) * blockSize, (hashEntry.pos.y + 0.5f) * blockSize, (hashEntry.pos.z + 0.5f) * blockSize, 1.0f);
+				Vector4f pt_camera = predictedM_d * pt_block;
+
+				if (pt_camera.z < maxPredictedDepth && pt_camera.z > -blockSize)
+				{
+					bool isVisible, isVisibleEnlarged;
+					checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, predictedM_d, projParams_d, voxelSize, depthImgSize);
+					if (isVisible) predictedBlocks.push_back(std::make_pair(pt_camera.x * pt_camera.x + pt_camera.y * pt_camera.y + pt_camera.z * pt_camera.z, targetIdx));
+				}
+			}
+
+			if (hashVisibleType > 0 && swapStates[targetIdx].state == 0)
+			{
+				swapStates[targetIdx].state = 1;
+				swapInCandidates->push_back(targetIdx);
+			}
 		}
 
 		if (hashVisibleType > 0)
@@ -272,15 +331,37 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 #endif
 	}
 
-	//reallocate deleted ones from previous swap operation
+	if (usePrediction)
+	{
+		noPredictedBlocks = std::min((int)predictedBlocks.size(), maxNoPredictedBlocks);
+		std::partial_sort(predictedBlocks.begin(), predictedBlocks.begin() + noPredictedBlocks, predictedBlocks.end());
+
+		for (int i = 0; i < noPredictedBlocks; i++)
+		{
+			int targetIdx = predictedBlocks[i].second;
+
+			// as if found swapped out in the depth image, it is reallocated and swapped in below
+			entriesVisibleType[targetIdx] = 2;
+			if (swapStates[targetIdx].state == 0)
+			{
+				swapStates[targetIdx].state = 1;
+				swapInCandidates->push_back(targetIdx);
+			}
+
+			visibleEntryIDs[noVisibleEntries] = targetIdx;
+			noVisibleEntries++;
+		}
+	}
+
+	//reallocate deleted ones from previous swap operation, all entries with entriesVisibleType > 0 are in the visible list
 	if (useSwapping)
 	{
-		for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
+		for (int visibleId = 0; visibleId < noVisibleEntries; visibleId++)
 		{
-			int vbaIdx;
+			int vbaIdx, targetIdx = visibleEntryIDs[visibleId];
 			ITMHashEntry hashEntry = hashTable[targetIdx];
 
-			if (entriesVisibleType[targetIdx] > 0 && hashEntry.ptr == -1) 
+			if (hashEntry.ptr == -1) 
 			{
 				vbaIdx = lastFreeVoxelBlockId; lastFreeVoxelBlockId--;
 				if (vbaIdx >= 0) hashTable[targetIdx].ptr = voxelAllocationList[vbaIdx];
@@ -292,6 +373,12 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 
 	scene->localVBA.lastFreeBlockId = lastFreeVoxelBlockId;
 	scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
+
+	if (useSwapping)
+	{
+		ITMProfiler::Count(ITMProfiler::COUNTER_LATE_BLOCKS, noLateBlocks);
+		if (usePrediction) ITMProfiler::Count(ITMProfiler::COUNTER_PREDICTED_BLOCKS, noPredictedBlocks);
+	}
 }
 
 template<class TVoxel>
@@ -308,7 +395,11 @@ void ITMSceneReconstructionEngine_CPU<TVoxel,ITMPlainVoxelArray>::ResetScene(ITM
 	int numBlocks = scene->index.getNumAllocatedVoxelBlocks();
 	int blockSize = scene->index.getVoxelBlockSize();
 
+	// static schedule, roughly the same threads touch the same pages as when the memory was cleared, see ORUtils::clearHostData()
 	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(static)
+#endif
 	for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
 	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
 	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
@@ -348,6 +439,7 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 	bool stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
 	//bool approximateIntegration = !trackingState->requiresFullRendering;
 
+	ITMProfiler::ScopedTraceEvent trace("integrate_array", "omp");
 #ifdef WITH_OPENMP
 	#pragma omp parallel for
 #endif
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "../../ITMSceneReconstructionEngine.h"
 
 namespace ITMLib
@@ -19,6 +21,13 @@ namespace ITMLib
 			ORUtils::MemoryBlock<unsigned char> *entriesAllocType;
 			ORUtils::MemoryBlock<Vector4s> *blockCoords;
 
+			/// predicted pose of the depth camera for prefetching, and the number of blocks that may be requested per frame because of it
+			Matrix4f predictedM_d;
+			int maxNoPredictedBlocks;
+
+			/// swapped out blocks visible from the predicted pose, with their squared distance to its camera
+			std::vector<std::pair<float, int> > predictedBlocks;
+
 		public:
 			void ResetScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
 
@@ -28,6 +37,8 @@ namespace ITMLib
 			void IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMView *view, const ITMTrackingState *trackingState,
 				const ITMRenderState *renderState);
 
+			void SetPredictedPose(const Matrix4f &M_d, int maxNoBlocks) { predictedM_d = M_d; maxNoPredictedBlocks = maxNoBlocks; }
+
 			ITMSceneReconstructionEngine_CPU(void);
 			~ITMSceneReconstructionEngine_CPU(void);
 		};
@@ -29,18 +29,23 @@ int ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 	bool *hasSyncedData_global = globalCache->GetHasSyncedData(false);
 	int *neededEntryIDs_global = globalCache->GetNeededEntryIDs(false);
 
-	int noTotalEntries = globalCache->noTotalEntries;
+	std::vector<int> &swapInCandidates = globalCache->GetSwapInCandidates();
 
+	// candidates that are not taken now because of SDF_TRANSFER_BLOCK_NUM stay in the list for the next frame
 	int noNeededEntries = 0;
-	for (int entryId = 0; entryId < noTotalEntries; entryId++)
+	size_t candidateId = 0;
+	for (; candidateId < swapInCandidates.size(); candidateId++)
 	{
 		if (noNeededEntries >= SDF_TRANSFER_BLOCK_NUM) break;
+
+		int entryId = swapInCandidates[candidateId];
 		if (swapStates[entryId].state == 1)
 		{
 			neededEntryIDs_local[noNeededEntries] = entryId;
 			noNeededEntries++;
 		}
 	}
+	swapInCandidates.erase(swapInCandidates.begin(), swapInCandidates.begin() + candidateId);
 
 	// would copy neededEntryIDs_local into neededEntryIDs_global here
 
@@ -55,7 +60,7 @@ int ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 			if (globalCache->HasStoredData(entryId))
 			{
 				hasSyncedData_global[i] = true;
-				memcpy(syncedVoxelBlocks_global + i * SDF_BLOCK_SIZE3, globalCache->GetStoredVoxelBlock(entryId), SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+				globalCache->GetStoredData(entryId, syncedVoxelBlocks_global + i * SDF_BLOCK_SIZE3);
 			}
 		}
 	}
@@ -79,6 +84,8 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateGlobalIntoLocal(
 	int *neededEntryIDs_local = globalCache->GetNeededEntryIDs(false);
 
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	uchar *entriesVisibleType = ((ITMRenderState_VH*)renderState)->GetEntriesVisibleType();
+	std::vector<int> &swapOutCandidates = globalCache->GetSwapOutCandidates();
 
 	int noNeededEntries = this->LoadFromGlobalMemory(scene);
 
@@ -100,6 +107,9 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateGlobalIntoLocal(
 		}
 
 		swapStates[entryDestId].state = 2;
+
+		// blocks that left the view while they were waiting to be swapped in
+		if (entriesVisibleType[entryDestId] == 0) swapOutCandidates.push_back(entryDestId);
 	}
 }
 
@@ -124,15 +134,18 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
 	int *voxelAllocationList = scene->localVBA.GetAllocationList();
 
-	int noTotalEntries = globalCache->noTotalEntries;
+	std::vector<int> &swapOutCandidates = globalCache->GetSwapOutCandidates();
 	
 	int noNeededEntries = 0;
 	int noAllocatedVoxelEntries = scene->localVBA.lastFreeBlockId;
 
-	for (int entryDestId = 0; entryDestId < noTotalEntries; entryDestId++)
+	// candidates that are not taken now because of SDF_TRANSFER_BLOCK_NUM stay in the list for the next frame
+	size_t candidateId = 0;
+	for (; candidateId < swapOutCandidates.size(); candidateId++)
 	{
 		if (noNeededEntries >= SDF_TRANSFER_BLOCK_NUM) break;
 
+		int entryDestId = swapOutCandidates[candidateId];
 		int localPtr = hashTable[entryDestId].ptr;
 		ITMHashSwapState &swapState = swapStates[entryDestId];
 
@@ -161,6 +174,8 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 		}
 	}
 
+	swapOutCandidates.erase(swapOutCandidates.begin(), swapOutCandidates.begin() + candidateId);
+
 	scene->localVBA.lastFreeBlockId = noAllocatedVoxelEntries;
 
 	// would copy neededEntryIDs_local, hasSyncedData_local and syncedVoxelBlocks_local into *_global here
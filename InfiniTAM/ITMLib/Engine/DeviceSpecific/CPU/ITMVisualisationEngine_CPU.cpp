@@ -5,6 +5,7 @@
 #include "../../DeviceAgnostic/ITMVisualisationEngine.h"
 #include "../../DeviceAgnostic/ITMSceneReconstructionEngine.h"
 #include "../../../Objects/ITMRenderState_VH.h"
+#include "../../../Utils/ITMProfiler.h"
 
 #include <vector>
 
@@ -172,6 +173,7 @@ static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i&
 	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
 
+	ITMProfiler::ScopedTraceEvent trace("raycast", "omp");
 #ifdef WITH_OPENMP
 	#pragma omp parallel for
 #endif
@@ -226,12 +228,13 @@ static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPo
 	if ((type == IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME)&&
 	    (!TVoxel::hasColorInformation)) type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE;
 
+	ITMProfiler::ScopedTraceEvent trace("render_image", "omp");
 	switch (type) {
 	case IITMVisualisationEngine::RENDER_CUSTOM:
+		std::cout << "Process custom rendering ... " << std::endl;
 #ifdef WITH_OPENMP
-#pragma omp parallel for
+		#pragma omp parallel for
 #endif
-		std::cout << "Process custom rendering ... " << std::endl;
 		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
 		{
 			Vector4f ptRay = pointsRay[locId];
@@ -311,6 +314,7 @@ static void CreateICPMaps_common(const ITMScene<TVoxel,TIndex> *scene, const ITM
 	Vector4f *pointsRay = renderState->raycastResult->GetData(MEMORYDEVICE_CPU);
 	float voxelSize = scene->sceneParams->voxelSize;
 
+	ITMProfiler::ScopedTraceEvent trace("icp_maps", "omp");
 #ifdef WITH_OPENMP
 	#pragma omp parallel for
 #endif
@@ -11,6 +11,35 @@ ITMWeightedICPTracker_CPU::ITMWeightedICPTracker_CPU(Vector2i imgSize, TrackerIt
 
 ITMWeightedICPTracker_CPU::~ITMWeightedICPTracker_CPU(void) { }
 
+/// sums the weighted normal equations of the points of every row of the view image into @p rowSums, rows do not depend on each other
+template<bool shortIteration, bool rotationOnly>
+static void computeRowSums_wICP(ITMICPPartialSums *rowSums, const float *depth, const float *weight, float minSigmaZ, Vector2i viewImageSize,
+	Vector4f viewIntrinsics, Vector2i sceneImageSize, Vector4f sceneIntrinsics, Matrix4f approxInvPose, Matrix4f scenePose, const Vector4f *pointsMap,
+	const Vector4f *normalsMap, float distThresh)
+{
+	const int noPara = shortIteration ? 3 : 6;
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int y = 0; y < viewImageSize.y; y++)
+	{
+		ITMICPAccumulator_CPU<noPara> accumulator;
+
+		for (int x = 0; x < viewImageSize.x; x++)
+		{
+			float localWeight = weight[x + y*viewImageSize.x] > 0 ? minSigmaZ / weight[x + y*viewImageSize.x] * 0.5f + 0.5f : 0.0f;
+			float A[noPara], b;
+
+			if (computePerPointGH_wICP_Ab<shortIteration, rotationOnly>(A, b, localWeight, x, y, depth[x + y * viewImageSize.x], viewImageSize,
+				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh))
+				accumulator.Add(A, b, b * b * localWeight * localWeight);
+		}
+
+		accumulator.Store(rowSums[y]);
+	}
+}
+
 int ITMWeightedICPTracker_CPU::ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose)
 {
 	Vector4f *pointsMap = sceneHierarchyLevel->pointsMap->GetData(MEMORYDEVICE_CPU);
@@ -29,58 +58,27 @@ int ITMWeightedICPTracker_CPU::ComputeGandH(float &f, float *nabla, float *hessi
 	if (iterationType == TRACKER_ITERATION_NONE) return 0;
 
 	bool shortIteration = (iterationType == TRACKER_ITERATION_ROTATION) || (iterationType == TRACKER_ITERATION_TRANSLATION);
+	int noPara = shortIteration ? 3 : 6;
 
-	float sumHessian[6 * 6], sumNabla[6], sumF; int noValidPoints;
-	int noPara = shortIteration ? 3 : 6, noParaSQ = shortIteration ? 3 + 2 + 1 : 6 + 5 + 4 + 3 + 2 + 1;
+	if ((int)rowSums.size() < viewImageSize.y) rowSums.resize(viewImageSize.y);
 
-	noValidPoints = 0; sumF = 0.0f;
-	memset(sumHessian, 0, sizeof(float) * noParaSQ);
-	memset(sumNabla, 0, sizeof(float) * noPara);
-
-
-	for (int y = 0; y < viewImageSize.y; y++) for (int x = 0; x < viewImageSize.x; x++)
+	switch (iterationType)
 	{
-		float localWeight = weight[x + y*viewImageSize.x] > 0 ? minSigmaZ / weight[x + y*viewImageSize.x] * 0.5f + 0.5f : 0.0f;
-
-		float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
-
-		for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
-		for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
-
-		bool isValidPoint;
-        
-		switch (iterationType)
-		{
-		case TRACKER_ITERATION_ROTATION:
-			isValidPoint = computePerPointGH_wICP<true, true>(localNabla, localHessian, localF, localWeight, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		case TRACKER_ITERATION_TRANSLATION:
-			isValidPoint = computePerPointGH_wICP<true, false>(localNabla, localHessian, localF, localWeight, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		case TRACKER_ITERATION_BOTH:
-			isValidPoint = computePerPointGH_wICP<false, false>(localNabla, localHessian, localF, localWeight, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		default:
-			isValidPoint = false;
-			break;
-		}
-
-		if (isValidPoint)
-		{
-			noValidPoints++; sumF += localF;
-			for (int i = 0; i < noPara; i++) sumNabla[i] += localNabla[i];
-			for (int i = 0; i < noParaSQ; i++) sumHessian[i] += localHessian[i];
-		}
+	case TRACKER_ITERATION_ROTATION:
+		computeRowSums_wICP<true, true>(&rowSums[0], depth, weight, minSigmaZ, viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics,
+			approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+		break;
+	case TRACKER_ITERATION_TRANSLATION:
+		computeRowSums_wICP<true, false>(&rowSums[0], depth, weight, minSigmaZ, viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics,
+			approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+		break;
+	case TRACKER_ITERATION_BOTH:
+		computeRowSums_wICP<false, false>(&rowSums[0], depth, weight, minSigmaZ, viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics,
+			approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+		break;
+	default:
+		break;
 	}
 
-	for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++) hessian[r + c * 6] = sumHessian[counter];
-	for (int r = 0; r < noPara; ++r) for (int c = r + 1; c < noPara; c++) hessian[r + c * 6] = hessian[c + r * 6];
-	
-	memcpy(nabla, sumNabla, noPara * sizeof(float));
-	f = (noValidPoints > 100) ? sqrt(sumF) / noValidPoints : 1e5f;
-
-	return noValidPoints;
+	return combineICPPartialSums(rowSums, viewImageSize.y, noPara, f, nabla, hessian);
 }
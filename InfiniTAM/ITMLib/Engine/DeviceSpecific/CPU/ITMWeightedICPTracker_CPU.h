@@ -3,6 +3,7 @@
 #pragma once
 
 #include "../../ITMWeightedICPTracker.h"
+#include "ITMICPAccumulator_CPU.h"
 
 namespace ITMLib
 {
@@ -10,6 +11,10 @@ namespace ITMLib
 	{
 		class ITMWeightedICPTracker_CPU : public ITMWeightedICPTracker
 		{
+		private:
+			/// sums of every row of the view image, computed in parallel and added up in order
+			std::vector<ITMICPPartialSums> rowSums;
+
 		protected:
 			int ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose);
 
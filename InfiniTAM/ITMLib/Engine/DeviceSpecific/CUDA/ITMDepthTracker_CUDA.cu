@@ -34,8 +34,8 @@ __global__ void depthTrackerOneLevel_g_rt_device(ITMDepthTracker_KernelParameter
 // host methods
 
 ITMDepthTracker_CUDA::ITMDepthTracker_CUDA(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, int noICPRunTillLevel,
-	float distThresh, float terminationThreshold, const ITMLowLevelEngine *lowLevelEngine)
-	:ITMDepthTracker(imgSize, trackingRegime, noHierarchyLevels, noICPRunTillLevel, distThresh, terminationThreshold, lowLevelEngine, MEMORYDEVICE_CUDA)
+	float distThresh, float terminationThreshold, float timeBudget, const ITMLowLevelEngine *lowLevelEngine)
+	:ITMDepthTracker(imgSize, trackingRegime, noHierarchyLevels, noICPRunTillLevel, distThresh, terminationThreshold, timeBudget, lowLevelEngine, MEMORYDEVICE_CUDA)
 {
 	ITMSafeCall(cudaMallocHost((void**)&accu_host, sizeof(AccuCell)));
 	ITMSafeCall(cudaMalloc((void**)&accu_device, sizeof(AccuCell)));
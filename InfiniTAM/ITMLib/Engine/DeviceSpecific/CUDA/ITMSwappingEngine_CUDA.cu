@@ -78,7 +78,7 @@ int ITMSwappingEngine_CUDA<TVoxel,ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 			if (globalCache->HasStoredData(entryId))
 			{
 				hasSyncedData_global[i] = true;
-				memcpy(syncedVoxelBlocks_global + i * SDF_BLOCK_SIZE3, globalCache->GetStoredVoxelBlock(entryId), SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+				globalCache->GetStoredData(entryId, syncedVoxelBlocks_global + i * SDF_BLOCK_SIZE3);
 			}
 		}
 
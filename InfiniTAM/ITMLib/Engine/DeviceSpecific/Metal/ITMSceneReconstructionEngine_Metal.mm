@@ -157,6 +157,8 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
     int *excessAllocationList = scene->index.GetExcessAllocationList();
     ITMHashEntry *hashTable = scene->index.GetEntries();
     ITMHashSwapState *swapStates = scene->useSwapping ? scene->globalCache->GetSwapStates(false) : 0;
+    std::vector<int> *swapInCandidates = scene->useSwapping ? &scene->globalCache->GetSwapInCandidates() : 0;
+    std::vector<int> *swapOutCandidates = scene->useSwapping ? &scene->globalCache->GetSwapOutCandidates() : 0;
     int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
     uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
     uchar *entriesAllocType = this->entriesAllocType->GetData(MEMORYDEVICE_CPU);
@@ -253,11 +255,18 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
                 if (!isVisible) { hashVisibleType = 0; }
             }
             entriesVisibleType[targetIdx] = hashVisibleType;
+            
+            // see ITMSceneReconstructionEngine_CPU, the swapping engine only looks at these candidates
+            if (hashVisibleType == 0 && swapStates != 0 && swapStates[targetIdx].state == 2) swapOutCandidates->push_back(targetIdx);
         }
         
         if (useSwapping)
         {
-            if (hashVisibleType > 0 && swapStates[targetIdx].state != 2) swapStates[targetIdx].state = 1;
+            if (hashVisibleType > 0 && swapStates[targetIdx].state == 0)
+            {
+                swapStates[targetIdx].state = 1;
+                swapInCandidates->push_back(targetIdx);
+            }
         }
         
         if (hashVisibleType > 0)
@@ -13,6 +13,8 @@ ITMColorTracker::ITMColorTracker(Vector2i imgSize, TrackerIterationType *trackin
 	const ITMLowLevelEngine *lowLevelEngine, MemoryDeviceType memoryType)
 {
 	viewHierarchy = new ITMImageHierarchy<ITMViewHierarchyLevel>(imgSize, trackingRegime, noHierarchyLevels, memoryType);
+	// the pyramid is only held during TrackCamera(), other trackers can use the pooled images in between
+	viewHierarchy->ReleaseData();
 
 	this->lowLevelEngine = lowLevelEngine;
 }
@@ -26,6 +28,7 @@ void ITMColorTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 {
 	this->view = view; this->trackingState = trackingState;
 
+	viewHierarchy->AcquireData();
 	this->PrepareForEvaluation(view);
 
 	ITMPose currentPara(view->calib->trafo_rgb_to_depth.calib_inv * trackingState->pose_d->GetM());
@@ -43,6 +46,8 @@ void ITMColorTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 
 	trackingState->pose_d->Coerce();
 
+	viewHierarchy->ReleaseData();
+
 	//printf(">> %f %f %f %f %f %f\n", scene->pose->params.each.rx, scene->pose->params.each.ry, scene->pose->params.each.rz,
 	//	scene->pose->params.each.tx, scene->pose->params.each.ty, scene->pose->params.each.tz);
 }
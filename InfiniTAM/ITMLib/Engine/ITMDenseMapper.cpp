@@ -5,6 +5,7 @@
 #include "../Objects/ITMRenderState_VH.h"
 
 #include "../ITMLib.h"
+#include "../Utils/ITMProfiler.h"
 
 using namespace ITMLib::Engine;
 
@@ -12,12 +13,21 @@ template<class TVoxel, class TIndex>
 ITMDenseMapper<TVoxel, TIndex>::ITMDenseMapper(const ITMLibSettings *settings)
 {
 	swappingEngine = NULL;
+	swapInBeforeIntegration = false;
+	prefetchFrames = settings->useSwapping ? settings->swappingPrefetchFrames : 0;
+	prefetchBlockBudget = settings->swappingPrefetchBlockBudget;
+	hasLastPose = false;
 
 	switch (settings->deviceType)
 	{
 	case ITMLibSettings::DEVICE_CPU:
 		sceneRecoEngine = new ITMSceneReconstructionEngine_CPU<TVoxel,TIndex>();
-		if (settings->useSwapping) swappingEngine = new ITMSwappingEngine_CPU<TVoxel,TIndex>();
+		if (settings->useSwapping && settings->useAsynchronousSwapping)
+		{
+			swappingEngine = new ITMAsyncSwappingEngine_CPU<TVoxel,TIndex>();
+			swapInBeforeIntegration = true;
+		}
+		else if (settings->useSwapping) swappingEngine = new ITMSwappingEngine_CPU<TVoxel,TIndex>();
 		break;
 	case ITMLibSettings::DEVICE_CUDA:
 #ifndef COMPILE_WITHOUT_CUDA
@@ -50,24 +60,79 @@ void ITMDenseMapper<TVoxel,TIndex>::ResetScene(ITMScene<TVoxel,TIndex> *scene)
 template<class TVoxel, class TIndex>
 void ITMDenseMapper<TVoxel,TIndex>::ProcessFrame(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState)
 {
+	ITMProfiler::ScopedTimer mappingTimer(ITMProfiler::STAGE_MAPPING);
+
+	if (prefetchFrames > 0) PredictPose(trackingState);
+
 	// allocation (as well as visible list update ?)
-	sceneRecoEngine->AllocateSceneFromDepth(scene, view, trackingState, renderState);
+	{
+		ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_ALLOCATION);
+		sceneRecoEngine->AllocateSceneFromDepth(scene, view, trackingState, renderState);
+	}
+
+	if (ITMProfiler::IsEnabled())
+	{
+		const ITMRenderState_VH *renderState_vh = dynamic_cast<const ITMRenderState_VH*>(renderState);
+		if (renderState_vh != NULL) ITMProfiler::Count(ITMProfiler::COUNTER_VISIBLE_BLOCKS, renderState_vh->noVisibleEntries);
+	}
+
+	if (swappingEngine != NULL && swapInBeforeIntegration)
+	{
+		ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_SWAP_IN);
+		swappingEngine->IntegrateGlobalIntoLocal(scene, renderState);
+	}
 
 	// integration
-	sceneRecoEngine->IntegrateIntoScene(scene, view, trackingState, renderState);
+	{
+		ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_INTEGRATION);
+		sceneRecoEngine->IntegrateIntoScene(scene, view, trackingState, renderState);
+	}
 
 	if (swappingEngine != NULL) {
 		// swapping: CPU -> GPU
-		swappingEngine->IntegrateGlobalIntoLocal(scene, renderState);
+		if (!swapInBeforeIntegration)
+		{
+			ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_SWAP_IN);
+			swappingEngine->IntegrateGlobalIntoLocal(scene, renderState);
+		}
 		// swapping: GPU -> CPU
-		swappingEngine->SaveToGlobalMemory(scene, renderState);
+		{
+			ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_SWAP_OUT);
+			swappingEngine->SaveToGlobalMemory(scene, renderState);
+		}
 	}
 }
 
+template<class TVoxel, class TIndex>
+void ITMDenseMapper<TVoxel,TIndex>::PredictPose(const ITMTrackingState *trackingState)
+{
+	Matrix4f M_d = trackingState->pose_d->GetM();
+
+	if (hasLastPose)
+	{
+		// constant velocity: the motion from the last frame to this one is repeated for every predicted frame
+		Matrix4f invLastM_d, motion, predictedM_d = M_d;
+		lastM_d.inv(invLastM_d);
+		motion = M_d * invLastM_d;
+		for (int i = 0; i < prefetchFrames; i++) predictedM_d = motion * predictedM_d;
+
+		sceneRecoEngine->SetPredictedPose(predictedM_d, prefetchBlockBudget);
+	}
+
+	lastM_d = M_d;
+	hasLastPose = true;
+}
+
 template<class TVoxel, class TIndex>
 void ITMDenseMapper<TVoxel,TIndex>::UpdateVisibleList(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState)
 {
 	sceneRecoEngine->AllocateSceneFromDepth(scene, view, trackingState, renderState, true);
 }
 
+template<class TVoxel, class TIndex>
+void ITMDenseMapper<TVoxel,TIndex>::WaitForSwapping(void)
+{
+	if (swappingEngine != NULL) swappingEngine->Wait();
+}
+
 template class ITMLib::Engine::ITMDenseMapper<ITMVoxel, ITMVoxelIndex>;
@@ -26,6 +26,18 @@ namespace ITMLib
 			ITMSceneReconstructionEngine<TVoxel,TIndex> *sceneRecoEngine;
 			ITMSwappingEngine<TVoxel,TIndex> *swappingEngine;
 
+			/// the asynchronous swapping engine hands over swapped in blocks before the new frame is integrated
+			bool swapInBeforeIntegration;
+
+			/// number of frames the camera motion is extrapolated for swapping in blocks early, and the blocks that may be requested per frame for it
+			int prefetchFrames, prefetchBlockBudget;
+			/// pose of the depth camera at the last frame, for the velocity
+			Matrix4f lastM_d;
+			bool hasLastPose;
+
+			/// extrapolates the motion between the last two frames and passes the predicted pose to the scene reconstruction engine
+			void PredictPose(const ITMTrackingState *trackingState);
+
 		public:
 			void ResetScene(ITMScene<TVoxel,TIndex> *scene);
 
@@ -35,6 +47,9 @@ namespace ITMLib
 			/// Update the visible list (this can be called to update the visible list when fusion is turned off)
 			void UpdateVisibleList(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState);
 
+			/// Waits for swapping work that runs in the background, after which the global cache of the scene can be read
+			void WaitForSwapping(void);
+
 			/** \brief Constructor
 			    Ommitting a separate image size for the depth images
 			    will assume same resolution as for the RGB images.
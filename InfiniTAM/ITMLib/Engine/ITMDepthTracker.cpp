@@ -8,10 +8,13 @@
 using namespace ITMLib::Engine;
 
 ITMDepthTracker::ITMDepthTracker(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, int noICPRunTillLevel, float distThresh,
-	float terminationThreshold, const ITMLowLevelEngine *lowLevelEngine, MemoryDeviceType memoryType)
+	float terminationThreshold, float timeBudget, const ITMLowLevelEngine *lowLevelEngine, MemoryDeviceType memoryType)
 {
 	viewHierarchy = new ITMImageHierarchy<ITMTemplatedHierarchyLevel<ITMFloatImage> >(imgSize, trackingRegime, noHierarchyLevels, memoryType, true);
 	sceneHierarchy = new ITMImageHierarchy<ITMSceneHierarchyLevel>(imgSize, trackingRegime, noHierarchyLevels, memoryType, true);
+	// the pyramids are only held during TrackCamera(), other trackers can use the pooled images in between
+	viewHierarchy->ReleaseData();
+	sceneHierarchy->ReleaseData();
 
 	this->noIterationsPerLevel = new int[noHierarchyLevels];
 	this->distThresh = new float[noHierarchyLevels];
@@ -32,6 +35,9 @@ ITMDepthTracker::ITMDepthTracker(Vector2i imgSize, TrackerIterationType *trackin
 	this->noICPLevel = noICPRunTillLevel;
 
 	this->terminationThreshold = terminationThreshold;
+
+	// with a time budget, a level ends once an iteration reduces the error by less than 1%
+	this->scheduler = new ITMTrackerScheduler(noHierarchyLevels, noICPRunTillLevel, timeBudget, 0.01f);
 }
 
 ITMDepthTracker::~ITMDepthTracker(void) 
@@ -41,6 +47,8 @@ ITMDepthTracker::~ITMDepthTracker(void)
 
 	delete[] this->noIterationsPerLevel;
 	delete[] this->distThresh;
+
+	delete this->scheduler;
 }
 
 void ITMDepthTracker::SetEvaluationData(ITMTrackingState *trackingState, const ITMView *view)
@@ -67,9 +75,10 @@ void ITMDepthTracker::PrepareForEvaluation()
 		lowLevelEngine->FilterSubsampleWithHoles(currentLevelView->depth, previousLevelView->depth);
 		currentLevelView->intrinsics = previousLevelView->intrinsics * 0.5f;
 
+		// the scene maps are subsampled along, so that coarse levels are matched against maps of their own resolution
 		ITMSceneHierarchyLevel *currentLevelScene = sceneHierarchy->levels[i], *previousLevelScene = sceneHierarchy->levels[i - 1];
-		//lowLevelEngine->FilterSubsampleWithHoles(currentLevelScene->pointsMap, previousLevelScene->pointsMap);
-		//lowLevelEngine->FilterSubsampleWithHoles(currentLevelScene->normalsMap, previousLevelScene->normalsMap);
+		lowLevelEngine->FilterSubsampleWithHoles(currentLevelScene->pointsMap, previousLevelScene->pointsMap);
+		lowLevelEngine->FilterSubsampleWithHoles(currentLevelScene->normalsMap, previousLevelScene->normalsMap);
 		currentLevelScene->intrinsics = previousLevelScene->intrinsics * 0.5f;
 	}
 }
@@ -78,7 +87,7 @@ void ITMDepthTracker::SetEvaluationParams(int levelId)
 {
 	this->levelId = levelId;
 	this->iterationType = viewHierarchy->levels[levelId]->iterationType;
-	this->sceneHierarchyLevel = sceneHierarchy->levels[0];
+	this->sceneHierarchyLevel = sceneHierarchy->levels[levelId];
 	this->viewHierarchyLevel = viewHierarchy->levels[levelId];
 }
 
@@ -144,6 +153,11 @@ void ITMDepthTracker::ApplyDelta(const Matrix4f & para_old, const float *delta,
 
 void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView *view)
 {
+	scheduler->StartFrame();
+
+	viewHierarchy->AcquireData();
+	sceneHierarchy->AcquireData();
+
 	this->SetEvaluationData(trackingState, view);
 	this->PrepareForEvaluation();
 
@@ -158,25 +172,36 @@ void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 	{
 		this->SetEvaluationParams(levelId);
 		if (iterationType == TRACKER_ITERATION_NONE) continue;
+		if (!scheduler->StartLevel(levelId)) continue;
+
+		this->SelectPoints();
 
 		Matrix4f approxInvPose = trackingState->pose_d->GetInvM();
 		ITMPose lastKnownGoodPose(*(trackingState->pose_d));
 		f_old = 1e20f;
 		float lambda = 1.0;
+		bool hasGoodState = false;
 
 		for (int iterNo = 0; iterNo < noIterationsPerLevel[levelId]; iterNo++)
 		{
+			if (!scheduler->StartIteration(levelId, iterNo)) break;
+			float f_previous = f_old;
+
 			// evaluate error function and gradients
 			noValidPoints_new = this->ComputeGandH(f_new, nabla_new, hessian_new, approxInvPose);
 
-			// check if error increased. If so, revert
-			if ((noValidPoints_new <= 0)||(f_new > f_old)) {
+			// check if error increased, or if there were too few points to constrain the pose. If so, revert
+			if ((noValidPoints_new <= MIN_NO_VALID_POINTS)||(f_new > f_old)) {
+				// nothing to take a step from on this level
+				if (!hasGoodState) { scheduler->EndIteration(levelId, f_previous, f_old); break; }
+
 				trackingState->pose_d->SetFrom(&lastKnownGoodPose);
 				approxInvPose = trackingState->pose_d->GetInvM();
 				lambda *= 10.0f;
 			} else {
 				lastKnownGoodPose.SetFrom(trackingState->pose_d);
 				f_old = f_new;
+				hasGoodState = true;
 
 				for (int i = 0; i < 6*6; ++i) hessian_good[i] = hessian_new[i] / noValidPoints_new;
 				for (int i = 0; i < 6; ++i) nabla_good[i] = nabla_new[i] / noValidPoints_new;
@@ -193,8 +218,14 @@ void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 			approxInvPose = trackingState->pose_d->GetInvM();
 
 			// if step is small, assume it's going to decrease the error and finish
-			if (HasConverged(step)) break;
+			bool hasConverged = HasConverged(step);
+			if (!scheduler->EndIteration(levelId, f_previous, f_old) || hasConverged) break;
 		}
 	}
+
+	viewHierarchy->ReleaseData();
+	sceneHierarchy->ReleaseData();
+
+	scheduler->EndFrame();
 }
 
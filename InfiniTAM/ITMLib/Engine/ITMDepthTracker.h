@@ -10,6 +10,7 @@
 
 #include "../Engine/ITMTracker.h"
 #include "../Engine/ITMLowLevelEngine.h"
+#include "../Engine/ITMTrackerScheduler.h"
 
 using namespace ITMLib::Objects;
 
@@ -24,6 +25,9 @@ namespace ITMLib
 		class ITMDepthTracker : public ITMTracker
 		{
 		private:
+			/// evaluations with fewer points are rejected, the error of the device specific trackers is not meaningful below
+			static const int MIN_NO_VALID_POINTS = 100;
+
 			const ITMLowLevelEngine *lowLevelEngine;
 			ITMImageHierarchy<ITMSceneHierarchyLevel> *sceneHierarchy;
 			ITMImageHierarchy<ITMTemplatedHierarchyLevel<ITMFloatImage> > *viewHierarchy;
@@ -35,6 +39,8 @@ namespace ITMLib
 
 			float terminationThreshold;
 
+			ITMTrackerScheduler *scheduler;
+
 			void PrepareForEvaluation();
 			void SetEvaluationParams(int levelId);
 
@@ -53,13 +59,19 @@ namespace ITMLib
 			ITMSceneHierarchyLevel *sceneHierarchyLevel;
 			ITMTemplatedHierarchyLevel<ITMFloatImage> *viewHierarchyLevel;
 
+			/// Called once per level before its iterations, the view image of the level does not change until the next one
+			virtual void SelectPoints(void) { }
 			virtual int ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose) = 0;
 
 		public:
 			void TrackCamera(ITMTrackingState *trackingState, const ITMView *view);
 
+			/// Number of iterations and share of the time budget of the last frame
+			const ITMTrackerScheduler *GetScheduler(void) const { return scheduler; }
+
+			/// @p timeBudget is the time TrackCamera() may take, in milliseconds, 0 to always run the full number of iterations
 			ITMDepthTracker(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, int noICPRunTillLevel, float distThresh,
-				float terminationThreshold, const ITMLowLevelEngine *lowLevelEngine, MemoryDeviceType memoryType);
+				float terminationThreshold, float timeBudget, const ITMLowLevelEngine *lowLevelEngine, MemoryDeviceType memoryType);
 			virtual ~ITMDepthTracker(void);
 		};
 	}
@@ -2,8 +2,53 @@
 
 #include "ITMMainEngine.h"
 
+#include "../Utils/ITMProfiler.h"
+
+#include <algorithm>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
 using namespace ITMLib::Engine;
 
+/// with pipelined processing, tracking and the mapping thread pin their OpenMP teams to disjoint parts of the cores
+static const int TRACKING_CORES = 0, MAPPING_CORES = 1, NUM_CORE_PARTS = 2;
+
+class ITMMainEngine::MappingJob : public ITMWorkerThread::Job
+{
+private:
+	ITMMainEngine *mainEngine;
+	bool isAffinitySet;
+	int noThreads;
+
+public:
+	/// the OpenMP team of the mapping thread gets as many threads as that of the thread creating the job
+	explicit MappingJob(ITMMainEngine *mainEngine) : mainEngine(mainEngine), isAffinitySet(false), noThreads(0)
+	{
+#ifdef WITH_OPENMP
+		noThreads = omp_get_max_threads();
+#endif
+	}
+
+	void Execute(void)
+	{
+		ITMProfiler::SetThreadName("mapping");
+
+		// the mapping thread has an OpenMP team of its own
+		if (!isAffinitySet && (mainEngine->settings->deviceType == ITMLibSettings::DEVICE_CPU))
+		{
+#ifdef WITH_OPENMP
+			omp_set_num_threads(noThreads);
+#endif
+			if (!ITMThreadAffinity::Apply(mainEngine->settings->threadAffinity, MAPPING_CORES, NUM_CORE_PARTS)) printf("Warning: could not set the affinity of the OpenMP threads of the mapping thread\n");
+			isAffinitySet = true;
+		}
+
+		mainEngine->MapAndPrepare(mainEngine->view, mainEngine->trackingState_mapping);
+	}
+};
+
 ITMMainEngine::ITMMainEngine(const ITMLibSettings *settings, const ITMRGBDCalib *calib, Vector2i imgSize_rgb, Vector2i imgSize_d)
 {
 	// create all the things required for marching cubes and mesh extraction
@@ -14,8 +59,29 @@ ITMMainEngine::ITMMainEngine(const ITMLibSettings *settings, const ITMRGBDCalib
 
 	this->settings = settings;
 
+	if (settings->useProfiling) ITMProfiler::SetEnabled(true);
+	ORUtils::setHugePagesEnabled(settings->useHugePages);
+	ORUtils::setNUMAInterleaveEnabled(settings->useNUMAInterleave);
+
+	// before the scene is allocated, the threads that first touch its pages determine where they are placed.
+	// With pipelined processing, these are the cores of the mapping thread, which integrates into the scene.
+	bool isPipelined = settings->usePipelinedProcessing && (settings->trackerType != ITMLibSettings::TRACKER_REN);
+#ifdef WITH_OPENMP
+	int noThreads = omp_get_max_threads();
+#endif
+	if (settings->deviceType == ITMLibSettings::DEVICE_CPU)
+	{
+		bool success = isPipelined ? ITMThreadAffinity::Apply(settings->threadAffinity, MAPPING_CORES, NUM_CORE_PARTS) : ITMThreadAffinity::Apply(settings->threadAffinity);
+		if (!success) printf("Warning: could not set the affinity of the OpenMP threads\n");
+	}
+
+	// allocations are accounted per subsystem, see ORUtils::MemoryRegistry; the scene tags its parts itself
 	this->scene = new ITMScene<ITMVoxel, ITMVoxelIndex>(&(settings->sceneParams), settings->useSwapping, 
 		settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU);
+	if (settings->useSwapping && settings->swappingHostBlockBudget > 0)
+		scene->globalCache->SetDiskTier(settings->swappingHostBlockBudget, settings->swappingDiskBlockBudget, settings->swappingDirectory);
+
+	ORUtils::ScopedMemoryTag engineTag("engines");
 
 	meshingEngine = NULL;
 	switch (settings->deviceType)
@@ -45,18 +111,22 @@ ITMMainEngine::ITMMainEngine(const ITMLibSettings *settings, const ITMRGBDCalib
 	}
 
 	mesh = NULL;
+	ORUtils::ScopedMemoryTag meshTag("mesh");
 	if (createMeshingEngine) mesh = new ITMMesh(settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU);
 
 	Vector2i trackedImageSize = ITMTrackingController::GetTrackedImageSize(settings, imgSize_rgb, imgSize_d);
 
+	ORUtils::ScopedMemoryTag renderTag("render_state");
 	renderState_live = visualisationEngine->CreateRenderState(trackedImageSize);
 	renderState_freeview = NULL; //will be created by the visualisation engine
 
+	ORUtils::ScopedMemoryTag mappingTag("mapping");
 	denseMapper = new ITMDenseMapper<ITMVoxel, ITMVoxelIndex>(settings);
 	denseMapper->ResetScene(scene);
 
 	primitiveFitter = new LIMUPrimitiveFitter<ITMVoxel, ITMVoxelIndex>(settings, scene);
 
+	ORUtils::ScopedMemoryTag trackingTag("tracking");
 	imuCalibrator = new ITMIMUCalibrator_iPad();
 	tracker = ITMTrackerFactory<ITMVoxel, ITMVoxelIndex>::Instance().Make(trackedImageSize, settings, lowLevelEngine, imuCalibrator, scene);
 	trackingController = new ITMTrackingController(tracker, visualisationEngine, lowLevelEngine, settings);
@@ -66,18 +136,58 @@ ITMMainEngine::ITMMainEngine(const ITMLibSettings *settings, const ITMRGBDCalib
 
 	view = NULL; // will be allocated by the view builder
 
+	view_pipeline = NULL;
+	trackingState_mapping = NULL;
+	mappingJob = NULL;
+	mappingThread = NULL;
+	referencePending = false;
+
+	if (settings->usePipelinedProcessing)
+	{
+		// the Ren tracker reads the volume directly, which the mapping thread modifies concurrently
+		if (!isPipelined)
+			printf("Warning: pipelined processing is not supported by the Ren tracker, processing frames sequentially\n");
+		else
+		{
+			trackingState_mapping = trackingController->BuildTrackingState(trackedImageSize);
+			trackingState_mapping->pose_d->SetFrom(trackingState->pose_d);
+#ifdef WITH_OPENMP
+			// pinning to the cores of the mapping thread above limited the team of the calling thread to them
+			omp_set_num_threads(noThreads);
+#endif
+			mappingJob = new MappingJob(this);
+			mappingThread = new ITMWorkerThread();
+
+			// the calling thread tracks, on the cores the mapping thread does not use
+			if (settings->deviceType == ITMLibSettings::DEVICE_CPU)
+			{
+				if (!ITMThreadAffinity::Apply(settings->threadAffinity, TRACKING_CORES, NUM_CORE_PARTS)) printf("Warning: could not set the affinity of the OpenMP threads\n");
+			}
+		}
+	}
+
 	fusionActive = true;
 	mainProcessingActive = true;
 }
 
 ITMMainEngine::~ITMMainEngine()
 {
+	if (mappingThread != NULL)
+	{
+		delete mappingThread;
+		delete mappingJob;
+		delete trackingState_mapping;
+		if (view_pipeline != NULL) delete view_pipeline;
+	}
+
 	delete renderState_live;
 	if (renderState_freeview!=NULL) delete renderState_freeview;
 
+	// the dense mapper may still be swapping blocks of the scene in the background
+	delete denseMapper;
 	delete scene;
 
-	delete denseMapper;
+	delete primitiveFitter;
 	delete trackingController;
 
 	delete tracker;
@@ -98,6 +208,8 @@ ITMMainEngine::~ITMMainEngine()
 
 ITMMesh* ITMMainEngine::UpdateMesh(void)
 {
+	FlushPipeline();
+	ORUtils::ScopedMemoryTag tag("mesh");
 	if (mesh != NULL) meshingEngine->MeshScene(mesh, scene);
 	return mesh;
 }
@@ -105,6 +217,8 @@ ITMMesh* ITMMainEngine::UpdateMesh(void)
 void ITMMainEngine::SaveSceneToMesh(const char *objFileName)
 {
 	if (mesh == NULL) return;
+	FlushPipeline();
+	ORUtils::ScopedMemoryTag tag("mesh");
 	//Create mesh
 	meshingEngine->MeshScene(mesh, scene);
 	mesh->WriteSTL(objFileName);
@@ -116,15 +230,33 @@ void ITMMainEngine::SaveSceneToMesh(const char *objFileName)
 
 void ITMMainEngine::ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement)
 {
+	ITMProfiler::ScopedTimer frameTimer(ITMProfiler::STAGE_PROCESS_FRAME);
+
+	if (mappingThread != NULL)
+	{
+		ProcessFramePipelined(rgbImage, rawDepthImage, imuMeasurement);
+		return;
+	}
+
 	// prepare image and turn it into a depth image
-	if (imuMeasurement==NULL) viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter,settings->modelSensorNoise);
-	else viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter, imuMeasurement);
+	{
+		ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_VIEW);
+		ORUtils::ScopedMemoryTag tag("view");
+		if (imuMeasurement==NULL) viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter,settings->modelSensorNoise);
+		else viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter, imuMeasurement);
+	}
 
 	if (!mainProcessingActive) return;
 
 	// tracking
 	trackingController->Track(trackingState, view);
 
+	// fusion, and raycast to renderState_live for tracking and free visualisation
+	MapAndPrepare(view, trackingState);
+}
+
+void ITMMainEngine::MapAndPrepare(ITMView *view, ITMTrackingState *trackingState)
+{
 	// fusion, and update renderState_live
 	if (fusionActive) denseMapper->ProcessFrame(view, trackingState, scene, renderState_live);
 
@@ -135,6 +267,58 @@ void ITMMainEngine::ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDep
 	trackingController->Prepare(trackingState, view, renderState_live);
 }
 
+void ITMMainEngine::ProcessFramePipelined(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement)
+{
+	// the mapping thread may still be reading the previous view, so build into the spare one
+	{
+		ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_VIEW);
+		ORUtils::ScopedMemoryTag tag("view");
+		if (imuMeasurement == NULL) viewBuilder->UpdateView(&view_pipeline, rgbImage, rawDepthImage, settings->useBilateralFilter, settings->modelSensorNoise);
+		else viewBuilder->UpdateView(&view_pipeline, rgbImage, rawDepthImage, settings->useBilateralFilter, imuMeasurement);
+	}
+
+	if (!mainProcessingActive)
+	{
+		FlushPipeline();
+		std::swap(view, view_pipeline);
+		return;
+	}
+
+	// tracking against the latest reference published by the mapping thread; the pose is final from here on
+	trackingController->Track(trackingState, view_pipeline);
+
+	// the previous frame has to be fused before this one, which also bounds the staleness of the reference
+	FlushPipeline();
+
+	std::swap(view, view_pipeline);
+	trackingState_mapping->pose_d->SetFrom(trackingState->pose_d);
+	trackingState_mapping->requiresFullRendering = trackingState->requiresFullRendering;
+
+	referencePending = true;
+	mappingThread->Run(mappingJob);
+}
+
+void ITMMainEngine::FlushPipeline(void)
+{
+	if (mappingThread == NULL) return;
+
+	{
+		ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_PIPELINE_WAIT);
+		mappingThread->Wait();
+	}
+	if (!referencePending) return;
+	referencePending = false;
+
+	// publish the raycast of the last mapped frame as tracking reference. Prepare() resets the age to 0
+	// (or -2 for the very first raycast) whenever it rendered a new point cloud, otherwise the old one stays valid
+	if ((trackingState_mapping->age_pointCloud == 0) || (trackingState_mapping->age_pointCloud == -2))
+	{
+		std::swap(trackingState->pointCloud, trackingState_mapping->pointCloud);
+		trackingState->pose_pointCloud->SetFrom(trackingState_mapping->pose_pointCloud);
+	}
+	trackingState->age_pointCloud = trackingState_mapping->age_pointCloud;
+}
+
 Vector2i ITMMainEngine::GetImageSize(void) const
 {
 	return renderState_live->raycastImage->noDims;
@@ -144,6 +328,10 @@ void ITMMainEngine::GetImage(ITMUChar4Image *out, GetImageType getImageType, ITM
 {
 	if (view == NULL) return;
 
+	// anything but the input images depends on the mapping thread's results
+	if ((getImageType != ITMMainEngine::InfiniTAM_IMAGE_ORIGINAL_RGB) && (getImageType != ITMMainEngine::InfiniTAM_IMAGE_ORIGINAL_DEPTH))
+		FlushPipeline();
+
 	out->Clear();
 
 	switch (getImageType)
@@ -184,6 +372,7 @@ void ITMMainEngine::GetImage(ITMUChar4Image *out, GetImageType getImageType, ITM
 		IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_CUSTOM;
 		if (getImageType == ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_VOLUME) type = IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME;
 		else if (getImageType == ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_NORMAL) type = IITMVisualisationEngine::RENDER_COLOUR_FROM_NORMAL;
+		ORUtils::ScopedMemoryTag tag("render_state");
 		if (renderState_freeview == NULL) renderState_freeview = visualisationEngine->CreateRenderState(out->noDims);
 
 		visualisationEngine->FindVisibleBlocks(pose, intrinsics, renderState_freeview);
@@ -202,6 +391,8 @@ void ITMMainEngine::GetImage(ITMUChar4Image *out, GetImageType getImageType, ITM
 
 void ITMMainEngine::projectCyliner()
 {
+	FlushPipeline();
+
 	Vector2i imgSize = this->renderState_live->raycastResult->noDims;
 	int x = imgSize.x*0.5;
 	int y = imgSize.y*0.75;
@@ -209,7 +400,7 @@ void ITMMainEngine::projectCyliner()
 	primitiveFitter->ProcessOneSeed(x, y, this->scene, this->renderState_live);
 }
 
-void ITMMainEngine::turnOnIntegration() { fusionActive = true; }
-void ITMMainEngine::turnOffIntegration() { fusionActive = false; }
+void ITMMainEngine::turnOnIntegration() { FlushPipeline(); fusionActive = true; }
+void ITMMainEngine::turnOffIntegration() { FlushPipeline(); fusionActive = false; }
 void ITMMainEngine::turnOnMainProcessing() { mainProcessingActive = true; }
 void ITMMainEngine::turnOffMainProcessing() { mainProcessingActive = false; }
@@ -4,6 +4,7 @@
 
 #include "../ITMLib.h"
 #include "../Utils/ITMLibSettings.h"
+#include "../Utils/ITMWorkerThread.h"
 
 /** \mainpage
     This is the API reference documentation for InfiniTAM. For a general
@@ -44,6 +45,15 @@ namespace ITMLib
 
 		    To access the internal information, look at the member
 		    variables @ref trackingState and @ref scene.
+
+		    With ITMLibSettings::usePipelinedProcessing enabled,
+		    @ref ProcessFrame() returns as soon as the camera has
+		    been tracked, while fusion and raycasting of that frame
+		    continue on a mapping thread. The next frame is then
+		    tracked against a reference that is at most one frame
+		    older than in sequential mode. All accessors that read
+		    the scene or the raycast wait for the mapping thread;
+		    @ref FlushPipeline() does so explicitly.
 		*/
 		class ITMMainEngine
 		{
@@ -70,6 +80,20 @@ namespace ITMLib
 			ITMView *view;
 			ITMTrackingState *trackingState;
 
+			/// Pipelined mode only: the spare input view and the tracking state the mapping thread raycasts into
+			ITMView *view_pipeline;
+			ITMTrackingState *trackingState_mapping;
+
+			class MappingJob;
+			MappingJob *mappingJob;
+			ITMWorkerThread *mappingThread;
+			bool referencePending;
+
+			/// Fusion and raycast of a tracked frame, updating the tracking reference in @p trackingState
+			void MapAndPrepare(ITMView *view, ITMTrackingState *trackingState);
+
+			void ProcessFramePipelined(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement);
+
 			ITMScene<ITMVoxel, ITMVoxelIndex> *scene;
 			ITMRenderState *renderState_live;
 			ITMRenderState *renderState_freeview;
@@ -92,12 +116,15 @@ namespace ITMLib
 			/// Gives access to the current camera pose and additional tracking information
 			ITMTrackingState* GetTrackingState(void) { return trackingState; }
 
-			/// Gives access to the internal world representation
-			ITMScene<ITMVoxel, ITMVoxelIndex>* GetScene(void) { return scene; }
+			/// Gives access to the internal world representation, once the pipeline and background swapping have finished with it
+			ITMScene<ITMVoxel, ITMVoxelIndex>* GetScene(void) { FlushPipeline(); denseMapper->WaitForSwapping(); return scene; }
 
 			/// Process a frame with rgb and depth images and optionally a corresponding imu measurement
 			void ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement = NULL);
 
+			/// Waits until fusion and raycasting of the last frame have finished. Does nothing unless processing is pipelined.
+			void FlushPipeline(void);
+
 			// Gives access to the data structure used internally to store any created meshes
 			ITMMesh* GetMesh(void) { return mesh; }
 
@@ -60,8 +60,13 @@ ITMRenTracker<TVoxel, TIndex>::ITMRenTracker(Vector2i imgSize, TrackerIterationT
 {
 	viewHierarchy = new ITMImageHierarchy<ITMTemplatedHierarchyLevel<ITMFloat4Image> >(imgSize, trackingRegime, noHierarchyLevels, memoryType, false);
 
-	tempImage1 = new ITMFloatImage(imgSize, memoryType);
-	tempImage2 = new ITMFloatImage(imgSize, memoryType);
+	tempImage1 = new ITMFloatImage(imgSize, memoryType, true);
+	tempImage2 = new ITMFloatImage(imgSize, memoryType, true);
+
+	// the pyramid and scratch images are only held during TrackCamera(), other trackers can use the pooled images in between
+	viewHierarchy->ReleaseData();
+	tempImage1->ReleaseToPool();
+	tempImage2->ReleaseToPool();
 
 	this->lowLevelEngine = lowLevelEngine;
 	this->scene = scene;
@@ -105,6 +110,12 @@ void ITMRenTracker<TVoxel, TIndex>::PrepareForEvaluation(const ITMView *view)
 template<class TVoxel, class TIndex>
 void ITMRenTracker<TVoxel,TIndex>::TrackCamera(ITMTrackingState *trackingState, const ITMView *view)
 {
+	// the scratch images are left at the size of the coarsest level by PrepareForEvaluation()
+	tempImage1->ChangeDims(view->depth->noDims);
+	tempImage2->ChangeDims(view->depth->noDims);
+	tempImage1->AcquireFromPool();
+	tempImage2->AcquireFromPool();
+	viewHierarchy->AcquireData();
 	this->PrepareForEvaluation(view);
 
 	// // Carl lm
@@ -159,6 +170,10 @@ void ITMRenTracker<TVoxel,TIndex>::TrackCamera(ITMTrackingState *trackingState,
 
 	trackingState->pose_d->SetInvM(invM);
 	trackingState->pose_d->Coerce();
+
+	viewHierarchy->ReleaseData();
+	tempImage1->ReleaseToPool();
+	tempImage2->ReleaseToPool();
 }
 
 template<class TVoxel, class TIndex>
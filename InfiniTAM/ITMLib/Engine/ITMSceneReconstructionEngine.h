@@ -47,6 +47,16 @@ namespace ITMLib
 			virtual void IntegrateIntoScene(ITMScene<TVoxel,TIndex> *scene, const ITMView *view, const ITMTrackingState *trackingState,
 				const ITMRenderState *renderState) = 0;
 
+			/** With swapping, also treat the swapped out blocks that
+			    would be visible from @p M_d, a predicted future pose
+			    of the depth camera, as visible in the following calls
+			    to AllocateSceneFromDepth(), so that they are brought
+			    back before they come into view. At most @p maxNoBlocks
+			    blocks are requested per call because of the
+			    prediction. Engines that do not support this ignore it.
+			*/
+			virtual void SetPredictedPose(const Matrix4f &M_d, int maxNoBlocks) { }
+
 			ITMSceneReconstructionEngine(void) { }
 			virtual ~ITMSceneReconstructionEngine(void) { }
 		};
@@ -27,6 +27,9 @@ namespace ITMLib
 
 			virtual void SaveToGlobalMemory(ITMScene<TVoxel, TIndex> *scene, ITMRenderState *renderState) = 0;
 
+			/// Waits for work on the global cache that runs in the background, so that the cache can be read
+			virtual void Wait(void) { }
+
 			virtual ~ITMSwappingEngine(void) { }
 		};
 	}
@@ -138,6 +138,8 @@ namespace ITMLib
               settings->noICPRunTillLevel,
               settings->depthTrackerICPThreshold,
               settings->depthTrackerTerminationThreshold,
+              settings->depthTrackerTimeBudget,
+              settings->depthTrackerPointBudget,
               lowLevelEngine
             );
           }
@@ -151,6 +153,7 @@ namespace ITMLib
               settings->noICPRunTillLevel,
               settings->depthTrackerICPThreshold,
               settings->depthTrackerTerminationThreshold,
+              settings->depthTrackerTimeBudget,
               lowLevelEngine
             );
 #else
@@ -167,6 +170,7 @@ namespace ITMLib
               settings->noICPRunTillLevel,
               settings->depthTrackerICPThreshold,
               settings->depthTrackerTerminationThreshold,
+              settings->depthTrackerTimeBudget,
               lowLevelEngine
             );
 #else
@@ -224,6 +228,7 @@ namespace ITMLib
 				  settings->noICPRunTillLevel,
 				  settings->depthTrackerICPThreshold,
 				  settings->depthTrackerTerminationThreshold,
+				  settings->depthTrackerTimeBudget,
 				  lowLevelEngine
 				  );
 #else
@@ -256,6 +261,8 @@ namespace ITMLib
                 settings->noICPRunTillLevel,
                 settings->depthTrackerICPThreshold,
                 settings->depthTrackerTerminationThreshold,
+                settings->depthTrackerTimeBudget,
+                settings->depthTrackerPointBudget,
                 lowLevelEngine
               ), 1
             );
@@ -274,6 +281,7 @@ namespace ITMLib
                 settings->noICPRunTillLevel,
                 settings->depthTrackerICPThreshold,
                 settings->depthTrackerTerminationThreshold,
+                settings->depthTrackerTimeBudget,
                 lowLevelEngine
               ), 1
             );
@@ -295,6 +303,7 @@ namespace ITMLib
                 settings->noICPRunTillLevel,
                 settings->depthTrackerICPThreshold,
                 settings->depthTrackerTerminationThreshold,
+                settings->depthTrackerTimeBudget,
                 lowLevelEngine
               ), 1
             );
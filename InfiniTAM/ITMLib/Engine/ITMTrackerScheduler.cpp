@@ -0,0 +1,131 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMTrackerScheduler.h"
+#include "../Utils/ITMLibDefines.h"
+#include "../Utils/ITMProfiler.h"
+
+using namespace ITMLib::Engine;
+using namespace ITMLib::Objects;
+
+/// weight of the newest sample in the moving averages of the timings
+static const double TIMING_WEIGHT = 0.2;
+/// factor the timings of a skipped level are multiplied with per frame
+static const double SKIPPED_LEVEL_DECAY = 0.98;
+
+static void updateTiming(double &average, double sample)
+{
+	average = (average < 0.0) ? sample : (1.0 - TIMING_WEIGHT) * average + TIMING_WEIGHT * sample;
+}
+
+ITMTrackerScheduler::ITMTrackerScheduler(int noLevels, int finestLevelId, float timeBudget, float minErrorReduction)
+{
+	this->noLevels = noLevels;
+	this->finestLevelId = finestLevelId;
+	this->timeBudget = timeBudget;
+	this->minErrorReduction = minErrorReduction;
+
+	levelSetupTimes = new double[noLevels];
+	iterationTimes = new double[noLevels];
+	isLevelPlanned = new bool[noLevels];
+	for (int levelId = 0; levelId < noLevels; levelId++)
+	{
+		levelSetupTimes[levelId] = iterationTimes[levelId] = -1.0;
+		isLevelPlanned[levelId] = true;
+	}
+	hasPlan = false;
+
+	frameStart = levelStart = iterationStart = 0.0;
+	noIterations = 0;
+	budgetUsed = 0.0f;
+}
+
+ITMTrackerScheduler::~ITMTrackerScheduler(void)
+{
+	delete[] levelSetupTimes;
+	delete[] iterationTimes;
+	delete[] isLevelPlanned;
+}
+
+double ITMTrackerScheduler::GetLevelTime(int levelId) const
+{
+	return MAX(levelSetupTimes[levelId], 0.0) + MAX(iterationTimes[levelId], 0.0);
+}
+
+double ITMTrackerScheduler::GetReservedTime(int levelId) const
+{
+	double reservedTime = 0.0;
+	for (int finerLevelId = finestLevelId; finerLevelId < levelId; finerLevelId++)
+		if (isLevelPlanned[finerLevelId]) reservedTime += GetLevelTime(finerLevelId);
+
+	return reservedTime;
+}
+
+void ITMTrackerScheduler::PlanLevels(int coarsestLevelId)
+{
+	double availableTime = timeBudget - (ITMProfiler::GetTime() - frameStart), plannedTime = 0.0;
+
+	for (int levelId = coarsestLevelId; levelId >= finestLevelId; levelId--)
+	{
+		double levelTime = GetLevelTime(levelId);
+		isLevelPlanned[levelId] = (levelId == coarsestLevelId) || (plannedTime + levelTime <= availableTime);
+
+		if (isLevelPlanned[levelId]) plannedTime += levelTime;
+		else
+		{
+			levelSetupTimes[levelId] *= SKIPPED_LEVEL_DECAY;
+			iterationTimes[levelId] *= SKIPPED_LEVEL_DECAY;
+		}
+	}
+
+	hasPlan = true;
+}
+
+void ITMTrackerScheduler::StartFrame(void)
+{
+	frameStart = ITMProfiler::GetTime();
+	noIterations = 0;
+	hasPlan = false;
+}
+
+bool ITMTrackerScheduler::StartLevel(int levelId)
+{
+	levelStart = ITMProfiler::GetTime();
+	if (timeBudget <= 0.0f) return true;
+
+	// levels before the first one run are not tracked on
+	if (!hasPlan) PlanLevels(levelId);
+
+	return isLevelPlanned[levelId];
+}
+
+bool ITMTrackerScheduler::StartIteration(int levelId, int iterNo)
+{
+	iterationStart = ITMProfiler::GetTime();
+	if (iterNo == 0) updateTiming(levelSetupTimes[levelId], iterationStart - levelStart);
+
+	if ((timeBudget <= 0.0f) || (iterNo == 0)) return true;
+
+	return iterationStart - frameStart + MAX(iterationTimes[levelId], 0.0) + GetReservedTime(levelId) <= timeBudget;
+}
+
+bool ITMTrackerScheduler::EndIteration(int levelId, float f_old, float f_new)
+{
+	updateTiming(iterationTimes[levelId], ITMProfiler::GetTime() - iterationStart);
+	noIterations++;
+
+	if (timeBudget <= 0.0f) return true;
+
+	// rejected iterations are retried with more damping
+	if (!(f_new < f_old)) return true;
+
+	return f_old - f_new >= minErrorReduction * f_old;
+}
+
+void ITMTrackerScheduler::EndFrame(void)
+{
+	ITMProfiler::Count(ITMProfiler::COUNTER_TRACKER_ITERATIONS, noIterations);
+	if (timeBudget <= 0.0f) return;
+
+	budgetUsed = (float)((ITMProfiler::GetTime() - frameStart) / timeBudget);
+	ITMProfiler::Count(ITMProfiler::COUNTER_TRACKER_BUDGET_USED, 100.0 * budgetUsed);
+}
@@ -0,0 +1,78 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** \brief
+		    Decides how many iterations a coarse to fine tracker runs
+		    on each level of its hierarchy, within a time budget per
+		    frame.
+
+		    The time to set up a level and the time of one iteration
+		    on it are measured and averaged over the frames. When the
+		    first level of a frame starts, the levels are planned
+		    from coarse to fine: a level is run if setting it up and
+		    one iteration on it fit into the budget together with
+		    the levels planned before it. The coarsest level is
+		    always run, so that every frame is tracked. Further
+		    iterations are only run if they leave the time for the
+		    finer planned levels, and a level also ends once an
+		    iteration reduces the error by less than a given
+		    fraction, so that the time saved on levels that converge
+		    quickly goes to the finer ones. The estimates of skipped
+		    levels slowly decrease, so that a level skipped because
+		    of an outlier is tried again.
+
+		    Without a budget, the tracker keeps its fixed schedule and
+		    the scheduler only counts the iterations.
+		*/
+		class ITMTrackerScheduler
+		{
+		private:
+			int noLevels, finestLevelId;
+			float timeBudget, minErrorReduction;
+
+			/// moving averages of the time to set up each level and of one iteration on it, in milliseconds, negative while unknown
+			double *levelSetupTimes, *iterationTimes;
+			bool *isLevelPlanned;
+			bool hasPlan;
+
+			double frameStart, levelStart, iterationStart;
+			int noIterations;
+			float budgetUsed;
+
+			/// estimated time to set up @p levelId and run one iteration on it
+			double GetLevelTime(int levelId) const;
+			/// time needed for the planned levels finer than @p levelId
+			double GetReservedTime(int levelId) const;
+			void PlanLevels(int coarsestLevelId);
+
+		public:
+			/// @p timeBudget is in milliseconds, 0 for none
+			ITMTrackerScheduler(int noLevels, int finestLevelId, float timeBudget, float minErrorReduction);
+			~ITMTrackerScheduler(void);
+
+			void StartFrame(void);
+			/// Returns whether level @p levelId is run at all
+			bool StartLevel(int levelId);
+			/// Returns whether iteration @p iterNo on level @p levelId is run
+			bool StartIteration(int levelId, int iterNo);
+			/// Takes the error before and after the iteration, and returns whether the level goes on
+			bool EndIteration(int levelId, float f_old, float f_new);
+			/// Records the number of iterations and the share of the budget used in ITMProfiler
+			void EndFrame(void);
+
+			/// Number of iterations run on the last frame
+			int GetNoIterations(void) const { return noIterations; }
+			/// Time taken by the last frame relative to the budget, 0 without one
+			float GetBudgetUsed(void) const { return budgetUsed; }
+
+			// Suppress the default copy constructor and assignment operator
+			ITMTrackerScheduler(const ITMTrackerScheduler&);
+			ITMTrackerScheduler& operator=(const ITMTrackerScheduler&);
+		};
+	}
+}
@@ -5,11 +5,14 @@
 #include "../Objects/ITMRenderState_VH.h"
 
 #include "../ITMLib.h"
+#include "../Utils/ITMProfiler.h"
 
 using namespace ITMLib::Engine;
 
 void ITMTrackingController::Track(ITMTrackingState *trackingState, const ITMView *view)
 {
+	ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_TRACK);
+
 	if (trackingState->age_pointCloud!=-1) tracker->TrackCamera(trackingState, view);
 
 	trackingState->requiresFullRendering = trackingState->TrackerFarFromPointCloud() || !settings->useApproximateRaycast;
@@ -18,17 +21,29 @@ void ITMTrackingController::Track(ITMTrackingState *trackingState, const ITMView
 void ITMTrackingController::Prepare(ITMTrackingState *trackingState, const ITMView *view, ITMRenderState *renderState)
 {
 	//render for tracking
+	ITMProfiler::ScopedTimer prepareTimer(ITMProfiler::STAGE_PREPARE);
 
 	if (settings->trackerType == ITMLibSettings::TRACKER_COLOR)
 	{
 		ITMPose pose_rgb(view->calib->trafo_rgb_to_depth.calib_inv * trackingState->pose_d->GetM());
-		visualisationEngine->CreateExpectedDepths(&pose_rgb, &(view->calib->intrinsics_rgb), renderState);
+		{
+			ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_EXPECTED_DEPTHS);
+			visualisationEngine->CreateExpectedDepths(&pose_rgb, &(view->calib->intrinsics_rgb), renderState);
+		}
+
+		ITMProfiler::ScopedTimer raycastTimer(ITMProfiler::STAGE_RAYCAST);
 		visualisationEngine->CreatePointCloud(view, trackingState, renderState, settings->skipPoints);
 		trackingState->age_pointCloud = 0;
 	}
 	else
 	{
-		visualisationEngine->CreateExpectedDepths(trackingState->pose_d, &(view->calib->intrinsics_d), renderState);
+		{
+			ITMProfiler::ScopedTimer timer(ITMProfiler::STAGE_EXPECTED_DEPTHS);
+			visualisationEngine->CreateExpectedDepths(trackingState->pose_d, &(view->calib->intrinsics_d), renderState);
+		}
+
+		ITMProfiler::ScopedTimer raycastTimer(ITMProfiler::STAGE_RAYCAST);
+		ITMProfiler::Count(ITMProfiler::COUNTER_FULL_RAYCAST, trackingState->requiresFullRendering ? 1.0 : 0.0);
 
 		if (trackingState->requiresFullRendering)
 		{
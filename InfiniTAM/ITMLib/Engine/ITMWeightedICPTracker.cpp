@@ -22,6 +22,10 @@ ITMWeightedICPTracker::ITMWeightedICPTracker(Vector2i imgSize, TrackerIterationT
 		viewHierarchy = new ITMImageHierarchy<ITMTemplatedHierarchyLevel<ITMFloatImage> >(imgSize, trackingRegime, noHierarchyLevels, memoryType, true);
 		sceneHierarchy = new ITMImageHierarchy<ITMSceneHierarchyLevel>(imgSize, trackingRegime, noHierarchyLevels, memoryType, true);
 	}
+	// the pyramids are only held during TrackCamera(), other trackers can use the pooled images in between
+	weightHierarchy->ReleaseData();
+	viewHierarchy->ReleaseData();
+	sceneHierarchy->ReleaseData();
 
 	this->noIterationsPerLevel = new int[noHierarchyLevels];
 	this->distThresh = new float[noHierarchyLevels];
@@ -160,6 +164,10 @@ void ITMWeightedICPTracker::ApplyDelta(const Matrix4f & para_old, const float *d
 
 void ITMWeightedICPTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView *view)
 {
+	weightHierarchy->AcquireData();
+	viewHierarchy->AcquireData();
+	sceneHierarchy->AcquireData();
+
 	this->SetEvaluationData(trackingState, view);
 	this->PrepareForEvaluation();
 
@@ -188,5 +196,9 @@ void ITMWeightedICPTracker::TrackCamera(ITMTrackingState *trackingState, const I
 			if (HasConverged(step)) break;
 		}
 	}
+
+	weightHierarchy->ReleaseData();
+	viewHierarchy->ReleaseData();
+	sceneHierarchy->ReleaseData();
 }
 
@@ -34,11 +34,6 @@ static void GenericCylinderCast(ITMScene<TVoxel,TIndex> *scene,  Vector3f center
 	float invl = 1/sqrt(rayDirection.x*rayDirection.x + rayDirection.y*rayDirection.y + rayDirection.z*rayDirection.z);
 	rayDirection *= invl;
 
-
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-
 	std::cout << "cylinder center = " << centerPt << std::endl;
 	std::cout << "radius in unit = " << radius*oneOverVoxelSize << std::endl;
 
@@ -61,6 +61,7 @@
 
 #include "Engine/ITMSwappingEngine.h"
 #include "Engine/DeviceSpecific/CPU/ITMSwappingEngine_CPU.h"
+#include "Engine/DeviceSpecific/CPU/ITMAsyncSwappingEngine_CPU.h"
 #ifndef COMPILE_WITHOUT_CUDA
 #include "Engine/DeviceSpecific/CUDA/ITMSwappingEngine_CUDA.h"
 #endif
@@ -0,0 +1,121 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "../../ORUtils/PlatformIndependence.h"
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		    A file of records of up to a fixed size, used as the on-disk
+		    tier of the ITMGlobalCache.
+
+		    Records are addressed by slot. Every slot has room for the
+		    largest record, but only the bytes of the actual record and
+		    its length are written and read. Freed slots are reused
+		    before the file grows, and the file never holds more than
+		    the configured maximum number of records. Without a
+		    directory an anonymous temporary file is used, which the
+		    operating system removes when it is closed; otherwise the
+		    file is created in the directory and deleted by the
+		    destructor.
+		*/
+		class ITMDiskBlockStore
+		{
+		private:
+			FILE *file;
+			std::string fileName;
+
+			/// bytes per slot, the length of the record followed by at most maxRecordBytes bytes
+			size_t slotSize;
+			int maxRecordBytes;
+			int maxNoRecords, noSlots;
+			std::vector<int> freeSlots;
+
+			bool Seek(int slot)
+			{
+				long long offset = (long long)slot * (long long)slotSize;
+#ifdef _WIN32
+				return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+				return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+			}
+
+		public:
+			/** @p maxNoRecords of 0 means no limit. @p directory may be empty.
+			\throws std::runtime_error If the file cannot be created.
+			*/
+			ITMDiskBlockStore(int maxRecordBytes, int maxNoRecords, const std::string &directory)
+				: slotSize(sizeof(int) + maxRecordBytes), maxRecordBytes(maxRecordBytes), maxNoRecords(maxNoRecords), noSlots(0)
+			{
+				if (directory.empty()) file = tmpfile();
+				else
+				{
+					char name[64];
+					sprintf(name, "/infinitam_blocks_%p.bin", (void*)this);
+					fileName = directory + name;
+					file = fopen(fileName.c_str(), "w+b");
+				}
+
+				if (file == NULL) DIEWITHEXCEPTION("could not create the block store file");
+			}
+
+			~ITMDiskBlockStore(void)
+			{
+				fclose(file);
+				if (!fileName.empty()) remove(fileName.c_str());
+			}
+
+			/// Whether another record can be written without exceeding the maximum number of records
+			bool IsFull(void) const { return freeSlots.empty() && maxNoRecords > 0 && noSlots >= maxNoRecords; }
+
+			/// Number of records currently stored
+			int GetNoRecords(void) const { return noSlots - (int)freeSlots.size(); }
+
+			/// Size of the file in bytes, including freed records
+			long long GetFileBytes(void) const { return (long long)noSlots * (long long)slotSize; }
+
+			/// Writes a record of @p noBytes bytes and returns its slot, or -1 if the store is full or the write fails
+			int Write(const void *data, int noBytes)
+			{
+				if (IsFull() || noBytes > maxRecordBytes) return -1;
+
+				int slot;
+				if (!freeSlots.empty()) { slot = freeSlots.back(); freeSlots.pop_back(); }
+				else slot = noSlots++;
+
+				if (!Seek(slot) || fwrite(&noBytes, sizeof(int), 1, file) != 1 || (noBytes > 0 && fwrite(data, noBytes, 1, file) != 1))
+				{
+					freeSlots.push_back(slot);
+					return -1;
+				}
+
+				return slot;
+			}
+
+			/// Reads the record in @p slot into @p data, which must hold the largest record, and returns its length or -1
+			int Read(int slot, void *data)
+			{
+				int noBytes;
+				if (!Seek(slot) || fread(&noBytes, sizeof(int), 1, file) != 1 || noBytes < 0 || noBytes > maxRecordBytes) return -1;
+				if (noBytes > 0 && fread(data, noBytes, 1, file) != 1) return -1;
+				return noBytes;
+			}
+
+			/// Makes @p slot available for reuse
+			void Free(int slot) { freeSlots.push_back(slot); }
+
+			// Suppress the default copy constructor and assignment operator
+			ITMDiskBlockStore(const ITMDiskBlockStore&);
+			ITMDiskBlockStore& operator=(const ITMDiskBlockStore&);
+		};
+	}
+}
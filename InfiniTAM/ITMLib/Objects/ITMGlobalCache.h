@@ -5,7 +5,13 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <string>
+#include <vector>
+
 #include "../Utils/ITMLibDefines.h"
+#include "ITMDiskBlockStore.h"
+#include "ITMVoxelBlockCodec.h"
+#include "../../ORUtils/MemoryRegistry.h"
 #ifndef COMPILE_WITHOUT_CUDA
 #include "../../ORUtils/CUDADefines.h"
 #endif
@@ -14,26 +20,241 @@ namespace ITMLib
 {
 	namespace Objects
 	{
+		/** \brief
+		    Host side store of the voxel blocks that have been swapped
+		    out of the local voxel block array, and the buffers used to
+		    transfer them.
+
+		    Voxel data is only kept for entries that have actually been
+		    swapped out, each hash entry holds the index of its slot in
+		    a pool of blocks, or -1. Memory therefore scales with the
+		    part of the scene that has left the active volume, not with
+		    the number of hash entries. Blocks are stored compressed by
+		    ITMVoxelBlockCodec, and every slot takes only as many bytes
+		    as its encoded block, none for a block of default voxels.
+
+		    With a disk tier set up through SetDiskTier(), at most a
+		    given number of blocks is kept in host memory. Beyond that
+		    the least recently used blocks, stored or read back, are
+		    moved to an ITMDiskBlockStore, still encoded, and are
+		    decoded straight from there when they are requested
+		    again, so the size of the map is bounded by the disk
+		    rather than by RAM.
+		*/
 		template<class TVoxel>
 		class ITMGlobalCache
 		{
 		private:
-			bool *hasStoredData;
-			TVoxel *storedVoxelBlocks;
+			typedef ITMVoxelBlockCodec<TVoxel> Codec;
+
+			/// slot of every hash entry in the block pool, -1 if its data is not in host memory
+			int *storedBlockSlots;
+			int noStoredBlocks;
+
+			/// encoded block, its size in bytes and the hash entry of every slot of the pool; the data is NULL for empty blocks
+			std::vector<unsigned char*> slotData;
+			std::vector<int> slotBytes;
+			std::vector<int> slotEntries;
+			std::vector<int> freeSlots;
+			size_t noEncodedBytes;
+
+			/// room for one encoded block
+			unsigned char *encodedBlock;
+
+			/// doubly linked list of the occupied slots, most recently used first
+			std::vector<int> lruPrevious, lruNext;
+			int lruHead, lruTail;
+
+			/// slot of every hash entry in the disk tier, -1 if its data is not on disk; NULL without disk tier
+			int *diskBlockSlots;
+			ITMDiskBlockStore *diskStore;
+			int hostBlockBudget;
+
 			ITMHashSwapState *swapStates_host, *swapStates_device;
 
+			/// entries whose swap state has become 1, and entries that left the view in state 2, in the order they were added
+			std::vector<int> swapInCandidates, swapOutCandidates;
+
 			bool *hasSyncedData_host, *hasSyncedData_device;
 			TVoxel *syncedVoxelBlocks_host, *syncedVoxelBlocks_device;
 
 			int *neededEntryIDs_host, *neededEntryIDs_device;
+
+			/// second set of host transfer buffers, only allocated for double buffering, see AllocateSecondTransferBuffers()
+			bool *hasSyncedData_second;
+			TVoxel *syncedVoxelBlocks_second;
+			int *neededEntryIDs_second;
+
+			static size_t GetTransferBufferBytes(void) { return SDF_TRANSFER_BLOCK_NUM * (sizeof(TVoxel) * SDF_BLOCK_SIZE3 + sizeof(bool) + sizeof(int)); }
+
+			/// bytes of the fixed size buffers registered with the ORUtils::MemoryRegistry, the buffers are plain allocations
+			size_t GetHostBytes(void) const
+			{
+				return noTotalEntries * (sizeof(int) + sizeof(ITMHashSwapState)) + GetTransferBufferBytes();
+			}
+
+			void LinkFront(int slot)
+			{
+				lruPrevious[slot] = -1; lruNext[slot] = lruHead;
+				if (lruHead >= 0) lruPrevious[lruHead] = slot; else lruTail = slot;
+				lruHead = slot;
+			}
+
+			void Unlink(int slot)
+			{
+				int previous = lruPrevious[slot], next = lruNext[slot];
+				if (previous >= 0) lruNext[previous] = next; else lruHead = next;
+				if (next >= 0) lruPrevious[next] = previous; else lruTail = previous;
+			}
+
+			void Touch(int slot)
+			{
+				if (slot == lruHead) return;
+				Unlink(slot); LinkFront(slot);
+			}
+
+			/// moves the least recently used blocks to disk until a slot can be taken without exceeding the host budget
+			void EvictForNewSlot(void)
+			{
+				if (diskStore == NULL) return;
+
+				while (GetNoHostBlocks() >= hostBlockBudget && lruTail >= 0)
+				{
+					int slot = lruTail, address = slotEntries[slot];
+
+					// if the disk is full, the host budget is exceeded rather than data discarded
+					int diskSlot = diskStore->Write(slotData[slot], slotBytes[slot]);
+					if (diskSlot < 0) break;
+
+					Unlink(slot);
+					SetSlotData(slot, NULL, 0);
+					freeSlots.push_back(slot);
+					storedBlockSlots[address] = -1;
+					diskBlockSlots[address] = diskSlot;
+				}
+			}
+
+			/// replaces the data of @p slot with a copy of @p noBytes bytes of @p data
+			void SetSlotData(int slot, const unsigned char *data, int noBytes)
+			{
+				if (slotBytes[slot] != noBytes && slotData[slot] != NULL)
+				{
+					free(slotData[slot]);
+					ORUtils::MemoryRegistry::RegisterFree("global_cache", MEMORYDEVICE_CPU, slotBytes[slot]);
+					slotData[slot] = NULL;
+				}
+
+				if (noBytes > 0 && slotData[slot] == NULL)
+				{
+					slotData[slot] = (unsigned char*)malloc(noBytes);
+					ORUtils::MemoryRegistry::RegisterAllocation("global_cache", MEMORYDEVICE_CPU, noBytes);
+				}
+
+				if (noBytes > 0) memcpy(slotData[slot], data, noBytes);
+				noEncodedBytes += noBytes - slotBytes[slot];
+				slotBytes[slot] = noBytes;
+			}
+
+			/// takes a free slot from the pool for @p address, which must have none
+			int AllocateSlot(int address)
+			{
+				EvictForNewSlot();
+
+				int slot;
+				if (!freeSlots.empty()) { slot = freeSlots.back(); freeSlots.pop_back(); }
+				else
+				{
+					slot = (int)slotData.size();
+					slotData.push_back(NULL); slotBytes.push_back(0); slotEntries.push_back(-1);
+					lruPrevious.push_back(-1); lruNext.push_back(-1);
+				}
+
+				slotEntries[slot] = address;
+				storedBlockSlots[address] = slot;
+				LinkFront(slot);
+				return slot;
+			}
+
+			/// returns the slot of @p address, taking a free one from the pool if it has none yet; data on disk is dropped
+			int GetOrAllocateSlot(int address)
+			{
+				int slot = storedBlockSlots[address];
+				if (slot >= 0) { Touch(slot); return slot; }
+
+				if (diskBlockSlots != NULL && diskBlockSlots[address] >= 0)
+				{
+					diskStore->Free(diskBlockSlots[address]);
+					diskBlockSlots[address] = -1;
+				}
+				else noStoredBlocks++;
+
+				return AllocateSlot(address);
+			}
+
+			/// decodes the stored block of @p address into @p data, using @p buffer for blocks on disk
+			bool DecodeStoredData(int address, TVoxel *data, unsigned char *buffer) const
+			{
+				int slot = storedBlockSlots[address];
+				if (slot >= 0) { Codec::Decode(slotData[slot], slotBytes[slot], data); return true; }
+				if (diskBlockSlots == NULL || diskBlockSlots[address] < 0) return false;
+
+				int noBytes = diskStore->Read(diskBlockSlots[address], buffer);
+				if (noBytes < 0) DIEWITHEXCEPTION("could not read a voxel block back from disk");
+
+				Codec::Decode(buffer, noBytes, data);
+				return true;
+			}
+
+			size_t GetDeviceBytes(void) const
+			{
+#ifndef COMPILE_WITHOUT_CUDA
+				return noTotalEntries * sizeof(ITMHashSwapState) + GetTransferBufferBytes();
+#else
+				return 0;
+#endif
+			}
 		public:
-			inline void SetStoredData(int address, TVoxel *data) 
-			{ 
-				hasStoredData[address] = true; 
-				memcpy(storedVoxelBlocks + address * SDF_BLOCK_SIZE3, data, sizeof(TVoxel) * SDF_BLOCK_SIZE3);
+			/// Stores a compressed copy of the block @p data for @p address
+			inline void SetStoredData(int address, const TVoxel *data)
+			{
+				int noBytes = Codec::Encode(data, encodedBlock);
+				SetSlotData(GetOrAllocateSlot(address), encodedBlock, noBytes);
+			}
+			inline bool HasStoredData(int address) const { return storedBlockSlots[address] >= 0 || (diskBlockSlots != NULL && diskBlockSlots[address] >= 0); }
+
+			/// Decodes the stored block of @p address into @p data, returns false if it has none. Reading a block from host memory counts as a use for the eviction order.
+			inline bool GetStoredData(int address, TVoxel *data)
+			{
+				if (storedBlockSlots[address] >= 0) Touch(storedBlockSlots[address]);
+				return DecodeStoredData(address, data, encodedBlock);
+			}
+
+			/// number of hash entries that have voxel data in the cache, in host memory or on disk
+			int GetNoStoredBlocks(void) const { return noStoredBlocks; }
+
+			/// number of hash entries whose voxel data is in host memory
+			int GetNoHostBlocks(void) const { return (int)(slotData.size() - freeSlots.size()); }
+
+			/// bytes of the encoded blocks in host memory
+			size_t GetNoEncodedBytes(void) const { return noEncodedBytes; }
+
+			/// number of hash entries whose voxel data has been moved to disk
+			int GetNoDiskBlocks(void) const { return diskStore != NULL ? diskStore->GetNoRecords() : 0; }
+
+			/** Keeps at most @p hostBlockBudget blocks in host memory and moves the least recently used
+			ones beyond that to a file in @p directory, or to an anonymous temporary file if it is empty.
+			At most @p diskBlockBudget blocks are written to disk, 0 for no limit. Call this once, before
+			any data is stored.
+			*/
+			void SetDiskTier(int hostBlockBudget, int diskBlockBudget, const std::string &directory)
+			{
+				this->hostBlockBudget = hostBlockBudget > 0 ? hostBlockBudget : 1;
+
+				diskStore = new ITMDiskBlockStore(Codec::MAX_ENCODED_BYTES, diskBlockBudget, directory);
+				diskBlockSlots = (int*)malloc(noTotalEntries * sizeof(int));
+				memset(diskBlockSlots, -1, noTotalEntries * sizeof(int));
+				ORUtils::MemoryRegistry::RegisterAllocation("global_cache", MEMORYDEVICE_CPU, noTotalEntries * sizeof(int));
 			}
-			inline bool HasStoredData(int address) const { return hasStoredData[address]; }
-			inline TVoxel *GetStoredVoxelBlock(int address) { return storedVoxelBlocks + address * SDF_BLOCK_SIZE3; }
 
 			bool *GetHasSyncedData(bool useGPU) const { return useGPU ? hasSyncedData_device : hasSyncedData_host; }
 			TVoxel *GetSyncedVoxelBlocks(bool useGPU) const { return useGPU ? syncedVoxelBlocks_device : syncedVoxelBlocks_host; }
@@ -41,13 +262,49 @@ namespace ITMLib
 			ITMHashSwapState *GetSwapStates(bool useGPU) { return useGPU ? swapStates_device : swapStates_host; }
 			int *GetNeededEntryIDs(bool useGPU) { return useGPU ? neededEntryIDs_device : neededEntryIDs_host; }
 
+			/** Entries that may have to be swapped in or out, maintained on the host by the CPU scene
+			reconstruction engine. An entry can be listed more than once or no longer qualify, so the
+			swapping engine checks each again and removes the ones it has dealt with.
+			*/
+			std::vector<int> &GetSwapInCandidates(void) { return swapInCandidates; }
+			std::vector<int> &GetSwapOutCandidates(void) { return swapOutCandidates; }
+
+			/** Allocates a second set of host transfer buffers, so that one set can be filled while
+			the blocks in the other are moved in or out of the cache. Set 0 is the one returned by
+			the functions above for the host.
+			*/
+			void AllocateSecondTransferBuffers(void)
+			{
+				if (syncedVoxelBlocks_second != NULL) return;
+
+				syncedVoxelBlocks_second = (TVoxel*)malloc(SDF_TRANSFER_BLOCK_NUM * sizeof(TVoxel) * SDF_BLOCK_SIZE3);
+				hasSyncedData_second = (bool*)malloc(SDF_TRANSFER_BLOCK_NUM * sizeof(bool));
+				neededEntryIDs_second = (int*)malloc(SDF_TRANSFER_BLOCK_NUM * sizeof(int));
+				ORUtils::MemoryRegistry::RegisterAllocation("global_cache", MEMORYDEVICE_CPU, GetTransferBufferBytes());
+			}
+
+			bool *GetHostHasSyncedData(int bufferId) const { return bufferId == 0 ? hasSyncedData_host : hasSyncedData_second; }
+			TVoxel *GetHostSyncedVoxelBlocks(int bufferId) const { return bufferId == 0 ? syncedVoxelBlocks_host : syncedVoxelBlocks_second; }
+			int *GetHostNeededEntryIDs(int bufferId) const { return bufferId == 0 ? neededEntryIDs_host : neededEntryIDs_second; }
+
 			int noTotalEntries; 
 
 			ITMGlobalCache() : noTotalEntries(SDF_BUCKET_NUM + SDF_EXCESS_LIST_SIZE)
 			{	
-				hasStoredData = (bool*)malloc(noTotalEntries * sizeof(bool));
-				storedVoxelBlocks = (TVoxel*)malloc(noTotalEntries * sizeof(TVoxel) * SDF_BLOCK_SIZE3);
-				memset(hasStoredData, 0, noTotalEntries);
+				storedBlockSlots = (int*)malloc(noTotalEntries * sizeof(int));
+				memset(storedBlockSlots, -1, noTotalEntries * sizeof(int));
+				noStoredBlocks = 0;
+				noEncodedBytes = 0;
+				encodedBlock = (unsigned char*)malloc(Codec::MAX_ENCODED_BYTES);
+				lruHead = lruTail = -1;
+
+				diskBlockSlots = NULL;
+				diskStore = NULL;
+				hostBlockBudget = 0;
+
+				hasSyncedData_second = NULL;
+				syncedVoxelBlocks_second = NULL;
+				neededEntryIDs_second = NULL;
 
 				swapStates_host = (ITMHashSwapState *)malloc(noTotalEntries * sizeof(ITMHashSwapState));
 				memset(swapStates_host, 0, sizeof(ITMHashSwapState) * noTotalEntries);
@@ -69,48 +326,79 @@ namespace ITMLib
 				hasSyncedData_host = (bool*)malloc(SDF_TRANSFER_BLOCK_NUM * sizeof(bool));
 				neededEntryIDs_host = (int*)malloc(SDF_TRANSFER_BLOCK_NUM * sizeof(int));
 #endif
+
+				ORUtils::MemoryRegistry::RegisterAllocation("global_cache", MEMORYDEVICE_CPU, GetHostBytes());
+				ORUtils::MemoryRegistry::RegisterAllocation("global_cache", MEMORYDEVICE_CUDA, GetDeviceBytes());
 			}
 
+			/// Writes a flag per hash entry followed by one block per entry, blocks without stored data are written as default voxels
 			void SaveToFile(char *fileName) const
 			{
-				TVoxel *storedData = storedVoxelBlocks;
-
 				FILE *f = fopen(fileName, "wb");
 
+				bool *hasStoredData = (bool*)malloc(noTotalEntries * sizeof(bool));
+				for (int i = 0; i < noTotalEntries; i++) hasStoredData[i] = HasStoredData(i);
 				fwrite(hasStoredData, sizeof(bool), noTotalEntries, f);
+				free(hasStoredData);
+
+				TVoxel *block = new TVoxel[SDF_BLOCK_SIZE3], *emptyBlock = new TVoxel[SDF_BLOCK_SIZE3];
+				unsigned char *buffer = (unsigned char*)malloc(Codec::MAX_ENCODED_BYTES);
 				for (int i = 0; i < noTotalEntries; i++)
 				{
-					fwrite(storedData, sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
-					storedData += SDF_BLOCK_SIZE3;
+					if (DecodeStoredData(i, block, buffer)) fwrite(block, sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
+					else fwrite(emptyBlock, sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
 				}
+				free(buffer);
+				delete[] block;
+				delete[] emptyBlock;
 
 				fclose(f);
 			}
 
+			/// Reads a file written by SaveToFile() into an empty cache; only blocks flagged as stored take up memory in the cache
 			void ReadFromFile(char *fileName)
 			{
-				TVoxel *storedData = storedVoxelBlocks;
 				FILE *f = fopen(fileName, "rb");
 
+				bool *hasStoredData = (bool*)malloc(noTotalEntries * sizeof(bool));
+				TVoxel *block = new TVoxel[SDF_BLOCK_SIZE3];
 				size_t tmp = fread(hasStoredData, sizeof(bool), noTotalEntries, f);
 				if (tmp == (size_t)noTotalEntries) {
 					for (int i = 0; i < noTotalEntries; i++)
 					{
-						fread(storedData, sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
-						storedData += SDF_BLOCK_SIZE3;
+						if (hasStoredData[i] && fread(block, sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f) == 1) SetStoredData(i, block);
+						else if (!hasStoredData[i]) fseek(f, sizeof(TVoxel) * SDF_BLOCK_SIZE3, SEEK_CUR);
 					}
 				}
+				delete[] block;
+				free(hasStoredData);
 
 				fclose(f);
 			}
 
 			~ITMGlobalCache(void) 
 			{
-				free(hasStoredData);
-				free(storedVoxelBlocks);
+				free(storedBlockSlots);
+				for (size_t i = 0; i < slotData.size(); i++) SetSlotData((int)i, NULL, 0);
+				free(encodedBlock);
+
+				if (diskStore != NULL)
+				{
+					delete diskStore;
+					free(diskBlockSlots);
+					ORUtils::MemoryRegistry::RegisterFree("global_cache", MEMORYDEVICE_CPU, noTotalEntries * sizeof(int));
+				}
 
 				free(swapStates_host);
 
+				if (syncedVoxelBlocks_second != NULL)
+				{
+					free(syncedVoxelBlocks_second);
+					free(hasSyncedData_second);
+					free(neededEntryIDs_second);
+					ORUtils::MemoryRegistry::RegisterFree("global_cache", MEMORYDEVICE_CPU, GetTransferBufferBytes());
+				}
+
 #ifndef COMPILE_WITHOUT_CUDA
 				ITMSafeCall(cudaFreeHost(hasSyncedData_host));
 				ITMSafeCall(cudaFreeHost(syncedVoxelBlocks_host));
@@ -125,6 +413,9 @@ namespace ITMLib
 				free(syncedVoxelBlocks_host);
 				free(neededEntryIDs_host);
 #endif
+
+				ORUtils::MemoryRegistry::RegisterFree("global_cache", MEMORYDEVICE_CPU, GetHostBytes());
+				ORUtils::MemoryRegistry::RegisterFree("global_cache", MEMORYDEVICE_CUDA, GetDeviceBytes());
 			}
 		};
 	}
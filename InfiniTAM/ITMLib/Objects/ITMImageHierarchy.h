@@ -31,6 +31,14 @@ namespace ITMLib
 			void UpdateDeviceFromHost()
 			{ for (int i = 0; i < noLevels; i++) this->levels[i]->UpdateDeviceFromHost(); }
 
+			/// Hands the pooled images of all levels back to the MemoryPool while the hierarchy is not in use, so that the hierarchies of other trackers can take them. Their contents are lost.
+			void ReleaseData()
+			{ for (int i = 0; i < noLevels; i++) this->levels[i]->ReleaseData(); }
+
+			/// Takes the images of all levels from the MemoryPool again, before the hierarchy is filled
+			void AcquireData()
+			{ for (int i = 0; i < noLevels; i++) this->levels[i]->AcquireData(); }
+
 			~ITMImageHierarchy(void)
 			{
 				for (int i = 0; i < noLevels; i++) delete levels[i];
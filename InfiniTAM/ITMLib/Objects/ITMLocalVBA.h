@@ -43,6 +43,7 @@ namespace ITMLib
 
 				allocatedSize = noBlocks * blockSize;
 
+				ORUtils::ScopedMemoryTag tag("voxel_blocks");
 				voxelBlocks = new ORUtils::MemoryBlock<TVoxel>(allocatedSize, memoryType);
 				allocationList = new ORUtils::MemoryBlock<int>(noBlocks, memoryType);
 			}
@@ -149,6 +149,7 @@ namespace ITMLib
 			~ITMMesh()
 			{
 				delete triangles;
+				delete vertices;
 			}
 
 			// Suppress the default copy constructor and assignment operator
@@ -50,6 +50,7 @@ namespace ITMLib
 			{
 				this->memoryType = memoryType;
 
+				ORUtils::ScopedMemoryTag tag("scene_index");
 				if (memoryType == MEMORYDEVICE_CUDA) indexData = new ORUtils::MemoryBlock<IndexData>(1, true, true);
 				else indexData = new ORUtils::MemoryBlock<IndexData>(1, true, false);
 
@@ -28,8 +28,8 @@ namespace ITMLib
 				this->iterationType = iterationType;
 
 				if (!skipAllocation) {
-					this->pointsMap = new ITMFloat4Image(imgSize, memoryType);
-					this->normalsMap = new ITMFloat4Image(imgSize, memoryType);
+					this->pointsMap = new ITMFloat4Image(imgSize, memoryType, true);
+					this->normalsMap = new ITMFloat4Image(imgSize, memoryType, true);
 				}
 			}
 
@@ -45,6 +45,20 @@ namespace ITMLib
 				this->normalsMap->UpdateDeviceFromHost();
 			}
 
+			void ReleaseData()
+			{
+				if (!manageData) return;
+				this->pointsMap->ReleaseToPool();
+				this->normalsMap->ReleaseToPool();
+			}
+
+			void AcquireData()
+			{
+				if (!manageData) return;
+				this->pointsMap->AcquireFromPool();
+				this->normalsMap->AcquireFromPool();
+			}
+
 			~ITMSceneHierarchyLevel(void)
 			{
 				if (manageData) {
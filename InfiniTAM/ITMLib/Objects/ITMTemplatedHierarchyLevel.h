@@ -25,7 +25,7 @@ namespace ITMLib
 				this->levelId = levelId;
 				this->iterationType = iterationType;
 
-				if (!skipAllocation) this->depth = new ImageType(imgSize, memoryType);
+				if (!skipAllocation) this->depth = new ImageType(imgSize, memoryType, true);
 			}
 
 			void UpdateHostFromDevice()
@@ -38,6 +38,16 @@ namespace ITMLib
 				this->depth->UpdateHostFromDevice();
 			}
 
+			void ReleaseData()
+			{
+				if (manageData) this->depth->ReleaseToPool();
+			}
+
+			void AcquireData()
+			{
+				if (manageData) this->depth->AcquireFromPool();
+			}
+
 			~ITMTemplatedHierarchyLevel(void)
 			{
 				if (manageData) delete depth;
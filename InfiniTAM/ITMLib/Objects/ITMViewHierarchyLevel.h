@@ -28,10 +28,10 @@ namespace ITMLib
 				this->iterationType = iterationType;
 
 				if (!skipAllocation) {
-					this->rgb = new ITMUChar4Image(imgSize, memoryType);
-					this->depth = new ITMFloatImage(imgSize, memoryType);
-					this->gradientX_rgb = new ITMShort4Image(imgSize, memoryType);
-					this->gradientY_rgb = new ITMShort4Image(imgSize, memoryType);
+					this->rgb = new ITMUChar4Image(imgSize, memoryType, true);
+					this->depth = new ITMFloatImage(imgSize, memoryType, true);
+					this->gradientX_rgb = new ITMShort4Image(imgSize, memoryType, true);
+					this->gradientY_rgb = new ITMShort4Image(imgSize, memoryType, true);
 				}
 			}
 
@@ -51,6 +51,24 @@ namespace ITMLib
 				this->gradientY_rgb->UpdateDeviceFromHost();
 			}
 
+			void ReleaseData()
+			{
+				if (!manageData) return;
+				this->rgb->ReleaseToPool();
+				this->depth->ReleaseToPool();
+				this->gradientX_rgb->ReleaseToPool();
+				this->gradientY_rgb->ReleaseToPool();
+			}
+
+			void AcquireData()
+			{
+				if (!manageData) return;
+				this->rgb->AcquireFromPool();
+				this->depth->AcquireFromPool();
+				this->gradientX_rgb->AcquireFromPool();
+				this->gradientY_rgb->AcquireFromPool();
+			}
+
 			~ITMViewHierarchyLevel(void)
 			{
 				if (manageData) {
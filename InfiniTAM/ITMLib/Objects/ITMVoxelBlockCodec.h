@@ -0,0 +1,157 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <string.h>
+
+#include <new>
+
+#include "../Utils/ITMLibDefines.h"
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		    Lossless compression of single voxel blocks, used for the
+		    blocks kept in the ITMGlobalCache.
+
+		    A block that consists of default voxels only, with zero
+		    padding bytes, is encoded in zero bytes. Any other block is
+		    split into byte planes, one per byte of the voxel type, and
+		    each plane is run length encoded: the truncated SDF values,
+		    weights and colours of a block are mostly identical, so the
+		    planes collapse into a few runs even where the full voxels
+		    differ. If that does not make the block smaller, it is
+		    stored as is behind a one byte header.
+		*/
+		template<class TVoxel>
+		class ITMVoxelBlockCodec
+		{
+		public:
+			static const int BLOCK_BYTES = sizeof(TVoxel) * SDF_BLOCK_SIZE3;
+
+			/// upper bound of the size of an encoded block
+			static const int MAX_ENCODED_BYTES = BLOCK_BYTES + 1;
+
+		private:
+			enum { MODE_RAW = 0, MODE_PLANES = 1 };
+
+			/// a control byte below 128 is followed by that many plus one literal bytes, from 128 on by one byte repeated that many minus 126 times
+			static const int MAX_LITERALS = 128, MAX_REPEATS = 129;
+
+			/// a block of default voxels whose padding bytes are zero, so that blocks can be compared with it bytewise
+			struct EmptyBlock
+			{
+				alignas(TVoxel) unsigned char bytes[BLOCK_BYTES];
+
+				EmptyBlock(void)
+				{
+					memset(bytes, 0, BLOCK_BYTES);
+					for (int i = 0; i < SDF_BLOCK_SIZE3; i++) new (bytes + i * sizeof(TVoxel)) TVoxel();
+				}
+			};
+
+			static const unsigned char *GetEmptyBlock(void)
+			{
+				static const EmptyBlock emptyBlock;
+				return emptyBlock.bytes;
+			}
+
+			/// run length encodes every stride-th byte of @p plane into at most @p maxNoBytes bytes, returns -1 if they do not suffice
+			static int EncodePlane(const unsigned char *plane, int stride, unsigned char *encoded, int maxNoBytes)
+			{
+				int noBytes = 0, i = 0;
+				while (i < SDF_BLOCK_SIZE3)
+				{
+					// every control byte is followed by at most MAX_LITERALS bytes
+					if (noBytes + 1 + MAX_LITERALS > maxNoBytes) return -1;
+
+					unsigned char value = plane[i * stride];
+
+					int noRepeats = 1;
+					while (i + noRepeats < SDF_BLOCK_SIZE3 && noRepeats < MAX_REPEATS && plane[(i + noRepeats) * stride] == value) noRepeats++;
+
+					if (noRepeats > 1)
+					{
+						encoded[noBytes++] = (unsigned char)(noRepeats + 126);
+						encoded[noBytes++] = value;
+						i += noRepeats;
+						continue;
+					}
+
+					// literals up to the start of the next run
+					int noLiterals = 1;
+					while (i + noLiterals < SDF_BLOCK_SIZE3 && noLiterals < MAX_LITERALS &&
+						(i + noLiterals + 1 >= SDF_BLOCK_SIZE3 || plane[(i + noLiterals) * stride] != plane[(i + noLiterals + 1) * stride])) noLiterals++;
+
+					encoded[noBytes++] = (unsigned char)(noLiterals - 1);
+					for (int j = 0; j < noLiterals; j++) encoded[noBytes++] = plane[(i + j) * stride];
+					i += noLiterals;
+				}
+
+				return noBytes;
+			}
+
+			/// returns the position after the plane in @p encoded
+			static const unsigned char *DecodePlane(const unsigned char *encoded, int stride, unsigned char *plane)
+			{
+				int i = 0;
+				while (i < SDF_BLOCK_SIZE3)
+				{
+					int control = *encoded++;
+					if (control < MAX_LITERALS)
+					{
+						for (int j = 0; j <= control; j++, i++) plane[i * stride] = *encoded++;
+					}
+					else
+					{
+						unsigned char value = *encoded++;
+						for (int j = 0; j < control - 126; j++, i++) plane[i * stride] = value;
+					}
+				}
+
+				return encoded;
+			}
+
+		public:
+			/// Encodes @p block into @p encoded, which must hold MAX_ENCODED_BYTES, and returns the number of bytes used
+			static int Encode(const TVoxel *block, unsigned char *encoded)
+			{
+				const unsigned char *bytes = (const unsigned char*)block;
+				if (memcmp(bytes, GetEmptyBlock(), BLOCK_BYTES) == 0) return 0;
+
+				int noBytes = 1;
+				for (int plane = 0; plane < (int)sizeof(TVoxel); plane++)
+				{
+					int noPlaneBytes = EncodePlane(bytes + plane, sizeof(TVoxel), encoded + noBytes, BLOCK_BYTES - noBytes);
+					if (noPlaneBytes < 0)
+					{
+						encoded[0] = MODE_RAW;
+						memcpy(encoded + 1, bytes, BLOCK_BYTES);
+						return MAX_ENCODED_BYTES;
+					}
+
+					noBytes += noPlaneBytes;
+				}
+
+				encoded[0] = MODE_PLANES;
+				return noBytes;
+			}
+
+			/// Restores the block of @p noBytes bytes written by Encode()
+			static void Decode(const unsigned char *encoded, int noBytes, TVoxel *block)
+			{
+				unsigned char *bytes = (unsigned char*)block;
+
+				if (noBytes == 0) memcpy(bytes, GetEmptyBlock(), BLOCK_BYTES);
+				else if (encoded[0] == MODE_RAW) memcpy(bytes, encoded + 1, BLOCK_BYTES);
+				else
+				{
+					encoded++;
+					for (int plane = 0; plane < (int)sizeof(TVoxel); plane++) encoded = DecodePlane(encoded, sizeof(TVoxel), bytes + plane);
+				}
+			}
+		};
+	}
+}
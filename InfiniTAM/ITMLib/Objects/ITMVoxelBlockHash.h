@@ -54,6 +54,8 @@ namespace ITMLib
 			ITMVoxelBlockHash(MemoryDeviceType memoryType)
 			{
 				this->memoryType = memoryType;
+
+				ORUtils::ScopedMemoryTag tag("scene_index");
 				hashEntries = new ORUtils::MemoryBlock<ITMHashEntry>(noTotalEntries, memoryType);
 				excessAllocationList = new ORUtils::MemoryBlock<int>(SDF_EXCESS_LIST_SIZE, memoryType);
 			}
@@ -3,6 +3,7 @@
 #include "ITMCalibIO.h"
 
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 
 using namespace ITMLib::Objects;
@@ -110,3 +111,44 @@ bool ITMLib::Objects::readRGBDCalib(const char *rgbIntrinsicsFile, const char *d
 	return ret;
 }
 
+bool ITMLib::Objects::writeIntrinsics(std::ostream & dest, const ITMIntrinsics & src, const Vector2i & imgSize)
+{
+	const ITMIntrinsics::ProjectionParamsSimple & p = src.projectionParamsSimple;
+
+	dest << std::setprecision(9);
+	dest << imgSize.x << " " << imgSize.y << "\n";
+	dest << p.fx << " " << p.fy << "\n";
+	dest << p.px << " " << p.py << "\n";
+	return !dest.fail();
+}
+
+bool ITMLib::Objects::writeExtrinsics(std::ostream & dest, const ITMExtrinsics & src)
+{
+	const Matrix4f & calib = src.calib;
+
+	dest << std::setprecision(9);
+	dest << calib.m00 << " " << calib.m10 << " " << calib.m20 << " " << calib.m30 << "\n";
+	dest << calib.m01 << " " << calib.m11 << " " << calib.m21 << " " << calib.m31 << "\n";
+	dest << calib.m02 << " " << calib.m12 << " " << calib.m22 << " " << calib.m32 << "\n";
+	return !dest.fail();
+}
+
+bool ITMLib::Objects::writeDisparityCalib(std::ostream & dest, const ITMDisparityCalib & src)
+{
+	dest << std::setprecision(9);
+	dest << ((src.type == ITMDisparityCalib::TRAFO_KINECT) ? "kinect " : "affine ");
+	dest << src.params.x << " " << src.params.y << "\n";
+	return !dest.fail();
+}
+
+bool ITMLib::Objects::writeRGBDCalib(std::ostream & dest, const ITMRGBDCalib & src, const Vector2i & imgSize_rgb, const Vector2i & imgSize_d)
+{
+	if (!ITMLib::Objects::writeIntrinsics(dest, src.intrinsics_rgb, imgSize_rgb)) return false;
+	dest << "\n";
+	if (!ITMLib::Objects::writeIntrinsics(dest, src.intrinsics_d, imgSize_d)) return false;
+	dest << "\n";
+	if (!ITMLib::Objects::writeExtrinsics(dest, src.trafo_rgb_to_depth)) return false;
+	dest << "\n";
+	if (!ITMLib::Objects::writeDisparityCalib(dest, src.disparityCalib)) return false;
+	return true;
+}
@@ -20,6 +20,15 @@ namespace ITMLib
 		bool readRGBDCalib(const char *fileName, ITMRGBDCalib & dest);
 
 		bool readRGBDCalib(const char *rgbIntrinsicsFile, const char *depthIntrinsicsFile, const char *disparityCalibFile, const char *extrinsicsFile, ITMRGBDCalib & dest);
+
+		/** Write calibration in the format understood by the read
+		    functions above. The image sizes are only stored for
+		    reference, they are ignored when reading.
+		*/
+		bool writeIntrinsics(std::ostream & dest, const ITMIntrinsics & src, const Vector2i & imgSize);
+		bool writeExtrinsics(std::ostream & dest, const ITMExtrinsics & src);
+		bool writeDisparityCalib(std::ostream & dest, const ITMDisparityCalib & src);
+		bool writeRGBDCalib(std::ostream & dest, const ITMRGBDCalib & src, const Vector2i & imgSize_rgb, const Vector2i & imgSize_d);
 	}
 }
 
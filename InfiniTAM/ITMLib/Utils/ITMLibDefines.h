@@ -73,6 +73,9 @@ struct ITMHashSwapState
 	///     yet been combined
 	/// 2 - most recent data is in active memory, should save this data
 	///     back to host at some point
+	/// 3 - data is being brought back from the host by the asynchronous
+	///     swapping engine, the block in active memory is left alone
+	///     until it has arrived
 	uchar state;
 };
 
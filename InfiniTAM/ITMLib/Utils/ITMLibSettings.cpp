@@ -15,6 +15,14 @@ ITMLibSettings::ITMLibSettings(void)
 	/// For ITMDepthTracker: ICP iteration termination threshold
 	depthTrackerTerminationThreshold = 1e-3f;
 
+	/// For ITMDepthTracker: spread at most this many milliseconds per frame over the
+	/// levels, ending levels early once they converge; 0 runs the fixed schedule
+	depthTrackerTimeBudget = 0.0f;
+
+	/// For ITMDepthTracker: track on at most this many points per level, picked so that
+	/// all surface orientations are represented, 0 uses every valid pixel
+	depthTrackerPointBudget = 0;
+
 	/// skips every other point when using the colour tracker
 	skipPoints = true;
 
@@ -33,17 +41,57 @@ ITMLibSettings::ITMLibSettings(void)
 	/// enables or disables swapping. HERE BE DRAGONS: It should work, but requires more testing
 	useSwapping = false;
 
+	/// with swapping, keep at most this many swapped out blocks in host memory and
+	/// move the least recently used ones to disk, 0 keeps all of them in host memory
+	swappingHostBlockBudget = 0;
+	swappingDiskBlockBudget = 0;
+	swappingDirectory = "";
+
+	/// with swapping on the CPU, never wait for the global cache: blocks that are still
+	/// being swapped in are not integrated into until they have arrived
+	useAsynchronousSwapping = false;
+
+	/// with swapping, request the blocks that will be visible a few frames ahead at
+	/// constant camera velocity, at most this many per frame and the closest to the
+	/// predicted camera first, so that the swapping bandwidth is left to the blocks
+	/// that are visible now; disabled by default
+	swappingPrefetchFrames = 0;
+	swappingPrefetchBlockBudget = 256;
+
 	/// enables or disables approximate raycast
 	useApproximateRaycast = false;
 
 	/// enable or disable bilateral depth filtering;
 	useBilateralFilter = false;
 
-	//trackerType = TRACKER_COLOR;
-	trackerType = TRACKER_ICP;
-	//trackerType = TRACKER_REN;
-	//trackerType = TRACKER_IMU;
-	//trackerType = TRACKER_WICP;
+	/// track frame N+1 while frame N is still being fused and raycast. The tracking
+	/// reference is then at most one frame older than in sequential processing.
+	usePipelinedProcessing = false;
+
+	/// record per-stage timings of the processing pipeline in ITMProfiler
+	useProfiling = false;
+
+	/// request transparent huge pages for the large host allocations of the scene (Linux only)
+	useHugePages = false;
+
+	/// interleave the pages of the scene over all NUMA nodes instead of placing them on first touch
+	useNUMAInterleave = false;
+
+	/// leave thread placement to the operating system (or to OMP_PROC_BIND / OMP_PLACES)
+	threadAffinity = ITMThreadAffinity::AFFINITY_NONE;
+
+	trackingRegime = NULL;
+
+	//SetTrackerType(TRACKER_COLOR);
+	SetTrackerType(TRACKER_ICP);
+	//SetTrackerType(TRACKER_REN);
+	//SetTrackerType(TRACKER_IMU);
+	//SetTrackerType(TRACKER_WICP);
+}
+
+void ITMLibSettings::SetTrackerType(TrackerType type)
+{
+	trackerType = type;
 
 	/// model the sensor noise as  the weight for weighted ICP
 	modelSensorNoise = false;
@@ -51,6 +99,7 @@ ITMLibSettings::ITMLibSettings(void)
 	
 
 	// builds the tracking regime. level 0 is full resolution
+	delete[] trackingRegime;
 	if (trackerType == TRACKER_IMU)
 	{
 		noHierarchyLevels = 2;
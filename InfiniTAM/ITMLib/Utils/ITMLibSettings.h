@@ -2,8 +2,11 @@
 
 #pragma once
 
+#include <string>
+
 #include "../Objects/ITMSceneParams.h"
 #include "../Engine/ITMTracker.h"
+#include "ITMThreadAffinity.h"
 
 namespace ITMLib
 {
@@ -25,12 +28,40 @@ namespace ITMLib
 			/// Enables swapping between host and device.
 			bool useSwapping;
 
+			/// Maximum number of swapped out voxel blocks kept in host memory, 0 to keep all of them; the rest go to disk.
+			int swappingHostBlockBudget;
+			/// Maximum number of voxel blocks written to disk, 0 for no limit.
+			int swappingDiskBlockBudget;
+			/// Directory of the file holding the blocks on disk, an anonymous temporary file if empty.
+			std::string swappingDirectory;
+			/// Moves blocks into and out of the global cache on a background thread, CPU only.
+			bool useAsynchronousSwapping;
+			/// Number of frames ahead the camera motion is extrapolated to swap in blocks before they come into view, 0 (the default) to disable; CPU only.
+			int swappingPrefetchFrames;
+			/// Maximum number of blocks requested per frame because of the predicted camera motion, the closest to the predicted camera first.
+			int swappingPrefetchBlockBudget;
+
 			bool useApproximateRaycast;
 
 			bool useBilateralFilter;
 
 			bool modelSensorNoise;
 
+			/// Overlaps tracking of the next frame with fusion and raycasting of the current one on a second thread.
+			bool usePipelinedProcessing;
+
+			/// Collects per-stage timings and counters, see ITMProfiler.
+			bool useProfiling;
+
+			/// Backs large host allocations such as the voxel blocks and the hash table by transparent huge pages, see ORUtils::setHugePagesEnabled().
+			bool useHugePages;
+
+			/// Spreads the large host allocations of the scene over all NUMA nodes, see ORUtils::setNUMAInterleaveEnabled().
+			bool useNUMAInterleave;
+
+			/// Placement of the OpenMP threads of the CPU engines, see ITMThreadAffinity.
+			ITMThreadAffinity::Mode threadAffinity;
+
 			/// Tracker types
 			typedef enum {
 				//! Identifies a tracker based on colour image
@@ -45,7 +76,7 @@ namespace ITMLib
 				TRACKER_WICP
 			} TrackerType;
 
-			/// Select the type of tracker to use
+			/// Select the type of tracker to use; set it through SetTrackerType()
 			TrackerType trackerType;
 
 			/// The tracking regime used by the tracking controller
@@ -66,12 +97,21 @@ namespace ITMLib
 			/// For ITMDepthTracker: ICP iteration termination threshold
 			float depthTrackerTerminationThreshold;
 
+			/// For ITMDepthTracker: time in milliseconds tracking a frame may take, iterations are skipped to meet it; 0 for no limit
+			float depthTrackerTimeBudget;
+
+			/// For ITMDepthTracker: maximum number of points per level, chosen by normal space sampling, 0 to use all pixels; CPU only
+			int depthTrackerPointBudget;
+
 			/// Further, scene specific parameters such as voxel size
 			ITMLib::Objects::ITMSceneParams sceneParams;
 
 			ITMLibSettings(void);
 			~ITMLibSettings(void);
 
+			/// Selects the tracker and sets up the tracking regime and other settings that depend on it
+			void SetTrackerType(TrackerType type);
+
 			// Suppress the default copy constructor and assignment operator
 			ITMLibSettings(const ITMLibSettings&);
 			ITMLibSettings& operator=(const ITMLibSettings&);
@@ -0,0 +1,294 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMProfiler.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace ITMLib::Objects;
+
+std::atomic<bool> ITMProfiler::enabled(false);
+std::atomic<bool> ITMProfiler::tracing(false);
+
+namespace {
+
+static const char *stageNames[ITMProfiler::NUM_STAGES] = {
+	"process_frame", "view", "track", "mapping", "allocation", "integration", "swap_in", "swap_out",
+	"prepare", "expected_depths", "raycast", "pipeline_wait"
+};
+
+static const char *counterNames[ITMProfiler::NUM_COUNTERS] = {
+	"visible_blocks", "full_raycast", "late_blocks", "predicted_blocks", "icp_points", "tracker_iterations", "tracker_budget_used"
+};
+
+/// ring buffer holding the most recent samples of one stage or counter
+struct SampleWindow
+{
+	std::vector<double> samples;
+	int next, noSamples;
+
+	void Reset(int windowSize)
+	{
+		samples.assign(windowSize, 0.0);
+		next = 0; noSamples = 0;
+	}
+
+	void Add(double value)
+	{
+		samples[next] = value;
+		next = (next + 1) % (int)samples.size();
+		if (noSamples < (int)samples.size()) noSamples++;
+	}
+
+	ITMProfiler::Statistics GetStatistics(void) const
+	{
+		ITMProfiler::Statistics stats;
+		stats.noSamples = noSamples;
+		stats.mean = stats.p50 = stats.p95 = stats.p99 = stats.max = 0.0;
+		if (noSamples == 0) return stats;
+
+		std::vector<double> sorted(samples.begin(), samples.begin() + noSamples);
+		std::sort(sorted.begin(), sorted.end());
+
+		double sum = 0.0;
+		for (int i = 0; i < noSamples; i++) sum += sorted[i];
+
+		stats.mean = sum / noSamples;
+		stats.p50 = Percentile(sorted, 0.50);
+		stats.p95 = Percentile(sorted, 0.95);
+		stats.p99 = Percentile(sorted, 0.99);
+		stats.max = sorted[noSamples - 1];
+		return stats;
+	}
+
+	/// nearest rank percentile of sorted samples
+	static double Percentile(const std::vector<double> & sorted, double p)
+	{
+		int rank = (int)ceil(p * sorted.size());
+		if (rank < 1) rank = 1;
+		if (rank > (int)sorted.size()) rank = (int)sorted.size();
+		return sorted[rank - 1];
+	}
+};
+
+struct ProfilerData
+{
+	// stages are recorded from the mapping thread as well when processing is pipelined
+	std::mutex mutex;
+	SampleWindow stages[ITMProfiler::NUM_STAGES];
+	SampleWindow counters[ITMProfiler::NUM_COUNTERS];
+
+	explicit ProfilerData(int windowSize) { Reset(windowSize); }
+
+	void Reset(int windowSize)
+	{
+		for (int i = 0; i < ITMProfiler::NUM_STAGES; i++) stages[i].Reset(windowSize);
+		for (int i = 0; i < ITMProfiler::NUM_COUNTERS; i++) counters[i].Reset(windowSize);
+	}
+};
+
+static ProfilerData & GetData(void)
+{
+	static ProfilerData data(1024);
+	return data;
+}
+
+struct TraceData
+{
+	std::mutex mutex;
+	FILE *f;
+	double startTime;
+	bool firstEvent;
+	std::map<int, std::string> threadNames;
+};
+
+static TraceData & GetTraceData(void)
+{
+	static TraceData data;
+	return data;
+}
+
+/// small, stable ids for the trace, in the order in which threads first report
+static int GetThreadId(void)
+{
+	static std::atomic<int> nextThreadId(0);
+	static thread_local int threadId = nextThreadId++;
+	return threadId;
+}
+
+}
+
+void ITMProfiler::SetEnabled(bool enable)
+{
+	// make sure the sample buffers exist before the first timer is started
+	GetData();
+	enabled = enable;
+}
+
+void ITMProfiler::SetWindowSize(int windowSize)
+{
+	if (windowSize < 1) windowSize = 1;
+
+	ProfilerData & data = GetData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+	data.Reset(windowSize);
+}
+
+void ITMProfiler::Reset(void)
+{
+	ProfilerData & data = GetData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+	data.Reset((int)data.stages[0].samples.size());
+}
+
+void ITMProfiler::Record(Stage stage, double milliseconds)
+{
+	ProfilerData & data = GetData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+	data.stages[stage].Add(milliseconds);
+}
+
+void ITMProfiler::RecordCounter(Counter counter, double value)
+{
+	ProfilerData & data = GetData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+	data.counters[counter].Add(value);
+}
+
+ITMProfiler::Statistics ITMProfiler::GetStatistics(Stage stage)
+{
+	ProfilerData & data = GetData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+	return data.stages[stage].GetStatistics();
+}
+
+ITMProfiler::Statistics ITMProfiler::GetStatistics(Counter counter)
+{
+	ProfilerData & data = GetData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+	return data.counters[counter].GetStatistics();
+}
+
+const char *ITMProfiler::GetName(Stage stage)
+{
+	return stageNames[stage];
+}
+
+const char *ITMProfiler::GetName(Counter counter)
+{
+	return counterNames[counter];
+}
+
+bool ITMProfiler::StartTrace(const char *fileName)
+{
+	StopTrace();
+
+	TraceData & data = GetTraceData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+
+	data.f = fopen(fileName, "w");
+	if (data.f == NULL) return false;
+
+	fprintf(data.f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	data.startTime = GetTime();
+	data.firstEvent = true;
+	data.threadNames.clear();
+
+	tracing = true;
+	return true;
+}
+
+void ITMProfiler::StopTrace(void)
+{
+	TraceData & data = GetTraceData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+
+	if (!tracing) return;
+	tracing = false;
+
+	for (std::map<int, std::string>::const_iterator it = data.threadNames.begin(); it != data.threadNames.end(); ++it)
+	{
+		fprintf(data.f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+			data.firstEvent ? "" : ",\n", it->first, it->second.c_str());
+		data.firstEvent = false;
+	}
+
+	fprintf(data.f, "\n]}\n");
+	fclose(data.f);
+	data.f = NULL;
+}
+
+void ITMProfiler::SetThreadName(const char *name)
+{
+	if (!tracing.load(std::memory_order_relaxed)) return;
+
+	TraceData & data = GetTraceData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+	if (!tracing) return;
+	data.threadNames[GetThreadId()] = name;
+}
+
+void ITMProfiler::TraceEvent(const char *name, const char *category, double start, double duration)
+{
+	int threadId = GetThreadId();
+
+	TraceData & data = GetTraceData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+	if (!tracing) return;
+
+	// timestamps of the trace format are in microseconds
+	fprintf(data.f, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d}",
+		data.firstEvent ? "" : ",\n", name, category, (start - data.startTime) * 1000.0, duration * 1000.0, threadId);
+	data.firstEvent = false;
+}
+
+double ITMProfiler::GetTime(void)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ITMProfiler::PrintStatistics(FILE *f)
+{
+	fprintf(f, "%-16s %8s %10s %10s %10s %10s %10s\n", "stage [ms]", "samples", "mean", "p50", "p95", "p99", "max");
+	for (int i = 0; i < NUM_STAGES; i++)
+	{
+		Statistics stats = GetStatistics((Stage)i);
+		if (stats.noSamples == 0) continue;
+		fprintf(f, "%-16s %8d %10.3f %10.3f %10.3f %10.3f %10.3f\n", GetName((Stage)i), stats.noSamples, stats.mean, stats.p50, stats.p95, stats.p99, stats.max);
+	}
+
+	fprintf(f, "%-16s %8s %10s %10s %10s %10s %10s\n", "counter", "samples", "mean", "p50", "p95", "p99", "max");
+	for (int i = 0; i < NUM_COUNTERS; i++)
+	{
+		Statistics stats = GetStatistics((Counter)i);
+		if (stats.noSamples == 0) continue;
+		fprintf(f, "%-16s %8d %10.1f %10.1f %10.1f %10.1f %10.1f\n", GetName((Counter)i), stats.noSamples, stats.mean, stats.p50, stats.p95, stats.p99, stats.max);
+	}
+}
+
+bool ITMProfiler::SaveStatistics(const char *fileName)
+{
+	FILE *f = fopen(fileName, "w");
+	if (f == NULL) return false;
+
+	fprintf(f, "name,type,samples,mean,p50,p95,p99,max\n");
+	for (int i = 0; i < NUM_STAGES; i++)
+	{
+		Statistics stats = GetStatistics((Stage)i);
+		fprintf(f, "%s,stage_ms,%d,%f,%f,%f,%f,%f\n", GetName((Stage)i), stats.noSamples, stats.mean, stats.p50, stats.p95, stats.p99, stats.max);
+	}
+	for (int i = 0; i < NUM_COUNTERS; i++)
+	{
+		Statistics stats = GetStatistics((Counter)i);
+		fprintf(f, "%s,counter,%d,%f,%f,%f,%f,%f\n", GetName((Counter)i), stats.noSamples, stats.mean, stats.p50, stats.p95, stats.p99, stats.max);
+	}
+
+	return fclose(f) == 0;
+}
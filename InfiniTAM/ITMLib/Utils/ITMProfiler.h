@@ -0,0 +1,160 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stdio.h>
+
+#include <atomic>
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		    Collects per-stage timings and per-frame counters of the
+		    processing pipeline.
+
+		    Every stage and counter keeps a rolling window of its most
+		    recent samples, from which mean and percentiles are
+		    computed on request. Profiling is disabled by default, in
+		    which case a @ref ScopedTimer costs a single test of a
+		    global flag.
+
+		    In addition, all timed stages and any @ref ScopedTraceEvent
+		    can be written to a timeline in the Chrome trace event
+		    format (see @ref StartTrace()), which can be opened in
+		    chrome://tracing or the Perfetto UI.
+
+		    Timings are taken on the host. Kernels on the GPU run
+		    asynchronously, so for CUDA the timings of a stage only
+		    include its device work if the stage synchronises.
+		*/
+		class ITMProfiler
+		{
+		public:
+			/// Timed stages; nested stages are listed after the stage that contains them
+			typedef enum {
+				STAGE_PROCESS_FRAME,
+				STAGE_VIEW,
+				STAGE_TRACK,
+				STAGE_MAPPING,
+				STAGE_ALLOCATION,
+				STAGE_INTEGRATION,
+				STAGE_SWAP_IN,
+				STAGE_SWAP_OUT,
+				STAGE_PREPARE,
+				STAGE_EXPECTED_DEPTHS,
+				STAGE_RAYCAST,
+				STAGE_PIPELINE_WAIT,
+				NUM_STAGES
+			} Stage;
+
+			/// Values recorded once per frame
+			typedef enum {
+				/// Number of visible voxel blocks after allocation
+				COUNTER_VISIBLE_BLOCKS,
+				/// 1 if the raycast for tracking was a full one, 0 if it was forward projected
+				COUNTER_FULL_RAYCAST,
+				/// With swapping, number of blocks found in the depth image while their data was still in the global cache
+				COUNTER_LATE_BLOCKS,
+				/// With swapping, number of blocks requested from the global cache because of the predicted camera motion
+				COUNTER_PREDICTED_BLOCKS,
+				/// With a point budget for the ICP tracker, number of points selected at the finest level
+				COUNTER_ICP_POINTS,
+				/// Number of iterations of the ICP tracker
+				COUNTER_TRACKER_ITERATIONS,
+				/// With a time budget for the ICP tracker, percentage of it used
+				COUNTER_TRACKER_BUDGET_USED,
+				NUM_COUNTERS
+			} Counter;
+
+			struct Statistics
+			{
+				int noSamples;
+				double mean, p50, p95, p99, max;
+			};
+
+			/// Measures the time from construction to destruction and records it for the given stage
+			class ScopedTimer
+			{
+			private:
+				Stage stage;
+				bool record, trace;
+				double start;
+
+			public:
+				explicit ScopedTimer(Stage stage) : stage(stage), record(enabled.load(std::memory_order_relaxed)), trace(tracing.load(std::memory_order_relaxed)), start(0.0)
+				{ if (record || trace) start = GetTime(); }
+
+				~ScopedTimer(void)
+				{
+					if (!(record || trace)) return;
+					double duration = GetTime() - start;
+					if (record) Record(stage, duration);
+					if (trace) TraceEvent(GetName(stage), "stage", start, duration);
+				}
+			};
+
+			/// Adds an event to the trace, if one is being written. @p name and @p category must be string literals.
+			class ScopedTraceEvent
+			{
+			private:
+				const char *name, *category;
+				bool trace;
+				double start;
+
+			public:
+				ScopedTraceEvent(const char *name, const char *category) : name(name), category(category), trace(tracing.load(std::memory_order_relaxed)), start(0.0)
+				{ if (trace) start = GetTime(); }
+
+				~ScopedTraceEvent(void)
+				{ if (trace) TraceEvent(name, category, start, GetTime() - start); }
+			};
+
+			static bool IsEnabled(void) { return enabled.load(std::memory_order_relaxed); }
+			static void SetEnabled(bool enable);
+
+			/// Sets the number of recent samples the statistics are computed from, and clears all samples
+			static void SetWindowSize(int windowSize);
+			static void Reset(void);
+
+			/// Records a duration in milliseconds
+			static void Record(Stage stage, double milliseconds);
+			/// Records a counter value, if profiling is enabled
+			static void Count(Counter counter, double value)
+			{ if (enabled.load(std::memory_order_relaxed)) RecordCounter(counter, value); }
+
+			static Statistics GetStatistics(Stage stage);
+			static Statistics GetStatistics(Counter counter);
+
+			static const char *GetName(Stage stage);
+			static const char *GetName(Counter counter);
+
+			/// Writes the statistics of all stages and counters as a table
+			static void PrintStatistics(FILE *f);
+			/// Writes the statistics of all stages and counters as comma separated values
+			static bool SaveStatistics(const char *fileName);
+
+			/// Starts writing a trace in the Chrome trace event format to @p fileName
+			static bool StartTrace(const char *fileName);
+			/// Completes and closes the trace file
+			static void StopTrace(void);
+			static bool IsTracing(void) { return tracing.load(std::memory_order_relaxed); }
+
+			/// Names the calling thread in the trace
+			static void SetThreadName(const char *name);
+
+			/// Writes a complete event, times are in milliseconds as returned by GetTime()
+			static void TraceEvent(const char *name, const char *category, double start, double duration);
+
+			/// Time in milliseconds since an arbitrary, fixed point
+			static double GetTime(void);
+
+		private:
+			/// written by the controlling thread, read by every thread that records. The samples and the trace file have locks of their own.
+			static std::atomic<bool> enabled;
+			static std::atomic<bool> tracing;
+			static void RecordCounter(Counter counter, double value);
+		};
+	}
+}
@@ -0,0 +1,198 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMThreadAffinity.h"
+
+#ifdef __linux__
+#include <algorithm>
+#include <atomic>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+using namespace ITMLib::Objects;
+
+#ifdef __linux__
+
+namespace {
+
+/// parses a list in the format of /sys, e.g. "0-7,16-23"
+static std::vector<int> ParseList(const char *fileName)
+{
+	std::vector<int> values;
+
+	FILE *f = fopen(fileName, "r");
+	if (f == NULL) return values;
+
+	int first, last;
+	while (fscanf(f, "%d", &first) == 1)
+	{
+		last = first;
+		int c = fgetc(f);
+		if ((c == '-') && (fscanf(f, "%d", &last) == 1)) c = fgetc(f);
+		for (int i = first; i <= last; i++) values.push_back(i);
+		if (c != ',') break;
+	}
+
+	fclose(f);
+	return values;
+}
+
+/// the cores the process was started with, so that pinning can be undone
+static const cpu_set_t & GetProcessCores(void)
+{
+	static cpu_set_t cores;
+	static bool initialised = false;
+	if (!initialised)
+	{
+		CPU_ZERO(&cores);
+		if (sched_getaffinity(0, sizeof(cores), &cores) != 0) CPU_SET(0, &cores);
+		initialised = true;
+	}
+	return cores;
+}
+
+/// set by the pinning thread, read by the threads it starts
+static std::atomic<bool> pinned(false);
+
+/// the cores of part partId of noParts, in the order in which threads are assigned to them
+static std::vector<int> GetCoreOrder(const std::vector<std::vector<int> > & nodes, ITMThreadAffinity::Mode mode, int partId, int noParts)
+{
+	std::vector<std::vector<int> > partNodes;
+	if ((int)nodes.size() >= noParts)
+	{
+		for (size_t n = 0; n < nodes.size(); n++) if ((int)(n % noParts) == partId) partNodes.push_back(nodes[n]);
+	}
+	else for (size_t n = 0; n < nodes.size(); n++)
+	{
+		size_t first = nodes[n].size() * partId / noParts, last = nodes[n].size() * (partId + 1) / noParts;
+		if (first < last) partNodes.push_back(std::vector<int>(nodes[n].begin() + first, nodes[n].begin() + last));
+	}
+	// fewer cores than parts, they have to be shared
+	if (partNodes.empty()) partNodes = nodes;
+
+	std::vector<int> cores;
+	if (mode == ITMThreadAffinity::AFFINITY_COMPACT)
+	{
+		for (size_t n = 0; n < partNodes.size(); n++) cores.insert(cores.end(), partNodes[n].begin(), partNodes[n].end());
+	}
+	else if (mode == ITMThreadAffinity::AFFINITY_SCATTER)
+	{
+		size_t maxCoresPerNode = 0;
+		for (size_t n = 0; n < partNodes.size(); n++) if (partNodes[n].size() > maxCoresPerNode) maxCoresPerNode = partNodes[n].size();
+
+		for (size_t i = 0; i < maxCoresPerNode; i++)
+			for (size_t n = 0; n < partNodes.size(); n++) if (i < partNodes[n].size()) cores.push_back(partNodes[n][i]);
+	}
+	return cores;
+}
+
+}
+
+std::vector<std::vector<int> > ITMThreadAffinity::GetCoresPerNUMANode(void)
+{
+	const cpu_set_t & allowed = GetProcessCores();
+	std::vector<std::vector<int> > nodes;
+
+	std::vector<int> nodeIds = ParseList("/sys/devices/system/node/online");
+	for (size_t n = 0; n < nodeIds.size(); n++)
+	{
+		char fileName[128];
+		sprintf(fileName, "/sys/devices/system/node/node%d/cpulist", nodeIds[n]);
+		std::vector<int> cores = ParseList(fileName);
+
+		std::vector<int> allowedCores;
+		for (size_t i = 0; i < cores.size(); i++) if ((cores[i] < CPU_SETSIZE) && CPU_ISSET(cores[i], &allowed)) allowedCores.push_back(cores[i]);
+		if (!allowedCores.empty()) nodes.push_back(allowedCores);
+	}
+
+	// no NUMA information, treat the machine as a single node
+	if (nodes.empty())
+	{
+		nodes.resize(1);
+		for (int i = 0; i < CPU_SETSIZE; i++) if (CPU_ISSET(i, &allowed)) nodes[0].push_back(i);
+	}
+
+	return nodes;
+}
+
+int ITMThreadAffinity::GetNumberOfNUMANodes(void)
+{
+	return (int)GetCoresPerNUMANode().size();
+}
+
+bool ITMThreadAffinity::Apply(Mode mode, int partId, int noParts)
+{
+	const cpu_set_t & processCores = GetProcessCores();
+	if ((mode == AFFINITY_NONE) && !pinned) return true;
+
+	std::vector<int> cores = GetCoreOrder(GetCoresPerNUMANode(), mode, partId, noParts);
+	if ((mode != AFFINITY_NONE) && cores.empty()) return false;
+
+#ifdef WITH_OPENMP
+	// a second thread per core would compete with the team of another part
+	if ((mode != AFFINITY_NONE) && (noParts > 1) && (omp_get_max_threads() > (int)cores.size())) omp_set_num_threads((int)cores.size());
+#endif
+
+	bool success = true;
+#ifdef WITH_OPENMP
+#pragma omp parallel reduction(&&:success)
+#endif
+	{
+		int threadId = 0;
+#ifdef WITH_OPENMP
+		threadId = omp_get_thread_num();
+#endif
+		cpu_set_t threadCores;
+		if (mode == AFFINITY_NONE) threadCores = processCores;
+		else
+		{
+			CPU_ZERO(&threadCores);
+			CPU_SET(cores[threadId % cores.size()], &threadCores);
+		}
+		success = success && (sched_setaffinity(0, sizeof(threadCores), &threadCores) == 0);
+	}
+
+	pinned = (mode != AFFINITY_NONE);
+	return success;
+}
+
+std::vector<int> ITMThreadAffinity::GetThreadsPerNUMANode(Mode mode, int noThreads, int partId, int noParts)
+{
+	if (mode == AFFINITY_NONE) return std::vector<int>();
+
+	std::vector<std::vector<int> > nodes = GetCoresPerNUMANode();
+	std::vector<int> cores = GetCoreOrder(nodes, mode, partId, noParts);
+	if ((noParts > 1) && (noThreads > (int)cores.size())) noThreads = (int)cores.size();
+
+	std::vector<int> noThreadsPerNode(nodes.size(), 0);
+	for (int threadId = 0; threadId < noThreads; threadId++)
+	{
+		int core = cores[threadId % cores.size()];
+		for (size_t n = 0; n < nodes.size(); n++)
+			if (std::find(nodes[n].begin(), nodes[n].end(), core) != nodes[n].end()) noThreadsPerNode[n]++;
+	}
+	return noThreadsPerNode;
+}
+
+bool ITMThreadAffinity::ReleaseCallingThread(void)
+{
+	if (!pinned) return true;
+
+	const cpu_set_t & processCores = GetProcessCores();
+	return sched_setaffinity(0, sizeof(processCores), &processCores) == 0;
+}
+
+#else
+
+std::vector<std::vector<int> > ITMThreadAffinity::GetCoresPerNUMANode(void) { return std::vector<std::vector<int> >(); }
+int ITMThreadAffinity::GetNumberOfNUMANodes(void) { return 1; }
+bool ITMThreadAffinity::Apply(Mode mode, int partId, int noParts) { return mode == AFFINITY_NONE; }
+std::vector<int> ITMThreadAffinity::GetThreadsPerNUMANode(Mode mode, int noThreads, int partId, int noParts) { return std::vector<int>(); }
+bool ITMThreadAffinity::ReleaseCallingThread(void) { return true; }
+
+#endif
@@ -0,0 +1,71 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <vector>
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		    Pins the OpenMP worker threads of the CPU engines to
+		    cores, taking the NUMA nodes of the machine into account.
+
+		    With @ref AFFINITY_COMPACT, thread i runs on the i-th
+		    allowed core, filling one NUMA node before the next, so
+		    small thread counts share caches and memory controller.
+		    With @ref AFFINITY_SCATTER, threads are dealt round robin
+		    to the nodes, which uses the memory bandwidth of all
+		    sockets even with few threads.
+
+		    Threads that run at the same time, such as tracking and
+		    the mapping thread of pipelined processing, pin their
+		    teams to disjoint parts of the cores: each part gets
+		    whole NUMA nodes if there are at least as many nodes as
+		    parts, and an equal share of the cores of every node
+		    otherwise. A team pinned to a part has at most one
+		    thread per core of it.
+
+		    Pinning affects the team of threads of the calling
+		    thread, which OpenMP keeps alive between parallel
+		    regions of the same size, and thus the calling thread
+		    itself. Threads started afterwards inherit its single
+		    core, so background threads call
+		    @ref ReleaseCallingThread() when they start, and threads
+		    with an OpenMP team of their own, such as the mapping
+		    thread of pipelined processing, call @ref Apply() for
+		    it. Only supported on Linux; elsewhere all calls do
+		    nothing.
+		    OMP_PROC_BIND and OMP_PLACES remain an alternative that
+		    needs no code.
+		*/
+		class ITMThreadAffinity
+		{
+		public:
+			typedef enum {
+				/// Leave placement to the operating system
+				AFFINITY_NONE,
+				/// Consecutive threads on consecutive cores, one NUMA node after the other
+				AFFINITY_COMPACT,
+				/// Consecutive threads on different NUMA nodes
+				AFFINITY_SCATTER
+			} Mode;
+
+			/// Pins the OpenMP threads of the calling thread to part @p partId of @p noParts disjoint parts of the cores, or releases them again with AFFINITY_NONE. Returns false if pinning is not supported.
+			static bool Apply(Mode mode, int partId = 0, int noParts = 1);
+
+			/// Number of threads per NUMA node, in the order of GetCoresPerNUMANode(), that a team of @p noThreads has after Apply() with the same arguments. Empty for AFFINITY_NONE.
+			static std::vector<int> GetThreadsPerNUMANode(Mode mode, int noThreads, int partId = 0, int noParts = 1);
+
+			/// Lets the calling thread run on all cores of the process again if threads have been pinned, for threads started by a pinned thread
+			static bool ReleaseCallingThread(void);
+
+			/// Number of NUMA nodes with cores this process may run on, 1 if unknown
+			static int GetNumberOfNUMANodes(void);
+
+			/// Cores this process may run on, grouped by NUMA node
+			static std::vector<std::vector<int> > GetCoresPerNUMANode(void);
+		};
+	}
+}
@@ -0,0 +1,92 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMWorkerThread.h"
+#include "ITMThreadAffinity.h"
+
+#include <stddef.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace ITMLib::Objects;
+
+struct ITMWorkerThread::State
+{
+	std::mutex mutex;
+	std::condition_variable jobPosted, jobDone;
+
+	Job *job;
+	bool busy, shutdown;
+
+	std::thread thread;
+};
+
+void ITMWorkerThread::ThreadMain(State *state)
+{
+	// not confined to the core of a pinned creator
+	ITMThreadAffinity::ReleaseCallingThread();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+
+	while (true)
+	{
+		while (state->job == NULL && !state->shutdown) state->jobPosted.wait(lock);
+		if (state->job == NULL) break;
+
+		Job *job = state->job;
+		lock.unlock();
+		job->Execute();
+		lock.lock();
+
+		state->job = NULL;
+		state->busy = false;
+		state->jobDone.notify_all();
+	}
+}
+
+ITMWorkerThread::ITMWorkerThread(void)
+{
+	state = new State();
+	state->job = NULL;
+	state->busy = false;
+	state->shutdown = false;
+
+	state->thread = std::thread(ThreadMain, state);
+}
+
+ITMWorkerThread::~ITMWorkerThread(void)
+{
+	Wait();
+
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		state->shutdown = true;
+	}
+	state->jobPosted.notify_all();
+	state->thread.join();
+
+	delete state;
+}
+
+void ITMWorkerThread::Run(Job *job)
+{
+	std::unique_lock<std::mutex> lock(state->mutex);
+	while (state->busy) state->jobDone.wait(lock);
+
+	state->job = job;
+	state->busy = true;
+	state->jobPosted.notify_one();
+}
+
+void ITMWorkerThread::Wait(void)
+{
+	std::unique_lock<std::mutex> lock(state->mutex);
+	while (state->busy) state->jobDone.wait(lock);
+}
+
+bool ITMWorkerThread::IsBusy(void) const
+{
+	std::lock_guard<std::mutex> lock(state->mutex);
+	return state->busy;
+}
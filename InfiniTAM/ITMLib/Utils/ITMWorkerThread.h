@@ -0,0 +1,55 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		    A single background thread that executes one job at a
+		    time.
+
+		    The caller hands over a job with @ref Run() and later
+		    calls @ref Wait() before touching any data the job works
+		    on. Running a new job implicitly waits for the previous
+		    one, so at most one job is ever in flight. The thread
+		    runs on all cores of the process, also if its creator
+		    has been pinned by ITMThreadAffinity.
+		*/
+		class ITMWorkerThread
+		{
+		public:
+			/// Work item executed on the background thread
+			class Job
+			{
+			public:
+				virtual void Execute(void) = 0;
+				virtual ~Job(void) {}
+			};
+
+		private:
+			struct State;
+			State *state;
+
+			static void ThreadMain(State *state);
+
+		public:
+			/// Waits for the previous job, then starts @p job in the background. The job is not owned.
+			void Run(Job *job);
+
+			/// Blocks until the job handed over last (if any) has finished
+			void Wait(void);
+
+			/// Returns true while a job is executing or queued
+			bool IsBusy(void) const;
+
+			ITMWorkerThread(void);
+			~ITMWorkerThread(void);
+
+			// Suppress the default copy constructor and assignment operator
+			ITMWorkerThread(const ITMWorkerThread&);
+			ITMWorkerThread& operator=(const ITMWorkerThread&);
+		};
+	}
+}
@@ -1,9 +1,13 @@
 // Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
 
 #include <cstdlib>
+#include <string.h>
 
 #include "Engine/UIEngine.h"
 #include "Engine/ImageSourceEngine.h"
+#include "Engine/PrefetchingImageSource.h"
+#include "Engine/SequenceFile.h"
+#include "Engine/SyntheticSceneSource.h"
 
 #include "Engine/OpenNIEngine.h"
 #include "Engine/Kinect2Engine.h"
@@ -25,6 +29,27 @@ static void CreateDefaultImageSource(ImageSourceEngine* & imageSource, IMUSource
 	const char *filename2 = arg3;
 	const char *filename_imu = arg4;
 
+	if ((filename1 == NULL) && SequenceFileReader::isSequenceFile(calibFile))
+	{
+		printf("using sequence file: %s\n", calibFile);
+		imageSource = new SequenceFileReader(calibFile);
+		return;
+	}
+
+	if ((filename1 == NULL) && (strcmp(calibFile, "synthetic") == 0))
+	{
+		printf("using built-in synthetic scene\n");
+		imageSource = new SyntheticSceneSource(SyntheticSceneSource::Settings());
+		return;
+	}
+
+	if ((filename1 == NULL) && SyntheticSceneSource::isSceneFile(calibFile))
+	{
+		printf("using synthetic scene: %s\n", calibFile);
+		imageSource = new SyntheticSceneSource(calibFile);
+		return;
+	}
+
 	printf("using calibration file: %s\n", calibFile);
 
 	if (filename2 != NULL)
@@ -113,13 +138,16 @@ try
 
 	if (arg == 1) {
 		printf("usage: %s [<calibfile> [<imagesource>] ]\n"
-		       "  <calibfile>   : path to a file containing intrinsic calibration parameters\n"
+		       "  <calibfile>   : path to a file containing intrinsic calibration parameters,\n"
+		       "                  a sequence file written by InfiniTAM_convert, a synthetic\n"
+		       "                  scene file or \"synthetic\" for the built-in synthetic scene\n"
 		       "  <imagesource> : either one argument to specify OpenNI device ID\n"
 		       "                  or two arguments specifying rgb and depth file masks\n"
 		       "\n"
 		       "examples:\n"
 		       "  %s ./Files/Teddy/calib.txt ./Files/Teddy/Frames/%%04i.ppm ./Files/Teddy/Frames/%%04i.pgm\n"
-		       "  %s ./Files/Teddy/calib.txt\n\n", argv[0], argv[0], argv[0]);
+		       "  %s ./Files/Teddy/calib.txt\n"
+		       "  %s ./Files/Synthetic/room.scene\n\n", argv[0], argv[0], argv[0], argv[0]);
 	}
 
 	printf("initialising ...\n");
@@ -133,15 +161,26 @@ try
 		return -1;
 	}
 
+	// read files (or render synthetic frames) ahead on a background thread, so that this overlaps with processing
+	PrefetchingImageSource *prefetcher = NULL;
+	if ((arg3 != NULL) || (dynamic_cast<SyntheticSceneSource*>(imageSource) != NULL)) prefetcher = new PrefetchingImageSource(imageSource, imuSource);
+
+	ImageSourceEngine *frameSource = (prefetcher != NULL) ? prefetcher : imageSource;
+	IMUSourceEngine *frameIMUSource = (prefetcher != NULL) ? prefetcher->getIMUSource() : imuSource;
+
+	SequenceFileReader *sequence = dynamic_cast<SequenceFileReader*>(imageSource);
+	if (sequence != NULL) frameIMUSource = sequence->getIMUSource();
+
 	ITMLibSettings *internalSettings = new ITMLibSettings();
-	ITMMainEngine *mainEngine = new ITMMainEngine(internalSettings, &imageSource->calib, imageSource->getRGBImageSize(), imageSource->getDepthImageSize());
+	ITMMainEngine *mainEngine = new ITMMainEngine(internalSettings, &frameSource->calib, frameSource->getRGBImageSize(), frameSource->getDepthImageSize());
 
-	UIEngine::Instance()->Initialise(argc, argv, imageSource, imuSource, mainEngine, "./Files/Out", internalSettings->deviceType);
+	UIEngine::Instance()->Initialise(argc, argv, frameSource, frameIMUSource, mainEngine, "./Files/Out", internalSettings->deviceType);
 	UIEngine::Instance()->Run();
 	UIEngine::Instance()->Shutdown();
 
 	delete mainEngine;
 	delete internalSettings;
+	if (prefetcher != NULL) delete prefetcher;
 	delete imageSource;
 	if (imuSource != NULL) delete imuSource;
 	return 0;
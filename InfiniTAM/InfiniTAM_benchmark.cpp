@@ -0,0 +1,703 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <cstdlib>
+#include <math.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#endif
+
+#include "Engine/ImageSourceEngine.h"
+#include "Engine/IMUSourceEngine.h"
+#include "Engine/SequenceFile.h"
+#include "Engine/SyntheticSceneSource.h"
+
+#include "ITMLib/Utils/ITMProfiler.h"
+
+using namespace InfiniTAM::Engine;
+
+static const char *trackerNames[] = { "color", "icp", "ren", "imu", "wicp" };
+static const int NUM_TRACKERS = sizeof(trackerNames) / sizeof(trackerNames[0]);
+
+static const char *affinityNames[] = { "none", "compact", "scatter" };
+static const int NUM_AFFINITIES = sizeof(affinityNames) / sizeof(affinityNames[0]);
+
+/// one input sequence of the benchmark, with optional ground truth
+struct Sequence
+{
+	typedef enum { SEQUENCE_SYNTHETIC, SEQUENCE_SCENE_FILE, SEQUENCE_FILE, SEQUENCE_IMAGES } Type;
+
+	Type type;
+	std::string name;
+	std::string fileName, rgbMask, depthMask;
+	/// camera to world transformations relative to the first frame, empty without ground truth
+	std::vector<Matrix4f> groundTruth;
+};
+
+/// one point of the settings matrix
+struct Configuration
+{
+	ITMLibSettings::TrackerType tracker;
+	float voxelSize;
+	bool useSwapping, useAsynchronousSwapping, useApproximateRaycast, usePipelinedProcessing, useHugePages, useNUMAInterleave;
+	ITMThreadAffinity::Mode threadAffinity;
+	int noThreads;
+	int swappingHostBlockBudget;
+	int swappingPrefetchFrames;
+	int depthTrackerPointBudget;
+	float depthTrackerTimeBudget;
+};
+
+struct Result
+{
+	int noFrames, noTimedFrames;
+	double seconds;
+	ITMProfiler::Statistics stages[ITMProfiler::NUM_STAGES];
+	ITMProfiler::Statistics counters[ITMProfiler::NUM_COUNTERS];
+	double peakHostMemory;
+	/// state of the global cache at the end of the run, only filled in with swapping
+	int cacheStoredBlocks, cacheHostBlocks, cacheDiskBlocks;
+	double cacheEncodedMemory;
+	bool hasGroundTruth;
+	double ateRMSE, ateMax;
+};
+
+// ---------------------------------------------------------------------------
+// peak memory
+
+/// Starts a new peak of the resident set size; returns false if the platform does not support this
+static bool resetPeakMemory(void)
+{
+#if defined(__linux__)
+	// writing 5 to clear_refs resets the peak resident set size (since Linux 4.0)
+	FILE *f = fopen("/proc/self/clear_refs", "w");
+	if (f == NULL) return false;
+	bool success = fputs("5", f) >= 0;
+	return (fclose(f) == 0) && success;
+#else
+	return false;
+#endif
+}
+
+/// Returns the memory freed by a run to the system, so that it does not count towards the peak of the next one
+static void releaseFreedMemory(void)
+{
+	// idle buffers of the memory pool, and free heap memory glibc keeps
+	ORUtils::MemoryPool::Trim();
+#ifdef __GLIBC__
+	malloc_trim(0);
+#endif
+}
+
+/// Peak resident set size in MB, since the last successful resetPeakMemory() or since the start of the process
+static double getPeakMemory(void)
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0.0;
+	return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+#if defined(__linux__)
+	FILE *f = fopen("/proc/self/status", "r");
+	if (f != NULL)
+	{
+		char line[256];
+		long kb = -1;
+		while (fgets(line, sizeof(line), f) != NULL)
+			if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) break;
+		fclose(f);
+		if (kb >= 0) return kb / 1024.0;
+	}
+#endif
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+#ifdef __APPLE__
+	return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+	return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// ground truth
+
+static Matrix4f rigidInverse(const Matrix4f & M)
+{
+	Matrix4f invM;
+	invM.setIdentity();
+	for (int r = 0; r < 3; r++) for (int c = 0; c < 3; c++) invM.m[c * 4 + r] = M.m[r * 4 + c];
+	for (int r = 0; r < 3; r++) invM.m[12 + r] = -(invM.m[r] * M.m[12] + invM.m[4 + r] * M.m[13] + invM.m[8 + r] * M.m[14]);
+	return invM;
+}
+
+/// Reads one pose per frame in the format of the TUM RGB-D benchmark and makes them relative to the first frame
+static bool readGroundTruth(const char *fileName, std::vector<Matrix4f> & poses)
+{
+	std::ifstream f(fileName);
+	if (!f.is_open()) { printf("error reading file '%s'\n", fileName); return false; }
+
+	poses.clear();
+	std::string line;
+	while (std::getline(f, line))
+	{
+		if (line.empty() || (line[0] == '#')) continue;
+
+		std::istringstream src(line);
+		double timestamp;
+		float tx, ty, tz, qx, qy, qz, qw;
+		if (!(src >> timestamp >> tx >> ty >> tz >> qx >> qy >> qz >> qw))
+		{
+			printf("error in '%s': invalid pose '%s'\n", fileName, line.c_str());
+			return false;
+		}
+
+		float n = sqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+		qx /= n; qy /= n; qz /= n; qw /= n;
+
+		Matrix4f pose;
+		pose.setIdentity();
+		pose.m00 = 1 - 2 * (qy * qy + qz * qz); pose.m10 = 2 * (qx * qy - qz * qw); pose.m20 = 2 * (qx * qz + qy * qw);
+		pose.m01 = 2 * (qx * qy + qz * qw); pose.m11 = 1 - 2 * (qx * qx + qz * qz); pose.m21 = 2 * (qy * qz - qx * qw);
+		pose.m02 = 2 * (qx * qz - qy * qw); pose.m12 = 2 * (qy * qz + qx * qw); pose.m22 = 1 - 2 * (qx * qx + qy * qy);
+		pose.m30 = tx; pose.m31 = ty; pose.m32 = tz;
+		poses.push_back(pose);
+	}
+
+	if (poses.empty()) { printf("error: no poses in '%s'\n", fileName); return false; }
+
+	Matrix4f invFirst = rigidInverse(poses[0]);
+	for (size_t i = 0; i < poses.size(); i++) poses[i] = invFirst * poses[i];
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+// command line
+
+static std::vector<std::string> split(const char *str)
+{
+	std::vector<std::string> parts;
+	std::istringstream src(str);
+	std::string part;
+	while (std::getline(src, part, ',')) parts.push_back(part);
+	return parts;
+}
+
+static bool parseSequence(const char *arg, Sequence & sequence)
+{
+	std::vector<std::string> parts = split(arg);
+	if (parts.empty()) return false;
+
+	sequence.name = parts[0];
+	sequence.fileName = parts[0];
+	const char *groundTruthFile = NULL;
+
+	if ((parts.size() == 1) && (parts[0] == "synthetic")) sequence.type = Sequence::SEQUENCE_SYNTHETIC;
+	else if ((parts.size() == 1) && SyntheticSceneSource::isSceneFile(parts[0].c_str())) sequence.type = Sequence::SEQUENCE_SCENE_FILE;
+	else if ((parts.size() <= 2) && SequenceFileReader::isSequenceFile(parts[0].c_str()))
+	{
+		sequence.type = Sequence::SEQUENCE_FILE;
+		if (parts.size() == 2) groundTruthFile = parts[1].c_str();
+	}
+	else if ((parts.size() == 3) || (parts.size() == 4))
+	{
+		sequence.type = Sequence::SEQUENCE_IMAGES;
+		sequence.name = parts[1];
+		sequence.rgbMask = parts[1];
+		sequence.depthMask = parts[2];
+		if (parts.size() == 4) groundTruthFile = parts[3].c_str();
+	}
+	else
+	{
+		printf("error: cannot use '%s' as a sequence\n", arg);
+		return false;
+	}
+
+	if ((groundTruthFile != NULL) && !readGroundTruth(groundTruthFile, sequence.groundTruth)) return false;
+	return true;
+}
+
+static bool parseTrackers(const char *arg, std::vector<ITMLibSettings::TrackerType> & trackers)
+{
+	std::vector<std::string> parts = split(arg);
+	trackers.clear();
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		int type = 0;
+		while ((type < NUM_TRACKERS) && (parts[i] != trackerNames[type])) type++;
+		if (type == NUM_TRACKERS) { printf("error: unknown tracker '%s'\n", parts[i].c_str()); return false; }
+		trackers.push_back((ITMLibSettings::TrackerType)type);
+	}
+	return !trackers.empty();
+}
+
+static bool parseAffinities(const char *arg, std::vector<ITMThreadAffinity::Mode> & affinities)
+{
+	std::vector<std::string> parts = split(arg);
+	affinities.clear();
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		int mode = 0;
+		while ((mode < NUM_AFFINITIES) && (parts[i] != affinityNames[mode])) mode++;
+		if (mode == NUM_AFFINITIES) { printf("error: unknown affinity '%s'\n", parts[i].c_str()); return false; }
+		affinities.push_back((ITMThreadAffinity::Mode)mode);
+	}
+	return !affinities.empty();
+}
+
+static bool parseFloats(const char *arg, std::vector<float> & values, bool allowZero)
+{
+	std::vector<std::string> parts = split(arg);
+	values.clear();
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		char *end;
+		float value = (float)strtod(parts[i].c_str(), &end);
+		if ((*end != 0) || (value < 0.0f) || ((value == 0.0f) && !allowZero)) { printf("error: invalid value '%s'\n", parts[i].c_str()); return false; }
+		values.push_back(value);
+	}
+	return !values.empty();
+}
+
+static bool parseInts(const char *arg, std::vector<int> & values, int minValue, int maxValue)
+{
+	std::vector<std::string> parts = split(arg);
+	values.clear();
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		char *end;
+		long value = strtol(parts[i].c_str(), &end, 10);
+		if ((*end != 0) || (value < minValue) || (value > maxValue)) { printf("error: invalid value '%s'\n", parts[i].c_str()); return false; }
+		values.push_back((int)value);
+	}
+	return !values.empty();
+}
+
+// ---------------------------------------------------------------------------
+// running
+
+static bool hasIMU(const Sequence & sequence)
+{
+	if (sequence.type != Sequence::SEQUENCE_FILE) return false;
+
+	SequenceFileReader reader(sequence.fileName.c_str());
+	return reader.getIMUSource() != NULL;
+}
+
+static ImageSourceEngine *createImageSource(const Sequence & sequence)
+{
+	switch (sequence.type)
+	{
+	case Sequence::SEQUENCE_SYNTHETIC: return new SyntheticSceneSource(SyntheticSceneSource::Settings());
+	case Sequence::SEQUENCE_SCENE_FILE: return new SyntheticSceneSource(sequence.fileName.c_str());
+	case Sequence::SEQUENCE_FILE: return new SequenceFileReader(sequence.fileName.c_str());
+	case Sequence::SEQUENCE_IMAGES: return new ImageFileReader(sequence.fileName.c_str(), sequence.rgbMask.c_str(), sequence.depthMask.c_str());
+	}
+	return NULL;
+}
+
+static bool runBenchmark(const Sequence & sequence, const Configuration & configuration, int maxFrames, int noWarmupFrames, Result & result)
+{
+	ImageSourceEngine *imageSource = createImageSource(sequence);
+
+	SyntheticSceneSource *syntheticSource = dynamic_cast<SyntheticSceneSource*>(imageSource);
+	SequenceFileReader *sequenceReader = dynamic_cast<SequenceFileReader*>(imageSource);
+	IMUSourceEngine *imuSource = (sequenceReader != NULL) ? sequenceReader->getIMUSource() : NULL;
+
+#ifdef WITH_OPENMP
+	if (configuration.noThreads > 0) omp_set_num_threads(configuration.noThreads);
+#endif
+
+	ITMLibSettings *settings = new ITMLibSettings();
+	settings->SetTrackerType(configuration.tracker);
+	// keep the truncation band at the same number of voxels
+	settings->sceneParams.mu *= configuration.voxelSize / settings->sceneParams.voxelSize;
+	settings->sceneParams.voxelSize = configuration.voxelSize;
+	settings->useSwapping = configuration.useSwapping;
+	settings->useAsynchronousSwapping = configuration.useAsynchronousSwapping;
+	settings->swappingPrefetchFrames = configuration.swappingPrefetchFrames;
+	settings->swappingHostBlockBudget = configuration.swappingHostBlockBudget;
+	settings->depthTrackerPointBudget = configuration.depthTrackerPointBudget;
+	settings->depthTrackerTimeBudget = configuration.depthTrackerTimeBudget;
+	settings->useApproximateRaycast = configuration.useApproximateRaycast;
+	settings->usePipelinedProcessing = configuration.usePipelinedProcessing;
+	settings->useHugePages = configuration.useHugePages;
+	settings->useNUMAInterleave = configuration.useNUMAInterleave;
+	settings->threadAffinity = configuration.threadAffinity;
+	settings->useProfiling = true;
+
+	Vector2i imgSize_rgb = imageSource->getRGBImageSize(), imgSize_d = imageSource->getDepthImageSize();
+	ITMUChar4Image *rgb = new ITMUChar4Image(imgSize_rgb, true, false);
+	ITMShortImage *rawDepth = new ITMShortImage(imgSize_d, true, false);
+	ITMIMUMeasurement *imu = new ITMIMUMeasurement();
+
+	ITMProfiler::Reset();
+	resetPeakMemory();
+
+	ITMMainEngine *mainEngine = new ITMMainEngine(settings, &imageSource->calib, imgSize_rgb, imgSize_d);
+
+	result.noFrames = 0;
+	result.noTimedFrames = 0;
+	result.seconds = 0.0;
+	result.hasGroundTruth = (syntheticSource != NULL) || !sequence.groundTruth.empty();
+	double sumSquaredError = 0.0;
+	int noComparedFrames = 0;
+	result.ateMax = 0.0;
+
+	while (((maxFrames <= 0) || (result.noFrames < maxFrames)) && imageSource->hasMoreImages())
+	{
+		imageSource->getImages(rgb, rawDepth);
+
+		ITMIMUMeasurement *frameIMU = NULL;
+		if (imuSource != NULL)
+		{
+			if (!imuSource->hasMoreMeasurements()) break;
+			imuSource->getMeasurement(imu);
+			frameIMU = imu;
+		}
+
+		// the warm-up frames are processed normally, but excluded from the timings
+		if (result.noFrames == noWarmupFrames)
+		{
+			mainEngine->FlushPipeline();
+			ITMProfiler::Reset();
+		}
+
+		double start = ITMProfiler::GetTime();
+		mainEngine->ProcessFrame(rgb, rawDepth, frameIMU);
+		if (result.noFrames >= noWarmupFrames)
+		{
+			result.seconds += (ITMProfiler::GetTime() - start) / 1000.0;
+			result.noTimedFrames++;
+		}
+
+		// trajectory error, in the coordinate system of the first frame
+		bool hasFrameGroundTruth = (syntheticSource != NULL) || (result.noFrames < (int)sequence.groundTruth.size());
+		if (hasFrameGroundTruth)
+		{
+			Matrix4f groundTruth = (syntheticSource != NULL) ? rigidInverse(syntheticSource->getGroundTruthPose(result.noFrames)) : sequence.groundTruth[result.noFrames];
+			Matrix4f estimate = mainEngine->GetTrackingState()->pose_d->GetInvM();
+			Vector3f diff(estimate.m30 - groundTruth.m30, estimate.m31 - groundTruth.m31, estimate.m32 - groundTruth.m32);
+			double error = length(diff);
+			sumSquaredError += error * error;
+			if (error > result.ateMax) result.ateMax = error;
+			noComparedFrames++;
+		}
+
+		result.noFrames++;
+	}
+
+	// the last frame is only complete once fusion and raycasting have finished
+	double start = ITMProfiler::GetTime();
+	mainEngine->FlushPipeline();
+	result.seconds += (ITMProfiler::GetTime() - start) / 1000.0;
+
+	for (int i = 0; i < ITMProfiler::NUM_STAGES; i++) result.stages[i] = ITMProfiler::GetStatistics((ITMProfiler::Stage)i);
+	for (int i = 0; i < ITMProfiler::NUM_COUNTERS; i++) result.counters[i] = ITMProfiler::GetStatistics((ITMProfiler::Counter)i);
+	result.peakHostMemory = getPeakMemory();
+	if (configuration.useSwapping)
+	{
+		const ITMGlobalCache<ITMVoxel> *globalCache = mainEngine->GetScene()->globalCache;
+		result.cacheStoredBlocks = globalCache->GetNoStoredBlocks();
+		result.cacheHostBlocks = globalCache->GetNoHostBlocks();
+		result.cacheDiskBlocks = globalCache->GetNoDiskBlocks();
+		result.cacheEncodedMemory = globalCache->GetNoEncodedBytes() / (1024.0 * 1024.0);
+	}
+	result.ateRMSE = (noComparedFrames > 0) ? sqrt(sumSquaredError / noComparedFrames) : 0.0;
+	result.hasGroundTruth = result.hasGroundTruth && (noComparedFrames > 0);
+
+	delete mainEngine;
+	delete imu;
+	delete rawDepth;
+	delete rgb;
+	delete settings;
+	delete imageSource;
+
+	releaseFreedMemory();
+
+	return result.noFrames > 0;
+}
+
+// ---------------------------------------------------------------------------
+// reporting
+
+/// number of threads a run has actually used
+static int getNumberOfThreads(const Configuration & configuration)
+{
+#ifdef WITH_OPENMP
+	return (configuration.noThreads > 0) ? configuration.noThreads : omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+/// threads per NUMA node of the OpenMP team of tracking (part 0) or of the mapping thread (part 1) as "n0/n1/...", empty if the team is not pinned or there is no mapping thread
+static std::string getThreadsPerNUMANode(const Configuration & configuration, int partId)
+{
+	// with pipelined processing, ITMMainEngine gives tracking and the mapping thread one of two parts of the cores each
+	bool isPipelined = configuration.usePipelinedProcessing && (configuration.tracker != ITMLibSettings::TRACKER_REN);
+	if (!isPipelined && (partId != 0)) return "";
+
+	std::vector<int> noThreadsPerNode = isPipelined ?
+		ITMThreadAffinity::GetThreadsPerNUMANode(configuration.threadAffinity, getNumberOfThreads(configuration), partId, 2) :
+		ITMThreadAffinity::GetThreadsPerNUMANode(configuration.threadAffinity, getNumberOfThreads(configuration));
+
+	std::ostringstream str;
+	for (size_t n = 0; n < noThreadsPerNode.size(); n++) str << (n > 0 ? "/" : "") << noThreadsPerNode[n];
+	return str.str();
+}
+
+static void writeCSVHeader(FILE *f)
+{
+	fprintf(f, "sequence,tracker,voxel_size,icp_point_budget,tracker_budget_ms,swapping,async_swapping,prefetch_frames,approx_raycast,pipelined,huge_pages,numa_interleave,affinity,threads,threads_per_node,mapping_threads_per_node,frames,timed_frames,seconds,fps,peak_host_mb,cache_stored_blocks,cache_host_blocks,cache_disk_blocks,cache_encoded_mb,ate_rmse,ate_max");
+	for (int i = 0; i < ITMProfiler::NUM_STAGES; i++)
+	{
+		const char *name = ITMProfiler::GetName((ITMProfiler::Stage)i);
+		fprintf(f, ",%s_samples,%s_mean,%s_p50,%s_p95,%s_p99,%s_max", name, name, name, name, name, name);
+	}
+	for (int i = 0; i < ITMProfiler::NUM_COUNTERS; i++)
+	{
+		const char *name = ITMProfiler::GetName((ITMProfiler::Counter)i);
+		fprintf(f, ",%s_samples,%s_mean,%s_max", name, name, name);
+	}
+	fprintf(f, "\n");
+}
+
+static void writeCSVRow(FILE *f, const Sequence & sequence, const Configuration & configuration, const Result & result)
+{
+	double fps = (result.seconds > 0.0) ? result.noTimedFrames / result.seconds : 0.0;
+
+	fprintf(f, "\"%s\",%s,%g,%d,%g,%d,%d,%d,%d,%d,%d,%d,%s,%d,%s,%s,%d,%d,%f,%f,%f,", sequence.name.c_str(), trackerNames[configuration.tracker], configuration.voxelSize,
+		configuration.depthTrackerPointBudget, configuration.depthTrackerTimeBudget, configuration.useSwapping, configuration.useAsynchronousSwapping, configuration.swappingPrefetchFrames, configuration.useApproximateRaycast,
+		configuration.usePipelinedProcessing, configuration.useHugePages, configuration.useNUMAInterleave, affinityNames[configuration.threadAffinity],
+		getNumberOfThreads(configuration), getThreadsPerNUMANode(configuration, 0).c_str(), getThreadsPerNUMANode(configuration, 1).c_str(), result.noFrames, result.noTimedFrames, result.seconds, fps, result.peakHostMemory);
+	// cache statistics are left empty without swapping
+	if (configuration.useSwapping) fprintf(f, "%d,%d,%d,%f,", result.cacheStoredBlocks, result.cacheHostBlocks, result.cacheDiskBlocks, result.cacheEncodedMemory);
+	else fprintf(f, ",,,,");
+	// trajectory errors are left empty without ground truth
+	if (result.hasGroundTruth) fprintf(f, "%f,%f", result.ateRMSE, result.ateMax);
+	else fprintf(f, ",");
+
+	for (int i = 0; i < ITMProfiler::NUM_STAGES; i++)
+	{
+		const ITMProfiler::Statistics & stats = result.stages[i];
+		fprintf(f, ",%d,%f,%f,%f,%f,%f", stats.noSamples, stats.mean, stats.p50, stats.p95, stats.p99, stats.max);
+	}
+	for (int i = 0; i < ITMProfiler::NUM_COUNTERS; i++)
+	{
+		const ITMProfiler::Statistics & stats = result.counters[i];
+		fprintf(f, ",%d,%f,%f", stats.noSamples, stats.mean, stats.max);
+	}
+	fprintf(f, "\n");
+	fflush(f);
+}
+
+static void printSummary(const Configuration & configuration, const Result & result)
+{
+	double fps = (result.seconds > 0.0) ? result.noTimedFrames / result.seconds : 0.0;
+	const ITMProfiler::Statistics & frame = result.stages[ITMProfiler::STAGE_PROCESS_FRAME];
+
+	printf("  %-5s voxel %.4f points %d budget %g swap %d async %d prefetch %d approx %d pipe %d thp %d interleave %d %-7s threads %2d : %7.2f fps, frame p50/p95/p99 %.2f/%.2f/%.2f ms, peak %.0f MB",
+		trackerNames[configuration.tracker], configuration.voxelSize, configuration.depthTrackerPointBudget,
+		configuration.depthTrackerTimeBudget, configuration.useSwapping, configuration.useAsynchronousSwapping,
+		configuration.swappingPrefetchFrames, configuration.useApproximateRaycast, configuration.usePipelinedProcessing, configuration.useHugePages, configuration.useNUMAInterleave,
+		affinityNames[configuration.threadAffinity], getNumberOfThreads(configuration), fps, frame.p50, frame.p95, frame.p99, result.peakHostMemory);
+	if (configuration.threadAffinity != ITMThreadAffinity::AFFINITY_NONE)
+	{
+		printf(", per node %s", getThreadsPerNUMANode(configuration, 0).c_str());
+		std::string mapping = getThreadsPerNUMANode(configuration, 1);
+		if (!mapping.empty()) printf(" mapping %s", mapping.c_str());
+	}
+	if (configuration.useSwapping) printf(", cache %d blocks (%d host, %d disk, %.1f MB)", result.cacheStoredBlocks, result.cacheHostBlocks, result.cacheDiskBlocks, result.cacheEncodedMemory);
+	if (result.hasGroundTruth) printf(", ATE %.4f m (max %.4f m)", result.ateRMSE, result.ateMax);
+	printf("\n");
+}
+
+int main(int argc, char** argv)
+try
+{
+	std::vector<Sequence> sequences;
+	std::vector<ITMLibSettings::TrackerType> trackers(1, ITMLibSettings::TRACKER_ICP);
+	std::vector<float> voxelSizes, timeBudgets;
+	std::vector<int> pointBudgets, swapping(1, 0), asyncSwapping(1, 0), prefetchFrames, approximateRaycast(1, 0), pipelined(1, 0), hugePages(1, 0), numaInterleave(1, 0), threads(1, 0);
+	std::vector<ITMThreadAffinity::Mode> affinities(1, ITMThreadAffinity::AFFINITY_NONE);
+	int maxFrames = 0, noWarmupFrames = 0, swappingHostBlockBudget = 0;
+	const char *csvFile = NULL;
+
+	{
+		ITMLibSettings defaults;
+		voxelSizes.push_back(defaults.sceneParams.voxelSize);
+		prefetchFrames.push_back(defaults.swappingPrefetchFrames);
+		pointBudgets.push_back(defaults.depthTrackerPointBudget);
+		timeBudgets.push_back(defaults.depthTrackerTimeBudget);
+	}
+
+	bool validArguments = true;
+	for (int i = 1; (i < argc) && validArguments; i++)
+	{
+		const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		bool isOption = (strncmp(argv[i], "--", 2) == 0);
+		if (isOption && (value == NULL)) { printf("error: missing value for %s\n", argv[i]); validArguments = false; break; }
+
+		if (!isOption)
+		{
+			Sequence sequence;
+			validArguments = parseSequence(argv[i], sequence);
+			if (validArguments) sequences.push_back(sequence);
+			continue;
+		}
+
+		i++;
+		if (strcmp(argv[i - 1], "--tracker") == 0) validArguments = parseTrackers(value, trackers);
+		else if (strcmp(argv[i - 1], "--voxel") == 0) validArguments = parseFloats(value, voxelSizes, false);
+		else if (strcmp(argv[i - 1], "--icp-points") == 0) validArguments = parseInts(value, pointBudgets, 0, 100000000);
+		else if (strcmp(argv[i - 1], "--tracker-budget") == 0) validArguments = parseFloats(value, timeBudgets, true);
+		else if (strcmp(argv[i - 1], "--swapping") == 0) validArguments = parseInts(value, swapping, 0, 1);
+		else if (strcmp(argv[i - 1], "--async-swapping") == 0) validArguments = parseInts(value, asyncSwapping, 0, 1);
+		else if (strcmp(argv[i - 1], "--prefetch-frames") == 0) validArguments = parseInts(value, prefetchFrames, 0, 100);
+		else if (strcmp(argv[i - 1], "--approx-raycast") == 0) validArguments = parseInts(value, approximateRaycast, 0, 1);
+		else if (strcmp(argv[i - 1], "--pipelined") == 0) validArguments = parseInts(value, pipelined, 0, 1);
+		else if (strcmp(argv[i - 1], "--huge-pages") == 0) validArguments = parseInts(value, hugePages, 0, 1);
+		else if (strcmp(argv[i - 1], "--numa-interleave") == 0) validArguments = parseInts(value, numaInterleave, 0, 1);
+		else if (strcmp(argv[i - 1], "--affinity") == 0) validArguments = parseAffinities(value, affinities);
+		else if (strcmp(argv[i - 1], "--threads") == 0) validArguments = parseInts(value, threads, 1, 1024);
+		else if (strcmp(argv[i - 1], "--swap-host-blocks") == 0) swappingHostBlockBudget = atoi(value);
+		else if (strcmp(argv[i - 1], "--frames") == 0) maxFrames = atoi(value);
+		else if (strcmp(argv[i - 1], "--warmup") == 0) noWarmupFrames = atoi(value);
+		else if (strcmp(argv[i - 1], "--csv") == 0) csvFile = value;
+		else { printf("error: unknown option %s\n", argv[i - 1]); validArguments = false; }
+	}
+
+	if (!validArguments || sequences.empty())
+	{
+		printf("usage: %s [<options>] <sequence> [<sequence> ...]\n"
+		       "  <sequence> : one of\n"
+		       "                 synthetic                             built-in synthetic scene\n"
+		       "                 <scenefile>                           synthetic scene file\n"
+		       "                 <sequencefile>[,<groundtruth>]        sequence file written by InfiniTAM_convert\n"
+		       "                 <calibfile>,<rgbmask>,<depthmask>[,<groundtruth>]\n"
+		       "               synthetic scenes provide their own ground truth, <groundtruth> holds\n"
+		       "               one pose per frame in the format of the TUM RGB-D benchmark\n"
+		       "\n"
+		       "options, lists are comma separated and every combination is run:\n"
+		       "  --tracker <list>        : color, icp, ren, imu, wicp (default icp)\n"
+		       "  --voxel <list>          : voxel sizes in metres, the truncation band is scaled along\n"
+		       "  --icp-points <list>     : icp tracker on the CPU, points per level chosen by normal space sampling,\n"
+		       "                            0 for all pixels (default: library default)\n"
+		       "  --tracker-budget <list> : icp tracker, milliseconds per frame, 0 for the full schedule (default: library default)\n"
+		       "  --swapping <list>       : 0, 1 (default 0)\n"
+		       "  --async-swapping <list> : 0, 1, with swapping on the CPU, swap on a background thread (default 0)\n"
+		       "  --prefetch-frames <list>: with swapping, frames of predicted camera motion to swap in for, 0 disables (default: library default)\n"
+		       "  --swap-host-blocks <n>  : with swapping, keep at most n blocks in host memory, the rest on disk (default 0: all)\n"
+		       "  --approx-raycast <list> : 0, 1 (default 0)\n"
+		       "  --pipelined <list>      : 0, 1 (default 0)\n"
+		       "  --huge-pages <list>     : 0, 1, transparent huge pages for the scene (default 0)\n"
+		       "  --numa-interleave <list>: 0, 1, spread the scene over all NUMA nodes (default 0)\n"
+		       "  --affinity <list>       : none, compact, scatter placement of the OpenMP threads (default none),\n"
+		       "                            pipelined tracking and mapping get disjoint halves of the cores\n"
+		       "  --threads <list>        : number of OpenMP threads (default: OpenMP default)\n"
+		       "  --frames <n>            : process at most n frames of each sequence\n"
+		       "  --warmup <n>            : exclude the first n frames from the timings (default 0)\n"
+		       "  --csv <file>            : write one line of results per run as comma separated values\n"
+		       "\n"
+		       "example:\n"
+		       "  %s --tracker icp,wicp --voxel 0.005,0.01 --csv results.csv synthetic ./Files/Synthetic/room.scene\n"
+		       "  %s --threads 4,8,16,32 --affinity compact,scatter --numa-interleave 0,1 --pipelined 0,1 synthetic\n\n",
+		       argv[0], argv[0], argv[0]);
+		return EXIT_FAILURE;
+	}
+
+#ifndef WITH_OPENMP
+	if ((threads.size() > 1) || (threads[0] != 0))
+	{
+		printf("built without OpenMP, ignoring --threads\n");
+		threads.assign(1, 0);
+	}
+#endif
+
+	printf("%d NUMA node(s)\n", ITMThreadAffinity::GetNumberOfNUMANodes());
+	if (!resetPeakMemory()) printf("cannot reset the peak memory on this platform, peak memory is that of the whole process so far\n");
+
+	FILE *csv = NULL;
+	if (csvFile != NULL)
+	{
+		csv = fopen(csvFile, "w");
+		if (csv == NULL) { printf("error creating file '%s'\n", csvFile); return EXIT_FAILURE; }
+		writeCSVHeader(csv);
+	}
+
+	// keep all timings of a run for the percentiles
+	ITMProfiler::SetWindowSize((maxFrames > 0) ? maxFrames : 100000);
+	ITMProfiler::SetEnabled(true);
+
+	int noFailedRuns = 0;
+	for (size_t s = 0; s < sequences.size(); s++)
+	{
+		printf("%s\n", sequences[s].name.c_str());
+		bool sequenceHasIMU = hasIMU(sequences[s]);
+
+		for (size_t t = 0; t < trackers.size(); t++) for (size_t v = 0; v < voxelSizes.size(); v++) for (size_t pb = 0; pb < pointBudgets.size(); pb++)
+		for (size_t tb = 0; tb < timeBudgets.size(); tb++)
+		for (size_t sw = 0; sw < swapping.size(); sw++) for (size_t as = 0; as < asyncSwapping.size(); as++)
+		for (size_t pf = 0; pf < prefetchFrames.size(); pf++) for (size_t ar = 0; ar < approximateRaycast.size(); ar++)
+		for (size_t p = 0; p < pipelined.size(); p++) for (size_t hp = 0; hp < hugePages.size(); hp++)
+		for (size_t ni = 0; ni < numaInterleave.size(); ni++) for (size_t af = 0; af < affinities.size(); af++) for (size_t th = 0; th < threads.size(); th++)
+		{
+			Configuration configuration;
+			configuration.tracker = trackers[t];
+			configuration.voxelSize = voxelSizes[v];
+			configuration.depthTrackerPointBudget = pointBudgets[pb];
+			configuration.depthTrackerTimeBudget = timeBudgets[tb];
+			configuration.useSwapping = swapping[sw] != 0;
+			configuration.useAsynchronousSwapping = asyncSwapping[as] != 0;
+			configuration.swappingPrefetchFrames = prefetchFrames[pf];
+			configuration.useApproximateRaycast = approximateRaycast[ar] != 0;
+			configuration.usePipelinedProcessing = pipelined[p] != 0;
+			configuration.useHugePages = hugePages[hp] != 0;
+			configuration.useNUMAInterleave = numaInterleave[ni] != 0;
+			configuration.threadAffinity = affinities[af];
+			configuration.noThreads = threads[th];
+			configuration.swappingHostBlockBudget = swappingHostBlockBudget;
+
+			if ((configuration.tracker == ITMLibSettings::TRACKER_IMU) && !sequenceHasIMU)
+			{
+				if ((v | pb | tb | sw | as | pf | ar | p | hp | ni | af | th) == 0) printf("  skipping the imu tracker, the sequence has no IMU data\n");
+				continue;
+			}
+
+			Result result;
+			if (!runBenchmark(sequences[s], configuration, maxFrames, noWarmupFrames, result)) { noFailedRuns++; continue; }
+
+			printSummary(configuration, result);
+			if (csv != NULL) writeCSVRow(csv, sequences[s], configuration, result);
+		}
+	}
+
+	if ((csv != NULL) && (fclose(csv) != 0)) { printf("error writing file '%s'\n", csvFile); return EXIT_FAILURE; }
+
+	return (noFailedRuns == 0) ? 0 : EXIT_FAILURE;
+}
+catch(std::exception& e)
+{
+	std::cerr << e.what() << '\n';
+	return EXIT_FAILURE;
+}
@@ -1,12 +1,20 @@
 // Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
 
 #include <cstdlib>
+#include <string.h>
+
+#include <vector>
 
 #include "Engine/CLIEngine.h"
 #include "Engine/ImageSourceEngine.h"
+#include "Engine/PrefetchingImageSource.h"
+#include "Engine/SequenceFile.h"
+#include "Engine/SyntheticSceneSource.h"
 #include "Engine/OpenNIEngine.h"
 #include "Engine/Kinect2Engine.h"
 
+#include "ITMLib/Utils/ITMProfiler.h"
+
 using namespace InfiniTAM::Engine;
 
 int main(int argc, char** argv)
@@ -17,6 +25,21 @@ try
 	const char *imagesource_part2 = NULL;
 	const char *imagesource_part3 = NULL;
 
+	// options may appear anywhere, everything else is a positional argument
+	const char *traceFile = NULL;
+	const char *profileFile = NULL;
+	const char *memoryFile = NULL;
+	std::vector<char*> args(1, argv[0]);
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc)) traceFile = argv[++i];
+		else if ((strcmp(argv[i], "--profile") == 0) && (i + 1 < argc)) profileFile = argv[++i];
+		else if ((strcmp(argv[i], "--memory") == 0) && (i + 1 < argc)) memoryFile = argv[++i];
+		else args.push_back(argv[i]);
+	}
+	args.push_back(NULL);
+	argv = &args[0];
+
 	int arg = 1;
 	do {
 		if (argv[arg] != NULL) calibFile = argv[arg]; else break;
@@ -29,24 +52,56 @@ try
 	} while (false);
 
 	if (arg == 1) {
-		printf("usage: %s [<calibfile> [<imagesource>] ]\n"
-		       "  <calibfile>   : path to a file containing intrinsic calibration parameters\n"
+		printf("usage: %s [<options>] [<calibfile> [<imagesource>] ]\n"
+		       "  <calibfile>   : path to a file containing intrinsic calibration parameters,\n"
+		       "                  a sequence file written by InfiniTAM_convert, a synthetic\n"
+		       "                  scene file or \"synthetic\" for the built-in synthetic scene\n"
 		       "  <imagesource> : either one argument to specify OpenNI device ID\n"
 		       "                  or two arguments specifying rgb and depth file masks\n"
 		       "\n"
+		       "options:\n"
+		       "  --trace <file>   : write a timeline of all processing stages in Chrome trace\n"
+		       "                     format, for chrome://tracing or ui.perfetto.dev\n"
+		       "  --profile <file> : write per-stage timing statistics as comma separated values\n"
+		       "  --memory <file>  : write current and peak memory per subsystem as comma\n"
+		       "                     separated values\n"
+		       "\n"
 		       "examples:\n"
 		       "  %s ./Files/Teddy/calib.txt ./Files/Teddy/Frames/%%04i.ppm ./Files/Teddy/Frames/%%04i.pgm\n"
-		       "  %s ./Files/Teddy/calib.txt\n\n", argv[0], argv[0], argv[0]);
+		       "  %s ./Files/Teddy/calib.txt\n"
+		       "  %s ./Files/Synthetic/room.scene\n\n", argv[0], argv[0], argv[0], argv[0]);
 	}
 
 	printf("initialising ...\n");
+
+	if (traceFile != NULL)
+	{
+		if (ITMProfiler::StartTrace(traceFile)) ITMProfiler::SetThreadName("main");
+		else printf("error creating trace file '%s'\n", traceFile);
+	}
 	ITMLibSettings *internalSettings = new ITMLibSettings();
+	if (profileFile != NULL) internalSettings->useProfiling = true;
 
 	ImageSourceEngine *imageSource;
 	IMUSourceEngine *imuSource = NULL;
-	printf("using calibration file: %s\n", calibFile);
-	if (imagesource_part2 == NULL) 
+	if ((imagesource_part1 == NULL) && SequenceFileReader::isSequenceFile(calibFile))
+	{
+		printf("using sequence file: %s\n", calibFile);
+		imageSource = new SequenceFileReader(calibFile);
+	}
+	else if ((imagesource_part1 == NULL) && (strcmp(calibFile, "synthetic") == 0))
 	{
+		printf("using built-in synthetic scene\n");
+		imageSource = new SyntheticSceneSource(SyntheticSceneSource::Settings());
+	}
+	else if ((imagesource_part1 == NULL) && SyntheticSceneSource::isSceneFile(calibFile))
+	{
+		printf("using synthetic scene: %s\n", calibFile);
+		imageSource = new SyntheticSceneSource(calibFile);
+	}
+	else if (imagesource_part2 == NULL) 
+	{
+		printf("using calibration file: %s\n", calibFile);
 		printf("using OpenNI device: %s\n", (imagesource_part1==NULL)?"<OpenNI default device>":imagesource_part1);
 		imageSource = new OpenNIEngine(calibFile, imagesource_part1);
 		if (imageSource->getDepthImageSize().x == 0) {
@@ -57,6 +112,7 @@ try
 	} 
 	else
 	{
+		printf("using calibration file: %s\n", calibFile);
 		if (imagesource_part3 == NULL)
 		{
 			printf("using rgb images: %s\nusing depth images: %s\n", imagesource_part1, imagesource_part2);
@@ -70,15 +126,36 @@ try
 		}
 	}
 
-	ITMMainEngine *mainEngine = new ITMMainEngine(internalSettings, &imageSource->calib, imageSource->getRGBImageSize(), imageSource->getDepthImageSize());
+	// read files (or render synthetic frames) ahead on a background thread, so that this overlaps with processing
+	PrefetchingImageSource *prefetcher = NULL;
+	if ((imagesource_part2 != NULL) || (dynamic_cast<SyntheticSceneSource*>(imageSource) != NULL)) prefetcher = new PrefetchingImageSource(imageSource, imuSource);
+
+	ImageSourceEngine *frameSource = (prefetcher != NULL) ? prefetcher : imageSource;
+	IMUSourceEngine *frameIMUSource = (prefetcher != NULL) ? prefetcher->getIMUSource() : imuSource;
+
+	SequenceFileReader *sequence = dynamic_cast<SequenceFileReader*>(imageSource);
+	if (sequence != NULL) frameIMUSource = sequence->getIMUSource();
 
-	CLIEngine::Instance()->Initialise(imageSource, imuSource, mainEngine, internalSettings->deviceType);
+	ITMMainEngine *mainEngine = new ITMMainEngine(internalSettings, &frameSource->calib, frameSource->getRGBImageSize(), frameSource->getDepthImageSize());
+
+	CLIEngine::Instance()->Initialise(frameSource, frameIMUSource, mainEngine, internalSettings->deviceType);
 	CLIEngine::Instance()->Run();
 	CLIEngine::Instance()->Shutdown();
 
+	if ((profileFile != NULL) && !ITMProfiler::SaveStatistics(profileFile)) printf("error writing file '%s'\n", profileFile);
+	if (memoryFile != NULL)
+	{
+		ORUtils::MemoryRegistry::PrintUsage();
+		if (!ORUtils::MemoryRegistry::SaveUsage(memoryFile)) printf("error writing file '%s'\n", memoryFile);
+	}
+
 	delete mainEngine;
 	delete internalSettings;
+	if (prefetcher != NULL) delete prefetcher;
 	delete imageSource;
+	if (imuSource != NULL) delete imuSource;
+
+	ITMProfiler::StopTrace();
 	return 0;
 }
 catch(std::exception& e)
@@ -0,0 +1,106 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <cstdlib>
+
+#include "Engine/ImageSourceEngine.h"
+#include "Engine/IMUSourceEngine.h"
+#include "Engine/PrefetchingImageSource.h"
+#include "Engine/SequenceFile.h"
+
+using namespace InfiniTAM::Engine;
+
+// the mask based layouts do not store any timing information
+static const double NOMINAL_FRAME_RATE = 30.0;
+
+int main(int argc, char** argv)
+try
+{
+	if (argc < 5) {
+		printf("usage: %s <outputfile> <calibfile> <rgbmask> <depthmask> [<imumask>]\n"
+		       "  <outputfile> : sequence file to be written\n"
+		       "  <calibfile>  : path to a file containing intrinsic calibration parameters\n"
+		       "  <rgbmask>    : file mask of the rgb images\n"
+		       "  <depthmask>  : file mask of the depth images\n"
+		       "  <imumask>    : file mask of the imu data; if given, the images are read\n"
+		       "                 as raw 320x240 files, as in InfiniTAM_cli\n"
+		       "\n"
+		       "Depth is stored with lossless compression. Timestamps are generated\n"
+		       "for a frame rate of %.0f Hz.\n"
+		       "\n"
+		       "example:\n"
+		       "  %s ./Files/Teddy/teddy.seq ./Files/Teddy/calib.txt ./Files/Teddy/Frames/%%04i.ppm ./Files/Teddy/Frames/%%04i.pgm\n\n",
+		       argv[0], NOMINAL_FRAME_RATE, argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const char *outputFile = argv[1];
+	const char *calibFile = argv[2];
+	const char *rgbMask = argv[3];
+	const char *depthMask = argv[4];
+	const char *imuMask = (argc > 5) ? argv[5] : NULL;
+
+	ImageSourceEngine *imageSource;
+	IMUSourceEngine *imuSource = NULL;
+	if (imuMask == NULL) imageSource = new ImageFileReader(calibFile, rgbMask, depthMask);
+	else
+	{
+		imageSource = new RawFileReader(calibFile, rgbMask, depthMask, Vector2i(320, 240), 0.5f);
+		imuSource = new IMUSourceEngine(imuMask);
+	}
+
+	if (!imageSource->hasMoreImages())
+	{
+		printf("no images found\n");
+		delete imageSource;
+		if (imuSource != NULL) delete imuSource;
+		return EXIT_FAILURE;
+	}
+
+	PrefetchingImageSource *prefetcher = new PrefetchingImageSource(imageSource, imuSource);
+	IMUSourceEngine *frameIMUSource = prefetcher->getIMUSource();
+
+	Vector2i imgSize_rgb = prefetcher->getRGBImageSize();
+	Vector2i imgSize_d = prefetcher->getDepthImageSize();
+
+	ITMUChar4Image *rgb = new ITMUChar4Image(imgSize_rgb, true, false);
+	ITMShortImage *rawDepth = new ITMShortImage(imgSize_d, true, false);
+	ITMIMUMeasurement *imu = new ITMIMUMeasurement();
+
+	SequenceFileWriter *writer = new SequenceFileWriter(outputFile, prefetcher->calib, imgSize_rgb, imgSize_d, frameIMUSource != NULL);
+
+	int frameNo = 0;
+	bool success = writer->isOpen();
+	while (success && prefetcher->hasMoreImages())
+	{
+		prefetcher->getImages(rgb, rawDepth);
+
+		const ITMIMUMeasurement *frameIMU = NULL;
+		if ((frameIMUSource != NULL) && frameIMUSource->hasMoreMeasurements())
+		{
+			frameIMUSource->getMeasurement(imu);
+			frameIMU = imu;
+		}
+
+		success = writer->addFrame(rgb, rawDepth, frameIMU, frameNo / NOMINAL_FRAME_RATE);
+		frameNo++;
+		if (frameNo % 100 == 0) printf("%d frames written\n", frameNo);
+	}
+
+	success &= writer->close();
+	if (success) printf("written %d frames to %s\n", writer->getNumberOfFrames(), outputFile);
+
+	delete writer;
+	delete imu;
+	delete rawDepth;
+	delete rgb;
+	delete prefetcher;
+	delete imageSource;
+	if (imuSource != NULL) delete imuSource;
+
+	return success ? 0 : EXIT_FAILURE;
+}
+catch(std::exception& e)
+{
+	std::cerr << e.what() << '\n';
+	return EXIT_FAILURE;
+}
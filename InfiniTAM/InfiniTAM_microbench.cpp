@@ -0,0 +1,434 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <cstdlib>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Engine/SyntheticSceneSource.h"
+
+#include "ITMLib/Engine/DeviceAgnostic/ITMDepthTracker.h"
+#include "ITMLib/Engine/DeviceAgnostic/ITMMeshingEngine.h"
+#include "ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h"
+#include "ITMLib/Engine/DeviceAgnostic/ITMSceneReconstructionEngine.h"
+#include "ITMLib/Engine/DeviceAgnostic/ITMViewBuilder.h"
+#include "ITMLib/Engine/DeviceAgnostic/ITMVisualisationEngine.h"
+
+#include "ITMLib/Utils/ITMProfiler.h"
+
+using namespace InfiniTAM::Engine;
+
+/// Fixed inputs of all kernels, taken from a scene built by fusing synthetic frames
+struct Inputs
+{
+	Vector2i imgSize;
+	const float *depth;
+	Vector4f projParams, invProjParams;
+	Matrix4f M_d, invM_d;
+
+	const ITMVoxel *voxelData;
+	const ITMVoxelIndex::IndexData *voxelIndex;
+	float voxelSize, mu, viewFrustum_min, viewFrustum_max;
+	int maxW;
+
+	/// raycast of the scene from the last pose, as used for tracking
+	const Vector4f *pointsMap, *normalsMap;
+	Matrix4f scenePose;
+	float distThresh;
+
+	/// ids of all hash entries with an allocated voxel block
+	std::vector<int> allocatedEntries;
+	/// surface points in voxel coordinates, in image order and shuffled
+	std::vector<Vector3f> surfacePoints;
+	std::vector<Vector3i> shuffledVoxels;
+};
+
+/// Outputs of the kernels, reset before each run outside of the timed region
+struct Scratch
+{
+	std::vector<float> depth;
+	std::vector<ITMVoxel> voxels;
+	std::vector<uchar> entriesAllocType, entriesVisibleType;
+	std::vector<Vector4s> blockCoords;
+};
+
+/// Runs a kernel over all of its inputs once; returns a checksum of the results and the number of calls
+typedef double (*KernelFunction)(const Inputs & in, Scratch & scratch, long & noCalls);
+typedef void (*PrepareFunction)(const Inputs & in, Scratch & scratch);
+
+struct Kernel
+{
+	const char *name;
+	PrepareFunction prepare;
+	KernelFunction run;
+};
+
+// ---------------------------------------------------------------------------
+// kernels
+
+static double runFilterDepth(const Inputs & in, Scratch & scratch, long & noCalls)
+{
+	float *out = &scratch.depth[0];
+	for (int y = 2; y < in.imgSize.y - 2; y++) for (int x = 2; x < in.imgSize.x - 2; x++)
+		filterDepth(out, in.depth, x, y, in.imgSize);
+
+	noCalls = (long)(in.imgSize.x - 4) * (in.imgSize.y - 4);
+	double checksum = 0.0;
+	for (size_t i = 0; i < scratch.depth.size(); i++) checksum += scratch.depth[i];
+	return checksum;
+}
+
+static void prepareBuildHashAlloc(const Inputs & in, Scratch & scratch)
+{
+	std::fill(scratch.entriesAllocType.begin(), scratch.entriesAllocType.end(), (uchar)0);
+	std::fill(scratch.entriesVisibleType.begin(), scratch.entriesVisibleType.end(), (uchar)0);
+}
+
+static double runBuildHashAlloc(const Inputs & in, Scratch & scratch, long & noCalls)
+{
+	float oneOverBlockSize = 1.0f / (in.voxelSize * SDF_BLOCK_SIZE);
+	for (int y = 0; y < in.imgSize.y; y++) for (int x = 0; x < in.imgSize.x; x++)
+		buildHashAllocAndVisibleTypePP(&scratch.entriesAllocType[0], &scratch.entriesVisibleType[0], x, y, &scratch.blockCoords[0], in.depth,
+			in.invM_d, in.invProjParams, in.mu, in.imgSize, oneOverBlockSize, in.voxelIndex, in.viewFrustum_min, in.viewFrustum_max);
+
+	noCalls = (long)in.imgSize.x * in.imgSize.y;
+	double checksum = 0.0;
+	for (size_t i = 0; i < scratch.entriesAllocType.size(); i++) checksum += scratch.entriesAllocType[i] + 4 * scratch.entriesVisibleType[i];
+	return checksum;
+}
+
+static void prepareIntegrate(const Inputs & in, Scratch & scratch)
+{
+	// integrate into a copy, so that every run starts from the same voxels
+	scratch.voxels.resize(in.allocatedEntries.size() * SDF_BLOCK_SIZE3);
+	for (size_t i = 0; i < in.allocatedEntries.size(); i++)
+	{
+		const ITMVoxel *src = in.voxelData + in.voxelIndex[in.allocatedEntries[i]].ptr * SDF_BLOCK_SIZE3;
+		std::copy(src, src + SDF_BLOCK_SIZE3, scratch.voxels.begin() + i * SDF_BLOCK_SIZE3);
+	}
+}
+
+static double runComputeUpdatedVoxelDepthInfo(const Inputs & in, Scratch & scratch, long & noCalls)
+{
+	double checksum = 0.0;
+	for (size_t i = 0; i < in.allocatedEntries.size(); i++)
+	{
+		Vector3i globalPos = in.voxelIndex[in.allocatedEntries[i]].pos.toInt() * SDF_BLOCK_SIZE;
+		ITMVoxel *localVoxelBlock = &scratch.voxels[i * SDF_BLOCK_SIZE3];
+
+		for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+		{
+			Vector4f pt_model((float)(globalPos.x + x) * in.voxelSize, (float)(globalPos.y + y) * in.voxelSize, (float)(globalPos.z + z) * in.voxelSize, 1.0f);
+			float eta = computeUpdatedVoxelDepthInfo(localVoxelBlock[x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE], pt_model,
+				in.M_d, in.projParams, in.mu, in.maxW, in.depth, in.imgSize);
+			if (eta > -1.0f) checksum += eta;
+		}
+	}
+
+	noCalls = (long)in.allocatedEntries.size() * SDF_BLOCK_SIZE3;
+	return checksum;
+}
+
+static double runCastRay(const Inputs & in, Scratch & scratch, long & noCalls)
+{
+	Vector2f viewFrustum_minmax(in.viewFrustum_min, in.viewFrustum_max);
+	double checksum = 0.0;
+	for (int y = 0; y < in.imgSize.y; y++) for (int x = 0; x < in.imgSize.x; x++)
+	{
+		Vector4f pt_out;
+		if (castRay<ITMVoxel, ITMVoxelIndex>(pt_out, x, y, in.voxelData, in.voxelIndex, in.invM_d, in.invProjParams, 1.0f / in.voxelSize, in.mu, viewFrustum_minmax))
+			checksum += pt_out.x + pt_out.y + pt_out.z;
+	}
+
+	noCalls = (long)in.imgSize.x * in.imgSize.y;
+	return checksum;
+}
+
+static double runFindVoxel(const Inputs & in, Scratch & scratch, long & noCalls)
+{
+	ITMVoxelIndex::IndexCache cache;
+	double checksum = 0.0;
+	for (size_t i = 0; i < in.surfacePoints.size(); i++)
+	{
+		bool isFound;
+		int address = findVoxel(in.voxelIndex, in.surfacePoints[i].toIntRound(), isFound, cache);
+		if (isFound) checksum += address;
+	}
+
+	noCalls = (long)in.surfacePoints.size();
+	return checksum;
+}
+
+static double runReadVoxel(const Inputs & in, Scratch & scratch, long & noCalls)
+{
+	ITMVoxelIndex::IndexCache cache;
+	double checksum = 0.0;
+	for (size_t i = 0; i < in.surfacePoints.size(); i++)
+	{
+		bool isFound;
+		ITMVoxel voxel = readVoxel(in.voxelData, in.voxelIndex, in.surfacePoints[i].toIntRound(), isFound, cache);
+		checksum += ITMVoxel::SDF_valueToFloat(voxel.sdf);
+	}
+
+	noCalls = (long)in.surfacePoints.size();
+	return checksum;
+}
+
+static double runReadVoxelShuffled(const Inputs & in, Scratch & scratch, long & noCalls)
+{
+	// random access: the block cache rarely hits
+	ITMVoxelIndex::IndexCache cache;
+	double checksum = 0.0;
+	for (size_t i = 0; i < in.shuffledVoxels.size(); i++)
+	{
+		bool isFound;
+		ITMVoxel voxel = readVoxel(in.voxelData, in.voxelIndex, in.shuffledVoxels[i], isFound, cache);
+		checksum += ITMVoxel::SDF_valueToFloat(voxel.sdf);
+	}
+
+	noCalls = (long)in.shuffledVoxels.size();
+	return checksum;
+}
+
+static double runReadSDFInterpolated(const Inputs & in, Scratch & scratch, long & noCalls)
+{
+	ITMVoxelIndex::IndexCache cache;
+	double checksum = 0.0;
+	for (size_t i = 0; i < in.surfacePoints.size(); i++)
+	{
+		bool isFound;
+		float sdf = readFromSDF_float_interpolated(in.voxelData, in.voxelIndex, in.surfacePoints[i], isFound, cache);
+		if (isFound) checksum += sdf;
+	}
+
+	noCalls = (long)in.surfacePoints.size();
+	return checksum;
+}
+
+template<bool shortIteration, bool rotationOnly>
+static double runComputePerPointGH_Depth(const Inputs & in, Scratch & scratch, long & noCalls)
+{
+	double checksum = 0.0;
+	for (int y = 0; y < in.imgSize.y; y++) for (int x = 0; x < in.imgSize.x; x++)
+	{
+		float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
+		if (computePerPointGH_Depth<shortIteration, rotationOnly>(localNabla, localHessian, localF, x, y, in.depth[x + y * in.imgSize.x], in.imgSize,
+			in.projParams, in.imgSize, in.projParams, in.invM_d, in.scenePose, in.pointsMap, in.normalsMap, in.distThresh))
+			checksum += localF + localNabla[0];
+	}
+
+	noCalls = (long)in.imgSize.x * in.imgSize.y;
+	return checksum;
+}
+
+static double runBuildVertList(const Inputs & in, Scratch & scratch, long & noCalls)
+{
+	double checksum = 0.0;
+	for (size_t i = 0; i < in.allocatedEntries.size(); i++)
+	{
+		Vector3i globalPos = in.voxelIndex[in.allocatedEntries[i]].pos.toInt() * SDF_BLOCK_SIZE;
+
+		for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+		{
+			Vector3f vertList[12];
+			int cubeIndex = buildVertList(vertList, globalPos, Vector3i(x, y, z), in.voxelData, in.voxelIndex);
+			if (cubeIndex > 0) checksum += cubeIndex;
+		}
+	}
+
+	noCalls = (long)in.allocatedEntries.size() * SDF_BLOCK_SIZE3;
+	return checksum;
+}
+
+static const Kernel kernels[] = {
+	{ "filterDepth", NULL, runFilterDepth },
+	{ "buildHashAllocAndVisibleTypePP", prepareBuildHashAlloc, runBuildHashAlloc },
+	{ "computeUpdatedVoxelDepthInfo", prepareIntegrate, runComputeUpdatedVoxelDepthInfo },
+	{ "castRay", NULL, runCastRay },
+	{ "findVoxel", NULL, runFindVoxel },
+	{ "readVoxel", NULL, runReadVoxel },
+	{ "readVoxel_shuffled", NULL, runReadVoxelShuffled },
+	{ "readFromSDF_float_interpolated", NULL, runReadSDFInterpolated },
+	{ "computePerPointGH_Depth", NULL, runComputePerPointGH_Depth<false, false> },
+	{ "computePerPointGH_Depth_rotation", NULL, runComputePerPointGH_Depth<true, true> },
+	{ "buildVertList", NULL, runBuildVertList }
+};
+static const int NUM_KERNELS = sizeof(kernels) / sizeof(kernels[0]);
+
+// ---------------------------------------------------------------------------
+
+static void setupInputs(ITMMainEngine *mainEngine, const ITMLibSettings *settings, Inputs & in, Scratch & scratch)
+{
+	ITMView *view = mainEngine->GetView();
+	ITMTrackingState *trackingState = mainEngine->GetTrackingState();
+	ITMScene<ITMVoxel, ITMVoxelIndex> *scene = mainEngine->GetScene();
+
+	in.imgSize = view->depth->noDims;
+	in.depth = view->depth->GetData(MEMORYDEVICE_CPU);
+	in.projParams = view->calib->intrinsics_d.projectionParamsSimple.all;
+	in.invProjParams = in.projParams;
+	in.invProjParams.x = 1.0f / in.invProjParams.x;
+	in.invProjParams.y = 1.0f / in.invProjParams.y;
+	in.M_d = trackingState->pose_d->GetM();
+	in.invM_d = trackingState->pose_d->GetInvM();
+
+	in.voxelData = scene->localVBA.GetVoxelBlocks();
+	in.voxelIndex = scene->index.getIndexData();
+	in.voxelSize = scene->sceneParams->voxelSize;
+	in.mu = scene->sceneParams->mu;
+	in.maxW = scene->sceneParams->maxW;
+	in.viewFrustum_min = scene->sceneParams->viewFrustum_min;
+	in.viewFrustum_max = scene->sceneParams->viewFrustum_max;
+
+	in.pointsMap = trackingState->pointCloud->locations->GetData(MEMORYDEVICE_CPU);
+	in.normalsMap = trackingState->pointCloud->colours->GetData(MEMORYDEVICE_CPU);
+	in.scenePose = trackingState->pose_pointCloud->GetM();
+	in.distThresh = settings->depthTrackerICPThreshold;
+
+	in.allocatedEntries.clear();
+	for (int i = 0; i < scene->index.noTotalEntries; i++) if (in.voxelIndex[i].ptr >= 0) in.allocatedEntries.push_back(i);
+
+	in.surfacePoints.clear();
+	for (int i = 0; i < in.imgSize.x * in.imgSize.y; i++)
+	{
+		const Vector4f & point = in.pointsMap[i];
+		if (point.w > 0.0f) in.surfacePoints.push_back(point.toVector3() / in.voxelSize);
+	}
+
+	// fixed seed, so that every run visits the voxels in the same order
+	in.shuffledVoxels.resize(in.surfacePoints.size());
+	for (size_t i = 0; i < in.surfacePoints.size(); i++) in.shuffledVoxels[i] = in.surfacePoints[i].toIntRound();
+	unsigned int state = 12345;
+	for (size_t i = in.shuffledVoxels.size(); i > 1; i--)
+	{
+		state = state * 1664525u + 1013904223u;
+		std::swap(in.shuffledVoxels[i - 1], in.shuffledVoxels[(state >> 8) % i]);
+	}
+
+	scratch.depth.assign(in.imgSize.x * in.imgSize.y, 0.0f);
+	scratch.entriesAllocType.assign(scene->index.noTotalEntries, 0);
+	scratch.entriesVisibleType.assign(scene->index.noTotalEntries, 0);
+	scratch.blockCoords.assign(scene->index.noTotalEntries, Vector4s((short)0));
+}
+
+int main(int argc, char** argv)
+try
+{
+	Vector2i imgSize(640, 480);
+	int noFrames = 10, noRepetitions = 5;
+	const char *filter = NULL;
+	const char *csvFile = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if ((strcmp(argv[i], "--size") == 0) && (value != NULL) && (sscanf(value, "%dx%d", &imgSize.x, &imgSize.y) == 2)) i++;
+		else if ((strcmp(argv[i], "--frames") == 0) && (value != NULL)) { noFrames = atoi(value); i++; }
+		else if ((strcmp(argv[i], "--repeat") == 0) && (value != NULL)) { noRepetitions = atoi(value); i++; }
+		else if ((strcmp(argv[i], "--filter") == 0) && (value != NULL)) { filter = value; i++; }
+		else if ((strcmp(argv[i], "--csv") == 0) && (value != NULL)) { csvFile = value; i++; }
+		else
+		{
+			printf("usage: %s [<options>]\n"
+			       "\n"
+			       "Times the DeviceAgnostic kernels in isolation, one call after the other on a\n"
+			       "single thread. The inputs are fixed: a scene fused from frames of the built-in\n"
+			       "synthetic scene, the last of these frames and the raycast from its pose. The\n"
+			       "checksums only depend on the results of the kernels and should not change\n"
+			       "with optimisations that are meant to be exact.\n"
+			       "\n"
+			       "options:\n"
+			       "  --size <w>x<h>   : image size (default 640x480)\n"
+			       "  --frames <n>     : number of frames fused before timing (default 10)\n"
+			       "  --repeat <n>     : timed runs of each kernel (default 5)\n"
+			       "  --filter <text>  : only run the kernels whose name contains <text>\n"
+			       "  --csv <file>     : write the results as comma separated values\n\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if ((imgSize.x <= 4) || (imgSize.y <= 4) || (noFrames < 1) || (noRepetitions < 1))
+	{
+		printf("error: invalid image size, number of frames or repetitions\n");
+		return EXIT_FAILURE;
+	}
+
+	SyntheticSceneSource::Settings sceneSettings;
+	sceneSettings.imgSize = imgSize;
+	SyntheticSceneSource *imageSource = new SyntheticSceneSource(sceneSettings);
+
+	ITMLibSettings *settings = new ITMLibSettings();
+	// the kernels are called on host memory
+	settings->deviceType = ITMLibSettings::DEVICE_CPU;
+
+	ITMMainEngine *mainEngine = new ITMMainEngine(settings, &imageSource->calib, imgSize, imgSize);
+	ITMUChar4Image *rgb = new ITMUChar4Image(imgSize, true, false);
+	ITMShortImage *rawDepth = new ITMShortImage(imgSize, true, false);
+
+	printf("fusing %d frames of %dx%d ...\n", noFrames, imgSize.x, imgSize.y);
+	for (int i = 0; (i < noFrames) && imageSource->hasMoreImages(); i++)
+	{
+		imageSource->getImages(rgb, rawDepth);
+		mainEngine->ProcessFrame(rgb, rawDepth);
+	}
+
+	Inputs in;
+	Scratch scratch;
+	setupInputs(mainEngine, settings, in, scratch);
+	printf("%d allocated blocks, %d surface points\n\n", (int)in.allocatedEntries.size(), (int)in.surfacePoints.size());
+
+	FILE *csv = NULL;
+	if (csvFile != NULL)
+	{
+		csv = fopen(csvFile, "w");
+		if (csv == NULL) { printf("error creating file '%s'\n", csvFile); return EXIT_FAILURE; }
+		fprintf(csv, "kernel,calls,min_ns_per_call,median_ns_per_call,checksum\n");
+	}
+
+	printf("%-34s %10s %12s %12s %16s\n", "kernel", "calls", "min [ns]", "median [ns]", "checksum");
+	for (int k = 0; k < NUM_KERNELS; k++)
+	{
+		const Kernel & kernel = kernels[k];
+		if ((filter != NULL) && (strstr(kernel.name, filter) == NULL)) continue;
+
+		long noCalls = 0;
+		double checksum = 0.0;
+		std::vector<double> times;
+
+		// the first run is not timed, it brings the inputs into the caches
+		for (int r = -1; r < noRepetitions; r++)
+		{
+			if (kernel.prepare != NULL) kernel.prepare(in, scratch);
+
+			double start = ITMProfiler::GetTime();
+			checksum = kernel.run(in, scratch, noCalls);
+			double time = ITMProfiler::GetTime() - start;
+
+			if (r >= 0) times.push_back(time);
+		}
+
+		std::sort(times.begin(), times.end());
+		double perCall = (noCalls > 0) ? 1e6 / noCalls : 0.0;
+		double minTime = times[0] * perCall, medianTime = times[times.size() / 2] * perCall;
+
+		printf("%-34s %10ld %12.2f %12.2f %16.6e\n", kernel.name, noCalls, minTime, medianTime, checksum);
+		if (csv != NULL) fprintf(csv, "%s,%ld,%f,%f,%.9e\n", kernel.name, noCalls, minTime, medianTime, checksum);
+	}
+
+	bool success = true;
+	if ((csv != NULL) && (fclose(csv) != 0)) { printf("error writing file '%s'\n", csvFile); success = false; }
+
+	delete rawDepth;
+	delete rgb;
+	delete mainEngine;
+	delete settings;
+	delete imageSource;
+
+	return success ? 0 : EXIT_FAILURE;
+}
+catch(std::exception& e)
+{
+	std::cerr << e.what() << '\n';
+	return EXIT_FAILURE;
+}
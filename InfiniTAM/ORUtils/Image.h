@@ -34,8 +34,12 @@ namespace ORUtils
 			this->noDims = Vector2<int>(0, 0);
 		}
 
-		Image(Vector2<int> noDims, MemoryDeviceType memoryType)
-			: MemoryBlock<T>(noDims.x * noDims.y, memoryType)
+		/** Initialize an empty image of the given size on CPU
+		or GPU, with its buffer optionally taken from the
+		MemoryPool, see MemoryBlock.
+		*/
+		Image(Vector2<int> noDims, MemoryDeviceType memoryType, bool pooled = false)
+			: MemoryBlock<T>(noDims.x * noDims.y, memoryType, pooled)
 		{
 			this->noDims = noDims;
 		}
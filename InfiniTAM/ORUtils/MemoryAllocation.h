@@ -0,0 +1,137 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "PlatformIndependence.h"
+
+namespace ORUtils
+{
+	/** Alignment of all plain host allocations of MemoryBlock and MemoryPool: one cache line, enough for any SIMD load. */
+	static const size_t MEMORY_ALIGNMENT = 64;
+
+	/** Host allocations of at least this size are backed by transparent huge pages and interleaved across NUMA nodes if enabled,
+	and first touched by all threads, see setHugePagesEnabled() and setNUMAInterleaveEnabled(). */
+	static const size_t LARGE_ALLOCATION_SIZE = 4 * 1024 * 1024;
+
+	static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	inline bool & hugePagesEnabled(void)
+	{
+		static bool enabled = false;
+		return enabled;
+	}
+
+	/** Requests transparent huge pages for large host allocations made from now on. Only has an
+	effect on Linux, and only if the kernel allows it for madvise'd regions
+	(/sys/kernel/mm/transparent_hugepage/enabled set to "madvise" or "always"). Huge pages cut
+	TLB misses when large blocks such as the voxel blocks and the hash table are accessed randomly,
+	at the price of faulting in memory in 2 MB steps.
+	*/
+	inline void setHugePagesEnabled(bool enable) { hugePagesEnabled() = enable; }
+
+	inline bool & numaInterleaveEnabled(void)
+	{
+		static bool enabled = false;
+		return enabled;
+	}
+
+	/** Spreads the pages of large host allocations made from now on round robin over all NUMA
+	nodes the process may use. Without it, pages are placed on the node of the thread that first
+	touches them. Only has an effect on Linux.
+	*/
+	inline void setNUMAInterleaveEnabled(bool enable) { numaInterleaveEnabled() = enable; }
+
+	/** Sets the interleave policy on a range of pages that has not been touched yet. */
+	inline bool interleaveHostData(void *ptr, size_t size)
+	{
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_get_mempolicy)
+		// nodes allowed for this process, as a bit mask
+		unsigned long nodeMask[16] = { 0 };
+		const unsigned long maxNode = sizeof(nodeMask) * 8;
+		int mode;
+		if (syscall(SYS_get_mempolicy, &mode, nodeMask, maxNode, NULL, MPOL_F_MEMS_ALLOWED) != 0) return false;
+
+		return syscall(SYS_mbind, ptr, size, MPOL_INTERLEAVE, nodeMask, maxNode, 0) == 0;
+#else
+		return false;
+#endif
+	}
+
+	/** Allocates @p size bytes aligned to @p alignment, which has to be a power of two and a multiple of sizeof(void*). */
+	inline void *allocateAlignedData(size_t size, size_t alignment)
+	{
+		void *ptr = NULL;
+#ifdef _WIN32
+		ptr = _aligned_malloc(size, alignment);
+#else
+		if (posix_memalign(&ptr, alignment, size) != 0) ptr = NULL;
+#endif
+		if (ptr == NULL) DIEWITHEXCEPTION("out of memory");
+		return ptr;
+	}
+
+	inline void freeAlignedData(void *ptr)
+	{
+#ifdef _WIN32
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+
+	/** Allocates plain host memory, aligned to MEMORY_ALIGNMENT. Large allocations are aligned to whole
+	huge pages, and backed by huge pages or interleaved across NUMA nodes if enabled. Release with freeAlignedData().
+	*/
+	inline void *allocateHostData(size_t size)
+	{
+		if (size < LARGE_ALLOCATION_SIZE) return allocateAlignedData(size, MEMORY_ALIGNMENT);
+
+		// large blocks are usually mapped freshly by the C library, so their pages are placed when first touched after this
+		size_t largeSize = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+		void *ptr = allocateAlignedData(largeSize, HUGE_PAGE_SIZE);
+
+		// both are only hints, the allocation stays valid if the kernel refuses
+#if !defined(_WIN32) && defined(MADV_HUGEPAGE)
+		if (hugePagesEnabled()) madvise(ptr, largeSize, MADV_HUGEPAGE);
+#endif
+		if (numaInterleaveEnabled()) interleaveHostData(ptr, largeSize);
+
+		return ptr;
+	}
+
+	/** memset() of host memory. Large ranges are cleared by all OpenMP threads in static chunks, so that
+	pages first touched here end up spread over the NUMA nodes of the threads rather than all on the
+	node of the calling thread.
+	*/
+	inline void clearHostData(void *ptr, unsigned char value, size_t size)
+	{
+		if (size < LARGE_ALLOCATION_SIZE) { memset(ptr, value, size); return; }
+
+		const size_t chunkSize = 64 * 1024;
+		int noChunks = (int)((size + chunkSize - 1) / chunkSize);
+#ifdef WITH_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+		for (int i = 0; i < noChunks; i++)
+		{
+			size_t offset = i * chunkSize;
+			memset((unsigned char*)ptr + offset, value, (offset + chunkSize <= size) ? chunkSize : size - offset);
+		}
+	}
+}
@@ -17,6 +17,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <new>
+#include <type_traits>
+
+#include "MemoryAllocation.h"
+#include "MemoryPool.h"
+#include "MemoryRegistry.h"
+
 #endif
 
 #ifndef MEMORY_DEVICE_TYPE
@@ -32,9 +39,23 @@ namespace ORUtils
 	template <typename T>
 	class MemoryBlock
 	{
+#ifndef __METALC__
+		// host data is not released with delete[], so destructors are never run
+		static_assert(std::is_trivially_destructible<T>::value, "MemoryBlock only holds trivially destructible types");
+#endif
+
 	protected:
 #ifndef __METALC__
 		bool isAllocated_CPU, isAllocated_CUDA, isMetalCompatible;
+
+		/** Whether plain host and device buffers are taken from the MemoryPool. */
+		bool isPooled;
+		/** Devices whose pooled buffer is handed back while the block is not in use, see ReleaseToPool(). */
+		bool isReleased_CPU, isReleased_CUDA;
+
+		/** Tag the allocations are registered under in the MemoryRegistry, and the bytes registered per device. */
+		const char *tag;
+		size_t registeredBytes_CPU, registeredBytes_CUDA;
 #endif
 		/** Pointer to memory on CPU host. */
 		DEVICEPTR(T)* data_cpu;
@@ -48,6 +69,40 @@ namespace ORUtils
 		void *data_metalBuffer;
 #endif
 
+		/** Default constructs the host data. Large blocks are constructed by all OpenMP
+		threads, which touch the pages first, see clearHostData().
+		*/
+		void ConstructElements(void)
+		{
+			if (std::is_trivially_default_constructible<T>::value) return;
+
+			int noElements = (int)dataSize;
+#ifdef WITH_OPENMP
+#pragma omp parallel for schedule(static) if (dataSize * sizeof(T) >= LARGE_ALLOCATION_SIZE)
+#endif
+			for (int i = 0; i < noElements; i++) new (&data_cpu[i]) T;
+		}
+
+		/** Wraps @p dataSize elements of host memory at @p data that is owned by the derived
+		class, such as a mapped file. The memory is neither cleared nor released by this class,
+		and not registered with the MemoryRegistry.
+		*/
+		MemoryBlock(T *data, size_t dataSize)
+		{
+			this->isAllocated_CPU = false;
+			this->isAllocated_CUDA = false;
+			this->isMetalCompatible = false;
+			this->isPooled = false;
+			this->isReleased_CPU = false;
+			this->isReleased_CUDA = false;
+			this->tag = MemoryRegistry::GetCurrentTag();
+			this->registeredBytes_CPU = 0;
+			this->registeredBytes_CUDA = 0;
+
+			this->data_cpu = data;
+			this->data_cuda = NULL;
+			this->dataSize = dataSize;
+		}
 #endif
 	public:
 		enum MemoryCopyDirection { CPU_TO_CPU, CPU_TO_CUDA, CUDA_TO_CPU, CUDA_TO_CUDA };
@@ -94,6 +149,12 @@ namespace ORUtils
 			this->isAllocated_CPU = false;
 			this->isAllocated_CUDA = false;
 			this->isMetalCompatible = false;
+			this->isPooled = false;
+			this->isReleased_CPU = false;
+			this->isReleased_CUDA = false;
+			this->tag = MemoryRegistry::GetCurrentTag();
+			this->registeredBytes_CPU = 0;
+			this->registeredBytes_CUDA = 0;
 
 			Allocate(dataSize, allocate_CPU, allocate_CUDA, metalCompatible);
 			Clear();
@@ -101,13 +162,20 @@ namespace ORUtils
 
 		/** Initialize an empty memory block of the given size, either
 		on CPU only or on GPU only. CPU will be Metal compatible if Metal
-		is enabled.
+		is enabled. If @p pooled is set, the buffer is taken from and
+		returned to the MemoryPool; the constructors of T are not run.
 		*/
-		MemoryBlock(size_t dataSize, MemoryDeviceType memoryType)
+		MemoryBlock(size_t dataSize, MemoryDeviceType memoryType, bool pooled = false)
 		{
 			this->isAllocated_CPU = false;
 			this->isAllocated_CUDA = false;
 			this->isMetalCompatible = false;
+			this->isPooled = pooled;
+			this->isReleased_CPU = false;
+			this->isReleased_CUDA = false;
+			this->tag = MemoryRegistry::GetCurrentTag();
+			this->registeredBytes_CPU = 0;
+			this->registeredBytes_CUDA = 0;
 
 			switch (memoryType)
 			{
@@ -118,10 +186,41 @@ namespace ORUtils
 			Clear();
 		}
 
+		/** Hand the buffer of a pooled block back to the MemoryPool while the block is not
+		in use, so that other pooled blocks of the same size can take it in the meantime.
+		The data is lost. Blocks that are not pooled keep their buffer.
+		*/
+		void ReleaseToPool(void)
+		{
+			if (!isPooled) return;
+#ifdef COMPILE_WITH_METAL
+			// Metal compatible buffers do not come from the pool
+			if (isMetalCompatible) return;
+#endif
+			isReleased_CPU = isReleased_CPU || isAllocated_CPU;
+			isReleased_CUDA = isReleased_CUDA || isAllocated_CUDA;
+			Free();
+		}
+
+		/** Take a buffer of the current size from the MemoryPool again after ReleaseToPool().
+		Its contents are undefined.
+		*/
+		void AcquireFromPool(void)
+		{
+			if (!(isReleased_CPU || isReleased_CUDA)) return;
+
+			Allocate(dataSize, isReleased_CPU, isReleased_CUDA, true);
+			isReleased_CPU = false;
+			isReleased_CUDA = false;
+		}
+
+		/** Tag the allocations of this block are registered under, see MemoryRegistry. */
+		const char *GetTag(void) const { return tag; }
+
 		/** Set all image data to the given @p defaultValue. */
 		void Clear(unsigned char defaultValue = 0)
 		{
-			if (isAllocated_CPU) memset(data_cpu, defaultValue, dataSize * sizeof(T));
+			if (isAllocated_CPU) clearHostData(data_cpu, defaultValue, dataSize * sizeof(T));
 #ifndef COMPILE_WITHOUT_CUDA
 			if (isAllocated_CUDA) ORcudaSafeCall(cudaMemset(data_cuda, defaultValue, dataSize * sizeof(T)));
 #endif
@@ -190,7 +289,12 @@ namespace ORUtils
 				{
 				case 0:
 					if (dataSize == 0) data_cpu = NULL;
-					else data_cpu = new T[dataSize];
+					else if (isPooled) data_cpu = (T*)MemoryPool::Acquire(MEMORYDEVICE_CPU, dataSize * sizeof(T));
+					else
+					{
+						data_cpu = (T*)allocateHostData(dataSize * sizeof(T));
+						ConstructElements();
+					}
 					break;
 				case 1:
 #ifndef COMPILE_WITHOUT_CUDA
@@ -208,14 +312,21 @@ namespace ORUtils
 
 				this->isAllocated_CPU = allocate_CPU;
 				this->isMetalCompatible = metalCompatible;
+
+				registeredBytes_CPU = (isPooled && (allocType == 0)) ? MemoryPool::GetSizeClass(dataSize * sizeof(T)) : dataSize * sizeof(T);
+				MemoryRegistry::RegisterAllocation(tag, MEMORYDEVICE_CPU, registeredBytes_CPU);
 			}
 
 			if (allocate_CUDA)
 			{
 #ifndef COMPILE_WITHOUT_CUDA
 				if (dataSize == 0) data_cuda = NULL;
+				else if (isPooled) data_cuda = (T*)MemoryPool::Acquire(MEMORYDEVICE_CUDA, dataSize * sizeof(T));
 				else ORcudaSafeCall(cudaMalloc((void**)&data_cuda, dataSize * sizeof(T)));
 				this->isAllocated_CUDA = allocate_CUDA;
+
+				registeredBytes_CUDA = isPooled ? MemoryPool::GetSizeClass(dataSize * sizeof(T)) : dataSize * sizeof(T);
+				MemoryRegistry::RegisterAllocation(tag, MEMORYDEVICE_CUDA, registeredBytes_CUDA);
 #endif
 			}
 		}
@@ -235,7 +346,9 @@ namespace ORUtils
 				switch (allocType)
 				{
 				case 0:
-					if (data_cpu != NULL) delete[] data_cpu;
+					if (data_cpu == NULL) break;
+					if (isPooled) MemoryPool::Release(MEMORYDEVICE_CPU, data_cpu, registeredBytes_CPU);
+					else freeAlignedData(data_cpu);
 					break;
 				case 1:
 #ifndef COMPILE_WITHOUT_CUDA
@@ -251,14 +364,24 @@ namespace ORUtils
 
 				isMetalCompatible = false;
 				isAllocated_CPU = false;
+
+				MemoryRegistry::RegisterFree(tag, MEMORYDEVICE_CPU, registeredBytes_CPU);
+				registeredBytes_CPU = 0;
 			}
 
 			if (isAllocated_CUDA)
 			{
 #ifndef COMPILE_WITHOUT_CUDA
-				if (data_cuda != NULL) ORcudaSafeCall(cudaFree(data_cuda));
+				if (data_cuda != NULL)
+				{
+					if (isPooled) MemoryPool::Release(MEMORYDEVICE_CUDA, data_cuda, registeredBytes_CUDA);
+					else ORcudaSafeCall(cudaFree(data_cuda));
+				}
 #endif
 				isAllocated_CUDA = false;
+
+				MemoryRegistry::RegisterFree(tag, MEMORYDEVICE_CUDA, registeredBytes_CUDA);
+				registeredBytes_CUDA = 0;
 			}
 		}
 
@@ -2,14 +2,46 @@
 
 #pragma once
 
+#include <climits>
 #include <fstream>
 #include <string>
 
 #include "MemoryBlock.h"
+#include "MemoryMappedFile.h"
 
 namespace ORUtils
 {
 
+/**
+ * \brief A read-only memory block on the CPU whose data is a region of a memory-mapped file.
+ *
+ * Pages are read from disk on first access instead of being copied into freshly allocated memory. Writing to the data is not allowed.
+ */
+template <typename T>
+class MappedMemoryBlock : public MemoryBlock<T>
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The mapped file, which owns the data of the block. */
+  MemoryMappedFile *file;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Wraps @p dataSize elements starting @p offset bytes into the mapped @p file, and takes ownership of the file.
+   */
+  MappedMemoryBlock(MemoryMappedFile *file, size_t offset, size_t dataSize)
+  : MemoryBlock<T>(const_cast<T*>(reinterpret_cast<const T*>(file->GetData() + offset)), dataSize), file(file)
+  {}
+
+  //#################### DESTRUCTOR ####################
+public:
+  ~MappedMemoryBlock()
+  {
+    delete file;
+  }
+};
+
 /**
  * \brief This class provides functions for loading and saving memory blocks.
  */
@@ -27,20 +59,33 @@ public:
   template <typename T>
   static void LoadMemoryBlock(const std::string& filename, ORUtils::MemoryBlock<T>& block, MemoryDeviceType memoryDeviceType)
   {
-    int blockSize = ReadBlockSize(filename);
-    if(memoryDeviceType == MEMORYDEVICE_CUDA)
+    std::ifstream fs(filename.c_str(), std::ios::binary);
+    if(!fs) throw std::runtime_error("Could not open " + filename + " for reading");
+
+    int blockSize = ReadBlockSize(fs);
+    if(block.dataSize != (size_t)blockSize)
     {
-      // If we're loading into a block on the GPU, first try and read the data into a temporary block on the CPU.
-      ORUtils::MemoryBlock<T> cpuBlock(block.dataSize, MEMORYDEVICE_CPU);
-      ReadBlockData(filename, cpuBlock, blockSize);
+      throw std::runtime_error("Could not read data into a memory block of the wrong size");
+    }
 
-      // Then copy the data across to the GPU.
-      block.SetFrom(&cpuBlock, ORUtils::MemoryBlock<T>::CPU_TO_CUDA);
+    if(memoryDeviceType == MEMORYDEVICE_CUDA)
+    {
+      // If we're loading into a block on the GPU, stream the data across in chunks, so that no CPU copy of the whole block is needed.
+#ifndef COMPILE_WITHOUT_CUDA
+      ORUtils::MemoryBlock<char> chunk(CHUNK_SIZE, MEMORYDEVICE_CPU, true);
+      char *dst = reinterpret_cast<char*>(block.GetData(MEMORYDEVICE_CUDA));
+      for(size_t offset = 0, bytes = blockSize * sizeof(T); offset < bytes; offset += CHUNK_SIZE)
+      {
+        size_t chunkBytes = bytes - offset < CHUNK_SIZE ? bytes - offset : CHUNK_SIZE;
+        ReadData(fs, chunk.GetData(MEMORYDEVICE_CPU), chunkBytes);
+        ORcudaSafeCall(cudaMemcpy(dst + offset, chunk.GetData(MEMORYDEVICE_CPU), chunkBytes, cudaMemcpyHostToDevice));
+      }
+#endif
     }
     else
     {
       // If we're loading into a block on the CPU, read the data directly into the block.
-      ReadBlockData(filename, block, blockSize);
+      ReadBlockData(fs, block, blockSize);
     }
   }
 
@@ -54,12 +99,55 @@ public:
   template <typename T>
   static ORUtils::MemoryBlock<T> *LoadMemoryBlock(const std::string& filename, ORUtils::MemoryBlock<T> *dummy = NULL)
   {
-    int blockSize = ReadBlockSize(filename);
+    std::ifstream fs(filename.c_str(), std::ios::binary);
+    if(!fs) throw std::runtime_error("Could not open " + filename + " for reading");
+
+    int blockSize = ReadBlockSize(fs);
     ORUtils::MemoryBlock<T> *block = new ORUtils::MemoryBlock<T>(blockSize, MEMORYDEVICE_CPU);
-    ReadBlockData(filename, *block, blockSize);
+    try
+    {
+      ReadBlockData(fs, *block, blockSize);
+    }
+    catch(...)
+    {
+      delete block;
+      throw;
+    }
     return block;
   }
 
+  /**
+   * \brief Maps a file on disk that contains data for a single block, and wraps its data as a read-only memory block on the CPU.
+   *
+   * Nothing is copied: the operating system starts reading the file in the background, and pages that have not arrived yet
+   * are read when they are first accessed. The file stays mapped until the block is deleted. Use this for large blocks that
+   * are only read, e.g. as the source of a copy to the GPU. If the data in the file is not suitably aligned for T, it is
+   * loaded into a newly-allocated block instead.
+   *
+   * \param filename  The name of the file.
+   * \param dummy     An optional dummy parameter that can be used for type inference.
+   * \return          The mapped memory block, whose data must not be written.
+   * \throws std::runtime_error If the file cannot be mapped or is too short.
+   */
+  template <typename T>
+  static const ORUtils::MemoryBlock<T> *MapMemoryBlock(const std::string& filename, const ORUtils::MemoryBlock<T> *dummy = NULL)
+  {
+    const size_t offset = sizeof(int);
+    if(offset % alignof(T) != 0) return LoadMemoryBlock<T>(filename);
+
+    MemoryMappedFile *file = new MemoryMappedFile(filename);
+    int blockSize = -1;
+    if(file->GetSize() >= offset) memcpy(&blockSize, file->GetData(), sizeof(int));
+
+    if(blockSize < 0 || file->GetSize() < offset + blockSize * sizeof(T))
+    {
+      delete file;
+      throw std::runtime_error("Could not read memory block data");
+    }
+
+    return new MappedMemoryBlock<T>(file, offset, blockSize);
+  }
+
   /**
    * \brief Attempts to read the size of a memory block from a file containing data for a single block.
    *
@@ -91,12 +179,18 @@ public:
 
     if(memoryDeviceType == MEMORYDEVICE_CUDA)
     {
-      // If we are saving the memory block from the GPU, first make a CPU copy of it.
-      ORUtils::MemoryBlock<T> cpuBlock(block.dataSize, MEMORYDEVICE_CPU);
-      cpuBlock.SetFrom(&block, ORUtils::MemoryBlock<T>::CUDA_TO_CPU);
-
-      // Then write the CPU copy to disk.
-      WriteBlock(fs, cpuBlock);
+      // If we are saving the memory block from the GPU, stream it to disk in chunks, so that no CPU copy of the whole block is needed.
+      WriteBlockSize(fs, block.dataSize);
+#ifndef COMPILE_WITHOUT_CUDA
+      ORUtils::MemoryBlock<char> chunk(CHUNK_SIZE, MEMORYDEVICE_CPU, true);
+      const char *src = reinterpret_cast<const char*>(block.GetData(MEMORYDEVICE_CUDA));
+      for(size_t offset = 0, bytes = block.dataSize * sizeof(T); offset < bytes; offset += CHUNK_SIZE)
+      {
+        size_t chunkBytes = bytes - offset < CHUNK_SIZE ? bytes - offset : CHUNK_SIZE;
+        ORcudaSafeCall(cudaMemcpy(chunk.GetData(MEMORYDEVICE_CPU), src + offset, chunkBytes, cudaMemcpyDeviceToHost));
+        WriteData(fs, chunk.GetData(MEMORYDEVICE_CPU), chunkBytes);
+      }
+#endif
     }
     else
     {
@@ -105,6 +199,11 @@ public:
     }
   }
 
+  //#################### PRIVATE STATIC CONSTANTS ####################
+private:
+  /** The number of bytes transferred per read or write, and staged on the CPU when streaming to or from the GPU. */
+  static const size_t CHUNK_SIZE = 16 * 1024 * 1024;
+
   //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
 private:
   /**
@@ -121,39 +220,33 @@ private:
   static void ReadBlockData(std::istream& is, ORUtils::MemoryBlock<T>& block, int blockSize)
   {
     // Try and read the block's size.
-    if(block.dataSize != blockSize)
+    if(block.dataSize != (size_t)blockSize)
     {
       throw std::runtime_error("Could not read data into a memory block of the wrong size");
     }
 
     // Try and read the block's data.
-    if(!is.read(reinterpret_cast<char*>(block.GetData(MEMORYDEVICE_CPU)), blockSize * sizeof(T)))
-    {
-      throw std::runtime_error("Could not read memory block data");
-    }
+    ReadData(is, block.GetData(MEMORYDEVICE_CPU), blockSize * sizeof(T));
   }
 
   /**
-   * \brief Attempts to read data into a memory block allocated on the CPU from a file that contains data for a single block.
-   *
-   * The memory block must have the specified size (which should have been obtained by a call to ReadBlockSize).
+   * \brief Attempts to read raw bytes from an input stream, in chunks of at most CHUNK_SIZE bytes.
    *
-   * \param filename            The name of the file.
-   * \param block               The memory block into which to read.
-   * \param blockSize           The required size for the memory block.
+   * \param is                  The input stream.
+   * \param data                The buffer into which to read.
+   * \param bytes               The number of bytes to read.
    * \throws std::runtime_error If the read is unsuccessful.
    */
-  template <typename T>
-  static void ReadBlockData(const std::string& filename, ORUtils::MemoryBlock<T>& block, int blockSize)
+  static void ReadData(std::istream& is, void *data, size_t bytes)
   {
-    std::ifstream fs(filename.c_str(), std::ios::binary);
-    if(!fs) throw std::runtime_error("Could not open " + filename + " for reading");
-
-    // Try and skip the block's size.
-    if(!fs.seekg(sizeof(int))) throw std::runtime_error("Could not skip memory block size");
-
-    // Try and read the block's data.
-    ReadBlockData(fs, block, blockSize);
+    for(size_t offset = 0; offset < bytes; offset += CHUNK_SIZE)
+    {
+      size_t chunkBytes = bytes - offset < CHUNK_SIZE ? bytes - offset : CHUNK_SIZE;
+      if(!is.read(reinterpret_cast<char*>(data) + offset, chunkBytes))
+      {
+        throw std::runtime_error("Could not read memory block data");
+      }
+    }
   }
 
   /**
@@ -185,15 +278,47 @@ private:
   static void WriteBlock(std::ostream& os, const ORUtils::MemoryBlock<T>& block)
   {
     // Try and write the block's size.
-    if(!os.write(reinterpret_cast<const char *>(&block.dataSize), sizeof(block.dataSize)))
+    WriteBlockSize(os, block.dataSize);
+
+    // Try and write the block's data.
+    WriteData(os, block.GetData(MEMORYDEVICE_CPU), block.dataSize * sizeof(T));
+  }
+
+  /**
+   * \brief Attempts to write the size of a memory block to an output stream, as the single integer ReadBlockSize expects.
+   *
+   * \param os                  The output stream.
+   * \param dataSize            The number of elements in the block.
+   * \throws std::runtime_error If the size does not fit into an integer or the write is unsuccessful.
+   */
+  static void WriteBlockSize(std::ostream& os, size_t dataSize)
+  {
+    if(dataSize > (size_t)INT_MAX) throw std::runtime_error("Could not write the size of a memory block with more than INT_MAX elements");
+
+    int blockSize = (int)dataSize;
+    if(!os.write(reinterpret_cast<const char *>(&blockSize), sizeof(int)))
     {
       throw std::runtime_error("Could not write memory block size");
     }
+  }
 
-    // Try and write the block's data.
-    if(!os.write(reinterpret_cast<const char *>(block.GetData(MEMORYDEVICE_CPU)), block.dataSize * sizeof(T)))
+  /**
+   * \brief Attempts to write raw bytes to an output stream, in chunks of at most CHUNK_SIZE bytes.
+   *
+   * \param os                  The output stream.
+   * \param data                The bytes to write.
+   * \param bytes               The number of bytes to write.
+   * \throws std::runtime_error If the write is unsuccessful.
+   */
+  static void WriteData(std::ostream& os, const void *data, size_t bytes)
+  {
+    for(size_t offset = 0; offset < bytes; offset += CHUNK_SIZE)
     {
-      throw std::runtime_error("Could not write memory block data");
+      size_t chunkBytes = bytes - offset < CHUNK_SIZE ? bytes - offset : CHUNK_SIZE;
+      if(!os.write(reinterpret_cast<const char*>(data) + offset, chunkBytes))
+      {
+        throw std::runtime_error("Could not write memory block data");
+      }
     }
   }
 };
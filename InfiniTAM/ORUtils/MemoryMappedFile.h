@@ -0,0 +1,119 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stddef.h>
+
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ORUtils
+{
+	/** \brief
+	    A whole file mapped read-only into the address space of the
+	    process.
+
+	    Pages are read from disk when they are first accessed and
+	    belong to the page cache, so several mappings of the same file
+	    share them and nothing is copied into process memory. Writing
+	    through the mapping is not allowed.
+	*/
+	class MemoryMappedFile
+	{
+	private:
+		const unsigned char *data;
+		size_t size;
+
+#ifdef _WIN32
+		HANDLE file, mapping;
+#endif
+
+	public:
+		/** Maps @p fileName. If @p willNeed is set, the operating system is asked to start reading
+		the whole file in the background right away rather than on the first access of every page.
+		\throws std::runtime_error If the file cannot be opened or mapped.
+		*/
+		explicit MemoryMappedFile(const std::string& fileName, bool willNeed = true)
+		{
+			data = NULL; size = 0;
+
+#ifdef _WIN32
+			mapping = NULL;
+			file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Could not open " + fileName + " for reading");
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize)) { CloseHandle(file); throw std::runtime_error("Could not get the size of " + fileName); }
+			size = (size_t)fileSize.QuadPart;
+
+			if (size > 0)
+			{
+				mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (mapping != NULL) data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				if (data == NULL)
+				{
+					if (mapping != NULL) CloseHandle(mapping);
+					CloseHandle(file);
+					throw std::runtime_error("Could not map " + fileName);
+				}
+			}
+			(void)willNeed;
+#else
+			int fd = open(fileName.c_str(), O_RDONLY);
+			if (fd < 0) throw std::runtime_error("Could not open " + fileName + " for reading");
+
+			struct stat fileStatus;
+			if (fstat(fd, &fileStatus) != 0) { close(fd); throw std::runtime_error("Could not get the size of " + fileName); }
+			size = (size_t)fileStatus.st_size;
+
+			if (size > 0)
+			{
+				void *ptr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (ptr == MAP_FAILED) { close(fd); throw std::runtime_error("Could not map " + fileName); }
+				data = (const unsigned char*)ptr;
+
+				// only hints, reading still works page by page if they are ignored
+				madvise(ptr, size, MADV_SEQUENTIAL);
+				if (willNeed) madvise(ptr, size, MADV_WILLNEED);
+			}
+
+			// the mapping stays valid without the descriptor
+			close(fd);
+#endif
+		}
+
+		~MemoryMappedFile(void)
+		{
+#ifdef _WIN32
+			if (data != NULL) UnmapViewOfFile(data);
+			if (mapping != NULL) CloseHandle(mapping);
+			CloseHandle(file);
+#else
+			if (data != NULL) munmap((void*)data, size);
+#endif
+		}
+
+		/** First byte of the file, NULL if the file is empty. Aligned to at least a page. */
+		const unsigned char *GetData(void) const { return data; }
+
+		/** Size of the file in bytes. */
+		size_t GetSize(void) const { return size; }
+
+	private:
+		// Suppress the default copy constructor and assignment operator
+		MemoryMappedFile(const MemoryMappedFile&);
+		MemoryMappedFile& operator=(const MemoryMappedFile&);
+	};
+}
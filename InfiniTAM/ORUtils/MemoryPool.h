@@ -0,0 +1,205 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stdlib.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#ifndef COMPILE_WITHOUT_CUDA
+#include "CUDADefines.h"
+#endif
+
+#include "MemoryAllocation.h"
+#include "MemoryRegistry.h"
+
+namespace ORUtils
+{
+	/** \brief
+	    Recycles the buffers of memory blocks that are created and
+	    destroyed or resized repeatedly, such as image pyramids of
+	    trackers and scratch images.
+
+	    Buffers are handed out in size classes with at most 25%
+	    slack, so a buffer released by one image can be reused by
+	    another one of similar size. Released buffers are kept
+	    until the capacity of their device is exceeded, in which
+	    case they are freed right away, or until @ref Trim(). They
+	    are registered with the MemoryRegistry as "memory_pool"
+	    while they are idle. Host buffers are aligned like those of
+	    MemoryBlock, see allocateHostData().
+
+	    Memory blocks use the pool when constructed with
+	    pooled = true.
+	*/
+	class MemoryPool
+	{
+	public:
+		struct Statistics
+		{
+			/// Bytes held idle by the pool
+			size_t cachedBytes;
+			/// Number of requests served from the cache and from the system
+			long noHits, noMisses;
+		};
+
+	private:
+		static const int NUM_DEVICES = 2;
+
+		struct Data
+		{
+			std::mutex mutex;
+			size_t capacity;
+			std::map<size_t, std::vector<void*> > buffers[NUM_DEVICES];
+			Statistics statistics[NUM_DEVICES];
+		};
+
+		static Data *CreateData(void)
+		{
+			Data *data = new Data();
+			data->capacity = 256 * 1024 * 1024;
+			for (int d = 0; d < NUM_DEVICES; d++)
+			{
+				data->statistics[d].cachedBytes = 0;
+				data->statistics[d].noHits = data->statistics[d].noMisses = 0;
+			}
+			return data;
+		}
+
+		static Data & GetData(void)
+		{
+			// never destroyed, memory blocks in static objects may still be released during shutdown
+			static Data *data = CreateData();
+			return *data;
+		}
+
+		static void *AllocateBuffer(MemoryDeviceType device, size_t bytes)
+		{
+			void *ptr = NULL;
+			switch (device)
+			{
+			case MEMORYDEVICE_CPU: ptr = allocateHostData(bytes); break;
+			case MEMORYDEVICE_CUDA:
+#ifndef COMPILE_WITHOUT_CUDA
+				ORcudaSafeCall(cudaMalloc(&ptr, bytes));
+#endif
+				break;
+			}
+			return ptr;
+		}
+
+		static void FreeBuffer(MemoryDeviceType device, void *ptr)
+		{
+			switch (device)
+			{
+			case MEMORYDEVICE_CPU: freeAlignedData(ptr); break;
+			case MEMORYDEVICE_CUDA:
+#ifndef COMPILE_WITHOUT_CUDA
+				ORcudaSafeCall(cudaFree(ptr));
+#endif
+				break;
+			}
+		}
+
+		/// frees idle buffers, largest first, until at most @p limit bytes are cached on @p device; the mutex has to be held
+		static void Shrink(Data & data, int device, size_t limit)
+		{
+			std::map<size_t, std::vector<void*> > & buffers = data.buffers[device];
+			while ((data.statistics[device].cachedBytes > limit) && !buffers.empty())
+			{
+				std::map<size_t, std::vector<void*> >::iterator it = buffers.end(); --it;
+				FreeBuffer((MemoryDeviceType)device, it->second.back());
+				it->second.pop_back();
+
+				data.statistics[device].cachedBytes -= it->first;
+				MemoryRegistry::RegisterFree("memory_pool", (MemoryDeviceType)device, it->first);
+				if (it->second.empty()) buffers.erase(it);
+			}
+		}
+
+	public:
+		/// Size of the buffer handed out for a request of @p bytes: multiples of 4 KB up to 64 KB, then quarters of powers of two
+		static size_t GetSizeClass(size_t bytes)
+		{
+			if (bytes <= 65536) return (bytes + 4095) & ~(size_t)4095;
+
+			size_t power = 65536;
+			while (power * 2 < bytes) power *= 2;
+
+			size_t step = power / 4;
+			return ((bytes + step - 1) / step) * step;
+		}
+
+		/// Returns a buffer of at least GetSizeClass(@p bytes) bytes
+		static void *Acquire(MemoryDeviceType device, size_t bytes)
+		{
+			size_t size = GetSizeClass(bytes);
+
+			Data & data = GetData();
+			{
+				std::lock_guard<std::mutex> lock(data.mutex);
+
+				std::map<size_t, std::vector<void*> >::iterator it = data.buffers[device].find(size);
+				if (it != data.buffers[device].end())
+				{
+					void *ptr = it->second.back();
+					it->second.pop_back();
+					if (it->second.empty()) data.buffers[device].erase(it);
+
+					data.statistics[device].cachedBytes -= size;
+					data.statistics[device].noHits++;
+					MemoryRegistry::RegisterFree("memory_pool", device, size);
+					return ptr;
+				}
+
+				data.statistics[device].noMisses++;
+			}
+
+			return AllocateBuffer(device, size);
+		}
+
+		/// Hands a buffer back to the pool; @p bytes is the size it was acquired with
+		static void Release(MemoryDeviceType device, void *ptr, size_t bytes)
+		{
+			if (ptr == NULL) return;
+			size_t size = GetSizeClass(bytes);
+
+			Data & data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+
+			data.buffers[device][size].push_back(ptr);
+			data.statistics[device].cachedBytes += size;
+			MemoryRegistry::RegisterAllocation("memory_pool", device, size);
+
+			Shrink(data, device, data.capacity);
+		}
+
+		/// Maximum number of idle bytes kept per device, 256 MB by default; 0 frees buffers as soon as they are released
+		static void SetCapacity(size_t bytes)
+		{
+			Data & data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+
+			data.capacity = bytes;
+			for (int d = 0; d < NUM_DEVICES; d++) Shrink(data, d, bytes);
+		}
+
+		/// Frees all idle buffers
+		static void Trim(void)
+		{
+			Data & data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+
+			for (int d = 0; d < NUM_DEVICES; d++) Shrink(data, d, 0);
+		}
+
+		static Statistics GetStatistics(MemoryDeviceType device)
+		{
+			Data & data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+			return data.statistics[device];
+		}
+	};
+}
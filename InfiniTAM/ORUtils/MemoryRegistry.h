@@ -0,0 +1,249 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stdio.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef MEMORY_DEVICE_TYPE
+#define MEMORY_DEVICE_TYPE
+enum MemoryDeviceType { MEMORYDEVICE_CPU, MEMORYDEVICE_CUDA };
+#endif
+
+namespace ORUtils
+{
+	/** \brief
+	    Global accounting of allocated memory by subsystem tag and
+	    device.
+
+	    Every MemoryBlock registers its allocations here, under the
+	    tag of the innermost @ref ScopedMemoryTag that was active on
+	    the constructing thread, or "untagged" outside of any scope.
+	    Other long lived allocations, such as the host side of the
+	    global voxel block cache, register themselves explicitly.
+	    Pinned host memory used for CUDA transfers is counted on the
+	    CPU.
+
+	    The registry keeps the current and peak number of bytes of
+	    every tag, so memory requirements of a configuration can be
+	    read off after a run, and allocations that are never
+	    released show up as tags whose usage keeps growing.
+	*/
+	class MemoryRegistry
+	{
+	public:
+		struct Usage
+		{
+			/// Bytes held at the moment and the most held at any time since the start or @ref ResetPeaks()
+			size_t currentBytes, peakBytes;
+			/// Number of allocations held at the moment
+			int noAllocations;
+		};
+
+	private:
+		static const int NUM_DEVICES = 2;
+
+		struct Data
+		{
+			std::mutex mutex;
+			std::map<std::string, Usage> tags[NUM_DEVICES];
+			Usage total[NUM_DEVICES];
+		};
+
+		static Data *CreateData(void)
+		{
+			Data *data = new Data();
+			for (int i = 0; i < NUM_DEVICES; i++) data->total[i] = EmptyUsage();
+			return data;
+		}
+
+		static Data & GetData(void)
+		{
+			// never destroyed, memory blocks in static objects may still be freed during shutdown
+			static Data *data = CreateData();
+			return *data;
+		}
+
+		static const char *& CurrentTag(void)
+		{
+			static thread_local const char *tag = "untagged";
+			return tag;
+		}
+
+		static Usage EmptyUsage(void)
+		{
+			Usage usage;
+			usage.currentBytes = usage.peakBytes = 0;
+			usage.noAllocations = 0;
+			return usage;
+		}
+
+		static void Add(Usage & usage, size_t bytes)
+		{
+			usage.currentBytes += bytes;
+			usage.noAllocations++;
+			if (usage.currentBytes > usage.peakBytes) usage.peakBytes = usage.currentBytes;
+		}
+
+		static void Remove(Usage & usage, size_t bytes)
+		{
+			usage.currentBytes -= (bytes < usage.currentBytes) ? bytes : usage.currentBytes;
+			if (usage.noAllocations > 0) usage.noAllocations--;
+		}
+
+		friend class ScopedMemoryTag;
+
+	public:
+		/// Tag that allocations made by the calling thread are registered under
+		static const char *GetCurrentTag(void) { return CurrentTag(); }
+
+		static void RegisterAllocation(const char *tag, MemoryDeviceType device, size_t bytes)
+		{
+			if (bytes == 0) return;
+
+			Data & data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+
+			std::map<std::string, Usage>::iterator it = data.tags[device].find(tag);
+			if (it == data.tags[device].end()) it = data.tags[device].insert(std::make_pair(std::string(tag), EmptyUsage())).first;
+
+			Add(it->second, bytes);
+			Add(data.total[device], bytes);
+		}
+
+		/// Releases @p bytes registered before with the same @p tag and @p device
+		static void RegisterFree(const char *tag, MemoryDeviceType device, size_t bytes)
+		{
+			if (bytes == 0) return;
+
+			Data & data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+
+			std::map<std::string, Usage>::iterator it = data.tags[device].find(tag);
+			if (it != data.tags[device].end()) Remove(it->second, bytes);
+			Remove(data.total[device], bytes);
+		}
+
+		static Usage GetUsage(const char *tag, MemoryDeviceType device)
+		{
+			Data & data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+
+			std::map<std::string, Usage>::const_iterator it = data.tags[device].find(tag);
+			return (it != data.tags[device].end()) ? it->second : EmptyUsage();
+		}
+
+		/// Usage of all tags together; the peak is that of the sum, which is usually less than the sum of the peaks
+		static Usage GetTotalUsage(MemoryDeviceType device)
+		{
+			Data & data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+			return data.total[device];
+		}
+
+		/// All tags that have been registered on any device so far, sorted by name
+		static std::vector<std::string> GetTags(void)
+		{
+			Data & data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+
+			std::map<std::string, bool> names;
+			for (int d = 0; d < NUM_DEVICES; d++)
+				for (std::map<std::string, Usage>::const_iterator it = data.tags[d].begin(); it != data.tags[d].end(); ++it) names[it->first] = true;
+
+			std::vector<std::string> tags;
+			for (std::map<std::string, bool>::const_iterator it = names.begin(); it != names.end(); ++it) tags.push_back(it->first);
+			return tags;
+		}
+
+		/// Sets the peaks of all tags to their current usage
+		static void ResetPeaks(void)
+		{
+			Data & data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+
+			for (int d = 0; d < NUM_DEVICES; d++)
+			{
+				for (std::map<std::string, Usage>::iterator it = data.tags[d].begin(); it != data.tags[d].end(); ++it)
+					it->second.peakBytes = it->second.currentBytes;
+				data.total[d].peakBytes = data.total[d].currentBytes;
+			}
+		}
+
+		static void PrintUsage(FILE *f = stdout)
+		{
+			static const char *deviceNames[NUM_DEVICES] = { "cpu", "cuda" };
+			std::vector<std::string> tags = GetTags();
+
+			fprintf(f, "%-20s %-6s %12s %12s %8s\n", "memory [MB]", "device", "current", "peak", "blocks");
+			for (int d = 0; d < NUM_DEVICES; d++)
+			{
+				for (size_t i = 0; i < tags.size(); i++)
+				{
+					Usage usage = GetUsage(tags[i].c_str(), (MemoryDeviceType)d);
+					if (usage.peakBytes == 0) continue;
+					fprintf(f, "%-20s %-6s %12.2f %12.2f %8d\n", tags[i].c_str(), deviceNames[d], usage.currentBytes / 1048576.0, usage.peakBytes / 1048576.0, usage.noAllocations);
+				}
+
+				Usage total = GetTotalUsage((MemoryDeviceType)d);
+				if (total.peakBytes == 0) continue;
+				fprintf(f, "%-20s %-6s %12.2f %12.2f %8d\n", "total", deviceNames[d], total.currentBytes / 1048576.0, total.peakBytes / 1048576.0, total.noAllocations);
+			}
+		}
+
+		/// Writes the usage of all tags as comma separated values, in bytes
+		static bool SaveUsage(const char *fileName)
+		{
+			static const char *deviceNames[NUM_DEVICES] = { "cpu", "cuda" };
+			std::vector<std::string> tags = GetTags();
+
+			FILE *f = fopen(fileName, "w");
+			if (f == NULL) return false;
+
+			fprintf(f, "tag,device,current_bytes,peak_bytes,blocks\n");
+			for (int d = 0; d < NUM_DEVICES; d++)
+			{
+				for (size_t i = 0; i < tags.size(); i++)
+				{
+					Usage usage = GetUsage(tags[i].c_str(), (MemoryDeviceType)d);
+					fprintf(f, "%s,%s,%zu,%zu,%d\n", tags[i].c_str(), deviceNames[d], usage.currentBytes, usage.peakBytes, usage.noAllocations);
+				}
+
+				Usage total = GetTotalUsage((MemoryDeviceType)d);
+				fprintf(f, "total,%s,%zu,%zu,%d\n", deviceNames[d], total.currentBytes, total.peakBytes, total.noAllocations);
+			}
+
+			return fclose(f) == 0;
+		}
+	};
+
+	/** \brief
+	    Tags all memory blocks constructed by the current thread
+	    while the object is alive. Scopes nest, the innermost one
+	    wins. @p tag has to stay valid for the lifetime of the
+	    memory blocks, which string literals do.
+	*/
+	class ScopedMemoryTag
+	{
+	private:
+		const char *previousTag;
+
+	public:
+		explicit ScopedMemoryTag(const char *tag)
+		{
+			previousTag = MemoryRegistry::CurrentTag();
+			MemoryRegistry::CurrentTag() = tag;
+		}
+
+		~ScopedMemoryTag(void) { MemoryRegistry::CurrentTag() = previousTag; }
+
+	private:
+		// Suppress the default copy constructor and assignment operator
+		ScopedMemoryTag(const ScopedMemoryTag&);
+		ScopedMemoryTag& operator=(const ScopedMemoryTag&);
+	};
+}
@@ -0,0 +1,168 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "DepthCodec.h"
+
+// Byte stream tokens. Residuals are zigzag coded, i.e. 0, -1, 1, -2, ... map to 0, 1, 2, 3, ...
+static const int TOKEN_MAX_LITERAL = 0xbf;   // 0x00..0xbf: residual stored in the token itself
+static const int TOKEN_SHORT_RUN = 0xc0;     // 0xc0..0xef: 1..48 perfectly predicted pixels
+static const int MAX_SHORT_RUN = 48;
+static const int TOKEN_LONG_RUN = 0xf0;      // followed by (run length - 1) as a base-128 varint
+static const int TOKEN_RESIDUAL16 = 0xfe;    // followed by the residual in 2 bytes, little endian
+static const int TOKEN_RESIDUAL24 = 0xff;    // followed by the residual in 3 bytes, little endian
+
+/// median edge detector from LOCO-I, @p a is the left, @p b the upper and @p c the upper-left neighbour
+static inline int predictDepth(int a, int b, int c)
+{
+	int mn = a < b ? a : b, mx = a < b ? b : a;
+	if (c >= mx) return mn;
+	if (c <= mn) return mx;
+	return a + b - c;
+}
+
+static inline int predictDepth(const short *depth, int x, int y, int width)
+{
+	const short *p = depth + x + y * width;
+
+	if (y == 0) return (x > 0) ? p[-1] : 0;
+	if (x == 0) return p[-width];
+	return predictDepth(p[-1], p[-width], p[-width - 1]);
+}
+
+static inline void writeRun(std::vector<unsigned char> & dest, unsigned int runLength)
+{
+	if (runLength == 0) return;
+
+	if (runLength <= (unsigned int)MAX_SHORT_RUN)
+	{
+		dest.push_back((unsigned char)(TOKEN_SHORT_RUN + runLength - 1));
+		return;
+	}
+
+	dest.push_back((unsigned char)TOKEN_LONG_RUN);
+	unsigned int v = runLength - 1;
+	while (v >= 0x80) { dest.push_back((unsigned char)(0x80 | (v & 0x7f))); v >>= 7; }
+	dest.push_back((unsigned char)v);
+}
+
+void CompressDepthImage(const short *depth, Vector2i imgSize, std::vector<unsigned char> & dest)
+{
+	dest.clear();
+	// most pixels take one byte at most, avoid reallocating in the common case
+	dest.reserve(imgSize.x * imgSize.y + 64);
+
+	unsigned int runLength = 0;
+
+	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
+	{
+		int residual = depth[x + y * imgSize.x] - predictDepth(depth, x, y, imgSize.x);
+		unsigned int zz = (residual >= 0) ? ((unsigned int)residual << 1) : (((unsigned int)(-residual) << 1) - 1);
+
+		if (zz == 0) { runLength++; continue; }
+
+		writeRun(dest, runLength);
+		runLength = 0;
+
+		if (zz <= (unsigned int)TOKEN_MAX_LITERAL) dest.push_back((unsigned char)zz);
+		else if (zz <= 0xffff)
+		{
+			dest.push_back((unsigned char)TOKEN_RESIDUAL16);
+			dest.push_back((unsigned char)(zz & 0xff));
+			dest.push_back((unsigned char)(zz >> 8));
+		}
+		else
+		{
+			dest.push_back((unsigned char)TOKEN_RESIDUAL24);
+			dest.push_back((unsigned char)(zz & 0xff));
+			dest.push_back((unsigned char)((zz >> 8) & 0xff));
+			dest.push_back((unsigned char)(zz >> 16));
+		}
+	}
+
+	writeRun(dest, runLength);
+}
+
+void CompressDepthImage(const ITMShortImage *image, std::vector<unsigned char> & dest)
+{
+	CompressDepthImage(image->GetData(MEMORYDEVICE_CPU), image->noDims, dest);
+}
+
+// reads the next zigzag coded residual, returns false on malformed input
+static inline bool readResidual(const unsigned char * & src, const unsigned char *end, unsigned int & runLength, int & residual)
+{
+	if (runLength > 0) { runLength--; residual = 0; return true; }
+
+	if (src == end) return false;
+	int token = *src++;
+	unsigned int zz = 0;
+
+	if (token <= TOKEN_MAX_LITERAL) zz = (unsigned int)token;
+	else if (token < TOKEN_LONG_RUN) runLength = (unsigned int)(token - TOKEN_SHORT_RUN);
+	else if (token == TOKEN_LONG_RUN)
+	{
+		int shift = 0;
+		while (true)
+		{
+			if (src == end || shift > 28) return false;
+			unsigned char b = *src++;
+			runLength |= (unsigned int)(b & 0x7f) << shift;
+			if ((b & 0x80) == 0) break;
+			shift += 7;
+		}
+	}
+	else if (token == TOKEN_RESIDUAL16)
+	{
+		if (end - src < 2) return false;
+		zz = (unsigned int)src[0] | ((unsigned int)src[1] << 8);
+		src += 2;
+	}
+	else if (token == TOKEN_RESIDUAL24)
+	{
+		if (end - src < 3) return false;
+		zz = (unsigned int)src[0] | ((unsigned int)src[1] << 8) | ((unsigned int)src[2] << 16);
+		src += 3;
+	}
+	else return false;
+
+	residual = (int)(zz >> 1) ^ -(int)(zz & 1);
+	return true;
+}
+
+bool DecompressDepthImage(const unsigned char *src, size_t srcSize, Vector2i imgSize, short *depth)
+{
+	const unsigned char *end = src + srcSize;
+	unsigned int runLength = 0;
+	int residual, width = imgSize.x;
+
+	for (int y = 0; y < imgSize.y; y++)
+	{
+		short *row = depth + y * width;
+
+		// the predictor of the first row and the first column only depends on a single neighbour
+		if (!readResidual(src, end, runLength, residual)) return false;
+		row[0] = (short)(((y > 0) ? row[-width] : 0) + residual);
+
+		if (y == 0)
+		{
+			for (int x = 1; x < width; x++)
+			{
+				if (!readResidual(src, end, runLength, residual)) return false;
+				row[x] = (short)(row[x - 1] + residual);
+			}
+			continue;
+		}
+
+		const short *prev = row - width;
+		for (int x = 1; x < width; x++)
+		{
+			if (!readResidual(src, end, runLength, residual)) return false;
+			row[x] = (short)(predictDepth(row[x - 1], prev[x], prev[x - 1]) + residual);
+		}
+	}
+
+	return (runLength == 0) && (src == end);
+}
+
+bool DecompressDepthImage(const unsigned char *src, size_t srcSize, ITMShortImage *image)
+{
+	return DecompressDepthImage(src, srcSize, image->noDims, image->GetData(MEMORYDEVICE_CPU));
+}
@@ -0,0 +1,27 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "../ITMLib/Utils/ITMLibDefines.h"
+
+/** Lossless compression of 16 bit depth images.
+
+    Every pixel is predicted from its left, upper and upper-left
+    neighbours with the median edge detector of LOCO-I. The
+    prediction residuals are mapped to unsigned values and written
+    as a byte stream: small residuals take one byte, larger ones
+    three or four, and runs of perfectly predicted pixels (such as
+    invalid regions or planar surfaces) are run-length coded. The
+    format is byte aligned and does not need any tables, so decoding
+    is a single pass over the image.
+*/
+void CompressDepthImage(const short *depth, Vector2i imgSize, std::vector<unsigned char> & dest);
+void CompressDepthImage(const ITMShortImage *image, std::vector<unsigned char> & dest);
+
+/// Decodes @p srcSize bytes into @p depth. Returns false if the data does not describe exactly one image of @p imgSize.
+bool DecompressDepthImage(const unsigned char *src, size_t srcSize, Vector2i imgSize, short *depth);
+bool DecompressDepthImage(const unsigned char *src, size_t srcSize, ITMShortImage *image);